@@ -0,0 +1,115 @@
+/*
+ * Replays line of sight queries recorded with '.debug los record', one ray at a
+ * time then one batch per query, and compares the timings and the results.
+ *
+ * Usage: vmaps_losbench <los_queries.bin> [vmaps directory]
+ */
+
+#include "VMapManager2.h"
+#include "MapTree.h"
+#include <G3D/Vector3.h>
+
+#include <chrono>
+#include <set>
+#include <vector>
+
+#define VMAPS_DIR           "/data/client/vmaps"
+
+using namespace VMAP;
+
+struct LoSQuery
+{
+    uint32 mapId;
+    G3D::Vector3 source;
+    std::vector<G3D::Vector3> targets;
+};
+
+bool ReadQueries(const char* filename, std::vector<LoSQuery>& queries)
+{
+    FILE* f = fopen(filename, "rb");
+    if (!f)
+        return false;
+
+    LoSQuery query;
+    uint32 count;
+    while (fread(&query.mapId, sizeof(uint32), 1, f) == 1 && fread(&count, sizeof(uint32), 1, f) == 1)
+    {
+        if (fread(&query.source.x, sizeof(float), 3, f) != 3)
+            break;
+        query.targets.resize(count);
+        uint32 read = 0;
+        while (read < count && fread(&query.targets[read].x, sizeof(float), 3, f) == 3)
+            ++read;
+        if (read != count)
+            break;
+        queries.push_back(query);
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printf("Usage: %s <los_queries.bin> [vmaps directory]\n", argv[0]);
+        return 1;
+    }
+    std::string vmapsDir = argc > 2 ? argv[2] : VMAPS_DIR;
+
+    std::vector<LoSQuery> queries;
+    if (!ReadQueries(argv[1], queries) || queries.empty())
+    {
+        printf("No query read from %s\n", argv[1]);
+        return 1;
+    }
+
+    VMapManager2* manager = new VMapManager2();
+    std::set<uint32> maps;
+    uint64 rays = 0;
+    for (LoSQuery const& query : queries)
+    {
+        maps.insert(query.mapId);
+        rays += query.targets.size();
+    }
+    for (uint32 mapId : maps)
+    {
+        printf("* Loading map %u ...\n", mapId);
+        for (int i = 0; i < 64; ++i)
+            for (int j = 0; j < 64; ++j)
+                manager->loadMap(vmapsDir.c_str(), mapId, i, j);
+    }
+    printf("* %u queries, %llu rays\n", uint32(queries.size()), (unsigned long long)rays);
+
+    typedef std::chrono::steady_clock Clock;
+    std::vector<std::vector<bool> > single(queries.size());
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        LoSQuery const& query = queries[i];
+        for (G3D::Vector3 const& target : query.targets)
+            single[i].push_back(manager->isInLineOfSight(query.mapId, query.source.x, query.source.y, query.source.z, target.x, target.y, target.z));
+    }
+    uint64 singleUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+
+    std::vector<std::vector<bool> > batched(queries.size());
+    start = Clock::now();
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        LoSQuery const& query = queries[i];
+        manager->isInLineOfSight(query.mapId, query.source.x, query.source.y, query.source.z, query.targets, batched[i]);
+    }
+    uint64 batchedUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+
+    uint32 mismatches = 0;
+    for (size_t i = 0; i < queries.size(); ++i)
+        for (size_t j = 0; j < single[i].size(); ++j)
+            if (single[i][j] != batched[i][j])
+                ++mismatches;
+
+    printf("* One ray at a time: %llu us\n", (unsigned long long)singleUs);
+    printf("* Batched:           %llu us\n", (unsigned long long)batchedUs);
+    printf("* Mismatching rays:  %u\n", mismatches);
+    delete manager;
+    return mismatches ? 2 : 0;
+}
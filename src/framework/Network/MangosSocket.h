@@ -11,7 +11,6 @@
 #include <ace/Connector.h>
 #include <ace/Thread_Mutex.h>
 #include <ace/Guard_T.h>
-#include <ace/Unbounded_Queue.h>
 #include <ace/Message_Block.h>
 
 #if !defined (ACE_LACKS_PRAGMA_ONCE)
@@ -19,6 +18,8 @@
 #endif /* ACE_LACKS_PRAGMA_ONCE */
 
 #include "Common.h"
+#include "WorldPacket.h"
+#include <deque>
 
 class ACE_Message_Block;
 class WorldPacket;
@@ -105,7 +106,8 @@ class MangosSocket : protected WorldHandler
         typedef ACE_Guard<LockType> GuardType;
 
         /// Queue for storing packets for which there is no space.
-        typedef ACE_Unbounded_Queue<WorldPacket*> PacketQueueT;
+        /// Queued packets may be shared with other sockets, they are never modified.
+        typedef std::deque<SharedWorldPacket> PacketQueueT;
 
         /// Check if socket is closed.
         bool IsClosed() const { return closing_; }
@@ -121,6 +123,10 @@ class MangosSocket : protected WorldHandler
         /// @return -1 of failure
         int SendPacket (const WorldPacket& pct);
 
+        /// Same, but the packet is only referenced if it has to wait in the
+        /// queue: a packet broadcast to many sockets is never copied for each.
+        int SendPacket (const SharedWorldPacket& pct);
+
         /// Add reference to this object.
         long AddReference() { return static_cast<long>(add_reference()); }
 
@@ -54,9 +54,7 @@ MangosSocket<SessionType, SocketName, Crypt>::~MangosSocket(void)
 
     peer().close();
 
-    WorldPacket* pct;
-    while (m_PacketQueue.dequeue_head(pct) == 0)
-        delete pct;
+    m_PacketQueue.clear();
 }
 
 template <typename SessionType, typename SocketName, typename Crypt>
@@ -89,23 +87,28 @@ int MangosSocket<SessionType, SocketName, Crypt>::SendPacket(const WorldPacket&
 
     if (((SocketName*)this)->iSendPacket(pct) == -1)
     {
-        WorldPacket* npct;
-
-        ACE_NEW_RETURN(npct, WorldPacket(pct), -1);
-
         // NOTE maybe check of the size of the queue can be good ?
         // to make it bounded instead of unbounded
-        if (m_PacketQueue.enqueue_tail(npct) == -1)
-        {
-            delete npct;
-            sLog.outError("MangosSocket<SessionType, SocketName, Crypt>::SendPacket: m_PacketQueue.enqueue_tail failed");
-            return -1;
-        }
+        m_PacketQueue.push_back(std::make_shared<WorldPacket>(pct));
     }
 
     return 0;
 }
 
+template <typename SessionType, typename SocketName, typename Crypt>
+int MangosSocket<SessionType, SocketName, Crypt>::SendPacket(const SharedWorldPacket& pct)
+{
+    ACE_GUARD_RETURN(LockType, Guard, m_OutBufferLock, -1);
+
+    if (closing_)
+        return -1;
+
+    if (((SocketName*)this)->iSendPacket(*pct) == -1)
+        m_PacketQueue.push_back(pct);
+
+    return 0;
+}
+
 template <typename SessionType, typename SocketName, typename Crypt>
 int MangosSocket<SessionType, SocketName, Crypt>::open(void *a)
 {
@@ -514,27 +517,15 @@ int MangosSocket<SessionType, SocketName, Crypt>::iSendPacket(const WorldPacket&
 template <typename SessionType, typename SocketName, typename Crypt>
 bool MangosSocket<SessionType, SocketName, Crypt>::iFlushPacketQueue()
 {
-    WorldPacket *pct;
     bool haveone = false;
 
-    while (m_PacketQueue.dequeue_head(pct) == 0)
+    while (!m_PacketQueue.empty())
     {
-        if (((SocketName*)this)->iSendPacket(*pct) == -1)
-        {
-            if (m_PacketQueue.enqueue_head(pct) == -1)
-            {
-                delete pct;
-                sLog.outError("MangosSocket<SessionType, SocketName, Crypt>::iFlushPacketQueue m_PacketQueue->enqueue_head");
-                return false;
-            }
-
+        if (((SocketName*)this)->iSendPacket(*m_PacketQueue.front()) == -1)
             break;
-        }
-        else
-        {
-            haveone = true;
-            delete pct;
-        }
+
+        haveone = true;
+        m_PacketQueue.pop_front();
     }
 
     return haveone;
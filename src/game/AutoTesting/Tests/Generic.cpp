@@ -128,9 +128,9 @@ public:
         filter.setIncludeFlags(0xF);
         filter.setExcludeFlags(NAV_STEEP_SLOPES);
         MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
-        const dtNavMeshQuery* navMeshQuery = mmap->GetNavMeshQuery(map);
+        MMAP::NavMeshQueryHandle navMeshQuery = mmap->GetNavMeshQuery(map);
         TEST_ASSERT(navMeshQuery);
-        if (!PathInfo::FindWalkPoly(navMeshQuery, points, filter, closestPoint))
+        if (!PathInfo::FindWalkPoly(navMeshQuery.get(), points, filter, closestPoint))
             Fail("Unable to find walk poly [%.2f %.2f %.2f map:%u]", x, y, z, map);
         return closestPoint[1];
     }
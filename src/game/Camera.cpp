@@ -25,8 +25,10 @@
 #include "Log.h"
 #include "Errors.h"
 #include "Player.h"
+#include "World.h"
 
-Camera::Camera(Player* pl) : m_owner(*pl), m_source(pl)
+Camera::Camera(Player* pl) : m_owner(*pl), m_source(pl),
+    m_lastVisibilityX(0.0f), m_lastVisibilityY(0.0f), m_lastVisibilityDistance(0.0f), m_lastFullVisibilityUpdate(0)
 {
     m_source->GetViewPoint().Attach(this);
 }
@@ -135,29 +137,58 @@ void Camera::UpdateVisibilityOf(WorldObject* target)
 }
 
 template<class T>
-void Camera::UpdateVisibilityOf(T * target, UpdateData &data, std::set<WorldObject*>& vis)
+void Camera::UpdateVisibilityOf(T * target, UpdateData &data, std::vector<WorldObject*>& vis)
 {
     m_owner.template UpdateVisibilityOf<T>(m_source, target, data, vis);
 }
 
-template void Camera::UpdateVisibilityOf(Player*        , UpdateData& , std::set<WorldObject*>&);
-template void Camera::UpdateVisibilityOf(Creature*      , UpdateData& , std::set<WorldObject*>&);
-template void Camera::UpdateVisibilityOf(Corpse*        , UpdateData& , std::set<WorldObject*>&);
-template void Camera::UpdateVisibilityOf(GameObject*    , UpdateData& , std::set<WorldObject*>&);
-template void Camera::UpdateVisibilityOf(DynamicObject* , UpdateData& , std::set<WorldObject*>&);
+template void Camera::UpdateVisibilityOf(Player*        , UpdateData& , std::vector<WorldObject*>&);
+template void Camera::UpdateVisibilityOf(Creature*      , UpdateData& , std::vector<WorldObject*>&);
+template void Camera::UpdateVisibilityOf(Corpse*        , UpdateData& , std::vector<WorldObject*>&);
+template void Camera::UpdateVisibilityOf(GameObject*    , UpdateData& , std::vector<WorldObject*>&);
+template void Camera::UpdateVisibilityOf(DynamicObject* , UpdateData& , std::vector<WorldObject*>&);
 
 void Camera::UpdateVisibilityForOwner()
+{
+    DoUpdateVisibilityForOwner(false);
+}
+
+void Camera::UpdateVisibilityForOwnerAfterRelocation()
+{
+    DoUpdateVisibilityForOwner(true);
+}
+
+void Camera::DoUpdateVisibilityForOwner(bool incremental)
 {
     // Temporary hackfix if the camera has no map assigned to it
     // TODO: Find out why/how this happens
-    if (!m_source->FindMap())
+    Map* map = m_source->FindMap();
+    if (!map)
         return;
 
+    float const visibilityDistance = map->GetVisibilityDistance();
+    uint32 const now = WorldTimer::getMSTime();
+
+    // A full update is still done from time to time, objects may change their state without notifying the cameras
+    uint32 const fullUpdateDelay = sWorld.getConfig(CONFIG_UINT32_VISIBILITY_FULL_UPDATE_DELAY);
+    if (incremental && (!fullUpdateDelay || WorldTimer::getMSTimeDiff(m_lastFullVisibilityUpdate, now) >= fullUpdateDelay ||
+        visibilityDistance != m_lastVisibilityDistance || m_owner.IsTaxiFlying()))
+        incremental = false;
+
     GetOwner()->m_visibleGUIDs_lock.acquire_read();
     MaNGOS::VisibleNotifier notifier(*this); // Will copy m_clientGUIDs
     GetOwner()->m_visibleGUIDs_lock.release();
-    Cell::VisitAllObjects(m_source, notifier, m_source->GetMap()->GetVisibilityDistance());
+    if (incremental)
+        notifier.SetIncremental(m_lastVisibilityX, m_lastVisibilityY, visibilityDistance);
+    Cell::VisitAllObjects(m_source, notifier, visibilityDistance);
     notifier.Notify();
+    map->AddVisibilityStats(notifier.i_evaluated, notifier.i_skipped);
+
+    m_lastVisibilityX = m_source->GetPositionX();
+    m_lastVisibilityY = m_source->GetPositionY();
+    m_lastVisibilityDistance = visibilityDistance;
+    if (!incremental)
+        m_lastFullVisibilityUpdate = now;
 }
 
 //////////////////
@@ -52,13 +52,15 @@ class MANGOS_DLL_SPEC Camera
         void ResetView(bool update_far_sight_field = true);
 
         template<class T>
-        void UpdateVisibilityOf(T * obj, UpdateData &d, std::set<WorldObject*>& vis);
+        void UpdateVisibilityOf(T * obj, UpdateData &d, std::vector<WorldObject*>& vis);
         void UpdateVisibilityOf(WorldObject* obj);
 
         void ReceivePacket(WorldPacket *data);
 
         // updates visibility of worldobjects around viewpoint for camera's owner
         void UpdateVisibilityForOwner();
+        // same after a viewpoint move, evaluates only the objects whose distance may have crossed the visibility range
+        void UpdateVisibilityForOwnerAfterRelocation();
 
     private:
         // called when viewpoint changes visibility state
@@ -70,7 +72,14 @@ class MANGOS_DLL_SPEC Camera
         Player& m_owner;
         WorldObject* m_source;
 
+        // viewpoint position and visibility distance at the last visibility update
+        float m_lastVisibilityX;
+        float m_lastVisibilityY;
+        float m_lastVisibilityDistance;
+        uint32 m_lastFullVisibilityUpdate;
+
         void UpdateForCurrentViewPoint();
+        void DoUpdateVisibilityForOwner(bool incremental);
 
     public:
         GridReference<Camera>& GetGridRef() { return m_gridRef; }
@@ -139,6 +148,11 @@ public:
     {
         CameraCall(&Camera::UpdateVisibilityForOwner);
     }
+
+    void Call_UpdateVisibilityForOwnerAfterRelocation()
+    {
+        CameraCall(&Camera::UpdateVisibilityForOwnerAfterRelocation);
+    }
 };
 
 #endif
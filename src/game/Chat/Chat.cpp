@@ -209,6 +209,8 @@ ChatCommand * ChatHandler::getCommandTable()
     {
         { NODE, "check",          SEC_ADMINISTRATOR,  false, &ChatHandler::HandleDebugLoSCommand,                 "", nullptr },
         { NODE, "allow",          SEC_ADMINISTRATOR,  false, &ChatHandler::HandleDebugLoSAllowCommand,            "", nullptr },
+        { NODE, "record",         SEC_ADMINISTRATOR,  false, &ChatHandler::HandleDebugLoSRecordCommand,           "", nullptr },
+        { NODE, "cache",          SEC_ADMINISTRATOR,  false, &ChatHandler::HandleDebugLoSCacheCommand,            "", nullptr },
         { MSTR, nullptr,       0,                  false, nullptr,                                                "", nullptr }
     };
 
@@ -270,6 +272,9 @@ ChatCommand * ChatHandler::getCommandTable()
         { NODE, "movemotion",     SEC_ADMINISTRATOR,  false, &ChatHandler::HandleDebugMoveCommand,                "", nullptr },
         { NODE, "factionchange_items", SEC_ADMINISTRATOR, true, &ChatHandler::HandleFactionChangeItemsCommand,    "", nullptr },
         { NODE, "loottable",      SEC_ADMINISTRATOR,  true,  &ChatHandler::HandleDebugLootTableCommand,           "", nullptr },
+        { NODE, "queuebench",     SEC_ADMINISTRATOR,  true,  &ChatHandler::HandleDebugQueueBenchCommand,          "", nullptr },
+        { NODE, "compressbench",  SEC_ADMINISTRATOR,  false, &ChatHandler::HandleDebugCompressBenchCommand,       "", nullptr },
+        { NODE, "storagebench",   SEC_ADMINISTRATOR,  true,  &ChatHandler::HandleDebugStorageBenchCommand,        "", nullptr },
         { MSTR, nullptr,       0,                  false, nullptr,                                                "", nullptr }
     };
 
@@ -880,6 +885,7 @@ ChatCommand * ChatHandler::getCommandTable()
         { NODE, "loc",            SEC_GAMEMASTER,     false, &ChatHandler::HandleMmapLocCommand,             "", nullptr },
         { NODE, "loadedtiles",    SEC_GAMEMASTER,     false, &ChatHandler::HandleMmapLoadedTilesCommand,     "", nullptr },
         { NODE, "stats",          SEC_GAMEMASTER,     false, &ChatHandler::HandleMmapStatsCommand,           "", nullptr },
+        { NODE, "pathqueue",      SEC_GAMEMASTER,     false, &ChatHandler::HandleMmapPathQueueCommand,       "", nullptr },
         { NODE, "testarea",       SEC_GAMEMASTER,     false, &ChatHandler::HandleMmapTestArea,               "", nullptr },
         { NODE, "connect",        SEC_ADMINISTRATOR,  false, &ChatHandler::HandleMmapConnection,             "", nullptr },
         { NODE, "reload",         SEC_ADMINISTRATOR,  false, &ChatHandler::HandleMmapLoad,                   "", nullptr },
@@ -1100,6 +1106,10 @@ ChatCommand * ChatHandler::getCommandTable()
         { MSTR, "pinfo",          SEC_GAMEMASTER,     false, &ChatHandler::HandlePInfoCommand,               "", nullptr },
         { MSTR, "groupinfo",      SEC_GAMEMASTER,     true,  &ChatHandler::HandleGroupInfoCommand,           "", nullptr },
         { MSTR, "pbcast",         SEC_ADMINISTRATOR,  true,  &ChatHandler::HandlePBCastStatsCommand,         "", pbcastCommandTable },
+        { MSTR, "threadpool",     SEC_ADMINISTRATOR,  true,  &ChatHandler::HandleThreadPoolStatsCommand,     "", nullptr },
+        { MSTR, "savestats",      SEC_ADMINISTRATOR,  true,  &ChatHandler::HandlePlayerSaveStatsCommand,     "", nullptr },
+        { MSTR, "dbqueue",        SEC_ADMINISTRATOR,  true,  &ChatHandler::HandleDatabaseQueueStatsCommand,  "", nullptr },
+        { MSTR, "loginstats",     SEC_ADMINISTRATOR,  true,  &ChatHandler::HandlePlayerLoginStatsCommand,    "", nullptr },
         { NODE, "addons",         SEC_ADMINISTRATOR,  false, &ChatHandler::HandleListAddonsCommand,          "", nullptr },
         { NODE, "respawn",        SEC_ADMINISTRATOR,  false, &ChatHandler::HandleRespawnCommand,             "", nullptr },
         { NODE, "send",           SEC_MODERATOR,      true, nullptr,                                           "", sendCommandTable     },
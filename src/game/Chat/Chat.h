@@ -184,6 +184,9 @@ class MANGOS_DLL_SPEC ChatHandler
         bool HandleDebugExp(char* );
         bool HandleVideoTurn(char* );
         bool HandleDebugLootTableCommand(char*);
+        bool HandleDebugQueueBenchCommand(char*);
+        bool HandleDebugCompressBenchCommand(char*);
+        bool HandleDebugStorageBenchCommand(char*);
         bool HandleDebugItemEnchantCommand(int lootid, unsigned int simCount);
         bool HandleServiceDeleteCharacters(char* args);
 
@@ -216,6 +219,7 @@ class MANGOS_DLL_SPEC ChatHandler
         bool HandleMmapLocCommand(char* args);
         bool HandleMmapLoadedTilesCommand(char* args);
         bool HandleMmapStatsCommand(char* args);
+        bool HandleMmapPathQueueCommand(char* args);
 
         bool HandleDebugMoveToCommand(char* args);
         // AHBot
@@ -285,6 +289,8 @@ class MANGOS_DLL_SPEC ChatHandler
         // Debug
         bool HandleDebugLoSCommand(char* args);
         bool HandleDebugLoSAllowCommand(char* args);
+        bool HandleDebugLoSRecordCommand(char* args);
+        bool HandleDebugLoSCacheCommand(char* args);
         bool HandleDebugAssertFalseCommand(char* args);
         bool HandleDebugPvPCreditCommand(char* args);
         bool HandleDebugMonsterChatCommand(char *args);
@@ -498,6 +504,10 @@ class MANGOS_DLL_SPEC ChatHandler
         bool HandleInstanceBindingMode(char* args);
         bool HandlePBCastStatsCommand(char* args);
         bool HandlePBCastSetThreadsCommand(char* args);
+        bool HandleThreadPoolStatsCommand(char* args);
+        bool HandlePlayerSaveStatsCommand(char* args);
+        bool HandleDatabaseQueueStatsCommand(char* args);
+        bool HandlePlayerLoginStatsCommand(char* args);
 
         bool HandleLearnCommand(char* args);
         bool HandleLearnAllCommand(char* args);
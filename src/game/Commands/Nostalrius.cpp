@@ -1,5 +1,8 @@
 #include <string.h>
 #include <map>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 #include "Common.h"
 #include "Database/DatabaseEnv.h"
@@ -40,6 +43,8 @@
 #include "BattleGround.h"
 #include "BattleGroundMgr.h"
 #include "SpellModMgr.h"
+#include "UpdateData.h"
+#include <zlib/zlib.h>
 
 // MMAPS
 #include "MoveMap.h"                                        // for mmap manager
@@ -53,6 +58,7 @@
 // VMAPS
 #include "VMapFactory.h"
 #include "ModelInstance.h"
+#include "Database/SQLStorages.h"
 
 #define MAX_SPELL_EFFECTS 3
 
@@ -651,6 +657,54 @@ bool ChatHandler::HandleDebugLoSAllowCommand(char* args)
     return true;
 }
 
+// Records the next line of sight queries, to replay them with contrib/vmap_reader vmaps_losbench
+bool ChatHandler::HandleDebugLoSRecordCommand(char* args)
+{
+    VMAP::IVMapManager* vmap = VMAP::VMapFactory::createOrGetVMapManager();
+    if (ExtractLiteralArg(&args, "off"))
+    {
+        vmap->stopLoSRecording();
+        SendSysMessage("Line of sight recording stopped.");
+        return true;
+    }
+
+    uint32 queries = 100000;
+    if (*args && !ExtractUInt32(&args, queries))
+        return false;
+
+    if (!vmap->startLoSRecording("los_queries.bin", queries))
+    {
+        SendSysMessage("Unable to open los_queries.bin.");
+        SetSentErrorMessage(true);
+        return false;
+    }
+    PSendSysMessage("Recording the next %u line of sight queries to los_queries.bin.", queries);
+    return true;
+}
+
+// Line of sight cache of the current map, '.debug los cache reset' clears its counters
+bool ChatHandler::HandleDebugLoSCacheCommand(char* args)
+{
+    Map* map = m_session->GetPlayer()->GetMap();
+    LineOfSightCache& cache = map->GetLoSCache();
+    if (ExtractLiteralArg(&args, "reset"))
+    {
+        cache.ResetStats();
+        SendSysMessage("Line of sight cache stats reset.");
+        return true;
+    }
+
+    if (!sWorld.getConfig(CONFIG_UINT32_LOS_CACHE_LIFETIME))
+        SendSysMessage("Line of sight cache disabled (vmap.LoSCache.Lifetime = 0)");
+
+    LineOfSightCacheStats stats = cache.GetStats();
+    uint64 lookups = stats.hits + stats.misses + stats.invalidated + stats.expired;
+    PSendSysMessage("Map %u: %u results cached", map->GetId(), stats.entries);
+    PSendSysMessage("Hits " UI64FMTD " (%.1f%%), misses " UI64FMTD ", invalidated " UI64FMTD ", expired " UI64FMTD,
+                    stats.hits, lookups ? 100.0f * stats.hits / lookups : 0.0f, stats.misses, stats.invalidated, stats.expired);
+    return true;
+}
+
 bool ChatHandler::HandleDebugAssertFalseCommand(char*)
 {
     ASSERT(false);
@@ -1799,13 +1853,13 @@ bool ChatHandler::HandleMmapLocCommand(char* /*args*/)
     {
         transport->CalculatePassengerOffset(location[2], location[0], location[1]);
         PSendSysMessage("* On transport navmesh 'go%03u.mmap' offsets [%f %f %f]", transport->GetDisplayId(), location[2], location[0], location[1]);
-        const dtNavMeshQuery* navmeshquery = MMAP::MMapFactory::createOrGetMMapManager()->GetModelNavMeshQuery(transport->GetDisplayId());
+        MMAP::NavMeshQueryHandle navmeshquery = MMAP::MMapFactory::createOrGetMMapManager()->GetModelNavMeshQuery(transport->GetDisplayId());
         if (!navmeshquery)
         {
             SendSysMessage("No navmeshloaded");
             return true;
         }
-        dtPolyRef polyRef = PathInfo::FindWalkPoly(navmeshquery, location, filter, closestPoint);
+        dtPolyRef polyRef = PathInfo::FindWalkPoly(navmeshquery.get(), location, filter, closestPoint);
         if (!polyRef)
         {
             SendSysMessage("No polygon found");
@@ -1830,7 +1884,7 @@ bool ChatHandler::HandleMmapLocCommand(char* /*args*/)
 
     // calculate navmesh tile location
     const dtNavMesh* navmesh = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMesh(unit->GetMapId());
-    const dtNavMeshQuery* navmeshquery = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMeshQuery(unit->GetMapId());
+    MMAP::NavMeshQueryHandle navmeshquery = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMeshQuery(unit->GetMapId());
     if (!navmesh || !navmeshquery)
     {
         PSendSysMessage("NavMesh not loaded for current map.");
@@ -1844,7 +1898,7 @@ bool ChatHandler::HandleMmapLocCommand(char* /*args*/)
     PSendSysMessage("Calc   [%02i,%02i]", tilex, tiley);
 
     // navmesh poly -> navmesh tile location
-    dtPolyRef polyRef = PathInfo::FindWalkPoly(navmeshquery, location, filter, closestPoint);
+    dtPolyRef polyRef = PathInfo::FindWalkPoly(navmeshquery.get(), location, filter, closestPoint);
 
     if (polyRef == INVALID_POLYREF)
         PSendSysMessage("Dt     [??,??] (invalid poly, probably no tile loaded)");
@@ -1874,7 +1928,7 @@ bool ChatHandler::HandleMmapLoadedTilesCommand(char* /*args*/)
     uint32 mapid = m_session->GetPlayer()->GetMapId();
 
     const dtNavMesh* navmesh = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMesh(mapid);
-    const dtNavMeshQuery* navmeshquery = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMeshQuery(mapid);
+    MMAP::NavMeshQueryHandle navmeshquery = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMeshQuery(mapid);
     if (!navmesh || !navmeshquery)
     {
         PSendSysMessage("NavMesh not loaded for current map.");
@@ -1895,7 +1949,7 @@ bool ChatHandler::HandleMmapLoadedTilesCommand(char* /*args*/)
     return true;
 }
 
-bool ChatHandler::HandleMmapStatsCommand(char* /*args*/)
+bool ChatHandler::HandleMmapStatsCommand(char* args)
 {
     PSendSysMessage("mmap stats:");
     PSendSysMessage("  global mmap pathfinding is %sabled", sWorld.getConfig(CONFIG_BOOL_MMAP_ENABLED) ? "en" : "dis");
@@ -1903,10 +1957,26 @@ bool ChatHandler::HandleMmapStatsCommand(char* /*args*/)
     MMAP::MMapManager *manager = MMAP::MMapFactory::createOrGetMMapManager();
     PSendSysMessage(" %u maps loaded with %u tiles overall", manager->getLoadedMapsCount(), manager->getLoadedTilesCount());
 
+    MMAP::NavMeshQueryPoolStats pools = manager->GetQueryPoolsStats();
+    PSendSysMessage(" %u navmesh queries created, %u in use | %u checkouts, %u waited (avg %uus, max %uus)",
+        pools.created, pools.inUse, uint32(pools.checkouts), uint32(pools.waits),
+        uint32(pools.waits ? pools.waitUs / pools.waits : 0), uint32(pools.maxWaitUs));
+    MMAP::NavMeshQueryPoolStats pool;
+    if (manager->GetQueryPoolStats(m_session->GetPlayer()->GetMapId(), pool))
+        PSendSysMessage(" current map: %u/%u queries created, %u in use, %u waited",
+            pool.created, pool.maxQueries, pool.inUse, uint32(pool.waits));
+
+    PathCorridorCacheStats cache = sPathCorridorCache.GetStats();
+    uint64 lookups = cache.hits + cache.misses;
+    PSendSysMessage(" path cache: %u/%u corridors | %u hits, %u misses (%.1f%% hit rate)",
+        cache.entries, cache.capacity, uint32(cache.hits), uint32(cache.misses), lookups ? 100.0f * cache.hits / lookups : 0.0f);
+    if (args && strcmp(args, "reset") == 0)
+        sPathCorridorCache.ResetStats();
+
     const dtNavMesh* navmesh = manager->GetNavMesh(m_session->GetPlayer()->GetMapId());
     if (Transport* transport = m_session->GetPlayer()->GetTransport())
     {
-        const dtNavMeshQuery* navmeshquery = MMAP::MMapFactory::createOrGetMMapManager()->GetModelNavMeshQuery(transport->GetDisplayId());
+        MMAP::NavMeshQueryHandle navmeshquery = MMAP::MMapFactory::createOrGetMMapManager()->GetModelNavMeshQuery(transport->GetDisplayId());
         navmesh = navmeshquery ? navmeshquery->getAttachedNavMesh() : NULL;
     }
 
@@ -1948,6 +2018,26 @@ bool ChatHandler::HandleMmapStatsCommand(char* /*args*/)
     return true;
 }
 
+bool ChatHandler::HandleMmapPathQueueCommand(char* args)
+{
+    Map* map = m_session->GetPlayer()->GetMap();
+    PathRequestQueue& queue = map->GetPathRequests();
+    if (!sWorld.getConfig(CONFIG_UINT32_PATH_REQUESTS_THREADS))
+        PSendSysMessage("Path requests are not batched (MapUpdate.PathRequests.Threads = 0)");
+
+    PathRequestStats const& last = queue.GetLastBatchStats();
+    PathRequestStats const& total = queue.GetTotalStats();
+    PSendSysMessage("Path queue of map %u:", map->GetId());
+    PSendSysMessage(" last update: %u requests, %u searches, %u shared, %u expired | %uus (longest search %uus)",
+        last.requests, last.searches, last.shared, last.expired, uint32(last.batchUs), uint32(last.maxSearchUs));
+    PSendSysMessage(" total: %u requests, %u searches, %u shared, %u expired | %ums (longest search %uus)",
+        total.requests, total.searches, total.shared, total.expired, uint32(total.batchUs / 1000), uint32(total.maxSearchUs));
+
+    if (args && strcmp(args, "reset") == 0)
+        queue.ResetStats();
+    return true;
+}
+
 bool ChatHandler::HandleMmapUnload(char* args)
 {
     PSendSysMessage("* Unload map %u", m_session->GetPlayer()->GetMapId());
@@ -2662,7 +2752,7 @@ bool ChatHandler::HandleReloadCharacterPetCommand(char *args)
         return false;
     if (!petId)
         return false;
-    sCharacterDatabaseCache.LoadAll(petId);
+    sCharacterDatabaseCache.ReloadCharacterPet(petId);
     PSendSysMessage(">> Pet #%u reloaded from database.", petId);
     return true;
 }
@@ -2678,15 +2768,13 @@ bool ChatHandler::HandlePetListCommand(char* args)
         SetSentErrorMessage(true);
         return false;
     }
-    CharPetMap const& petsMap = sCharacterDatabaseCache.GetCharPetsMap();
-    CharPetMap::const_iterator charPets = petsMap.find(playerGuid.GetCounter());
+    CharPetVector const pets = sCharacterDatabaseCache.LoadCharacterPets(playerGuid.GetCounter());
     uint32 count = 0;
-    if (charPets != petsMap.end())
-        for (CharPetVector::const_iterator it = charPets->second.begin(); it != charPets->second.end(); ++it)
-        {
-            PSendSysMessage("#%u: \"%s\" (%s)", (*it)->id, (*it)->name.c_str(), (*it)->slot == PET_SAVE_AS_CURRENT ? "Current pet" : "In stable");
-            ++count;
-        }
+    for (CharPetVector::const_iterator it = pets.begin(); it != pets.end(); ++it)
+    {
+        PSendSysMessage("#%u: \"%s\" (%s)", (*it)->id, (*it)->name.c_str(), (*it)->slot == PET_SAVE_AS_CURRENT ? "Current pet" : "In stable");
+        ++count;
+    }
     PSendSysMessage("Found %u pets for character %s (#%u).", count, charName.c_str(), playerGuid.GetCounter());
     return true;
 }
@@ -2720,16 +2808,10 @@ bool ChatHandler::HandlePetRenameCommand(char* args)
     auto pet_name = fields[1].GetString();
 
     PSendSysMessage("Pet #%u (\"%s\", owner #%u) renamed to \"%s\"", petId, pet_name, owner_guid, newName.c_str());
+    sCharacterDatabaseCache.SetCharacterPetName(petId, newName);
     CharacterDatabase.escape_string(newName);
     CharacterDatabase.PExecute("UPDATE character_pet SET name = \"%s\" WHERE id = %u", newName.c_str(), petId);
 
-    CharacterPetCache* petData = sCharacterDatabaseCache.GetCharacterPetById(petId);
-
-    if (petData)
-    {
-        petData->name = newName;
-    }
-
     return true;
 }
 
@@ -2738,7 +2820,7 @@ bool ChatHandler::HandlePetDeleteCommand(char* args)
     uint32 petId;
     if (!ExtractUInt32(&args, petId))
         return false;
-    CharacterPetCache* petData = sCharacterDatabaseCache.GetCharacterPetById(petId);
+    CharacterPetCachePtr petData = sCharacterDatabaseCache.GetCharacterPetById(petId);
     if (!petData)
     {
         PSendSysMessage("Pet #%u not found", petId);
@@ -2838,7 +2920,7 @@ bool ChatHandler::HandleInstancePerfInfosCommand(char* args)
         return false;
     map->PrintInfos(*this);
     uint32 playersInClient = 0, gobjsInClient = 0, unitsInClient = 0, corpsesInClient = 0;
-    for (ObjectGuidSet::const_iterator it = player->m_visibleGUIDs.begin(); it != player->m_visibleGUIDs.end(); ++it)
+    for (ObjectGuidSortedSet::const_iterator it = player->m_visibleGUIDs.begin(); it != player->m_visibleGUIDs.end(); ++it)
     {
         switch (it->GetHigh())
         {
@@ -2852,6 +2934,226 @@ bool ChatHandler::HandleInstancePerfInfosCommand(char* args)
     return true;
 }
 
+bool ChatHandler::HandleThreadPoolStatsCommand(char* args)
+{
+    static char const* phaseNames[TASK_PHASE_COUNT] =
+    {
+        "AsyncTasks", "Instances", "Continents", "Cells", "Motion", "Paths", "ObjUpdates", "Visibility"
+    };
+
+    bool reset = args && strcmp(args, "reset") == 0;
+    ThreadPool* pool = sWorld.GetThreadPool();
+    PSendSysMessage("ThreadPool: %u threads, %u tasks queued.", uint32(pool->GetThreadsCount()), uint32(pool->GetQueuedCount()));
+    for (int i = 0; i < TASK_PHASE_COUNT; ++i)
+    {
+        TaskPhaseStats* stats = sWorld.GetTaskPhaseStats(TaskPoolPhase(i));
+        uint64 tasks = stats->tasks;
+        uint64 avgQueue = tasks ? stats->queueTimeUs / tasks : 0;
+        uint64 avgExec = tasks ? stats->execTimeUs / tasks : 0;
+        PSendSysMessage("%-10s: %8u tasks | queue avg %6uus max %7uus | exec avg %6uus max %7uus",
+            phaseNames[i], uint32(tasks), uint32(avgQueue), uint32(stats->maxQueueTimeUs),
+            uint32(avgExec), uint32(stats->maxExecTimeUs));
+        if (reset)
+            stats->Reset();
+    }
+    return true;
+}
+
+bool ChatHandler::HandlePlayerSaveStatsCommand(char* args)
+{
+    PlayerSaveStats* stats = sWorld.GetPlayerSaveStats();
+    uint64 saves = stats->saves;
+    PSendSysMessage("Player saves: %u | statements avg %u max %u | bytes avg %u max %u",
+        uint32(saves), uint32(saves ? stats->statements / saves : 0), uint32(stats->maxStatements),
+        uint32(saves ? stats->bytes / saves : 0), uint32(stats->maxBytes));
+
+    if (Player* player = m_session ? getSelectedPlayer() : nullptr)
+        PSendSysMessage("%s last save: %u statements, %u bytes", player->GetName(),
+            player->GetLastSaveStatementsCount(), player->GetLastSaveBytes());
+
+    if (args && strcmp(args, "reset") == 0)
+        stats->Reset();
+    return true;
+}
+
+bool ChatHandler::HandleDatabaseQueueStatsCommand(char* args)
+{
+    static char const* names[] = { "Login", "World", "Character", "Logs" };
+    DatabaseType* databases[] = { &LoginDatabase, &WorldDatabase, &CharacterDatabase, &LogsDatabase };
+
+    bool reset = args && strcmp(args, "reset") == 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        SqlDelayQueue::Stats stats;
+        databases[i]->GetAsyncQueueStats(stats);
+        PSendSysMessage("%-9s: %u queued (soft limit %u), %u executed | depth p50 %u p99 %u max %u",
+            names[i], uint32(databases[i]->GetAsyncQueueSize()), uint32(databases[i]->GetAsyncQueueSoftLimit()), uint32(stats.execUs.count),
+            uint32(stats.depth.Percentile(0.5f)), uint32(stats.depth.Percentile(0.99f)), uint32(stats.depth.max));
+        PSendSysMessage("           wait p50 %uus p99 %uus max %uus | exec p50 %uus p99 %uus max %uus",
+            uint32(stats.waitUs.Percentile(0.5f)), uint32(stats.waitUs.Percentile(0.99f)), uint32(stats.waitUs.max),
+            uint32(stats.execUs.Percentile(0.5f)), uint32(stats.execUs.Percentile(0.99f)), uint32(stats.execUs.max));
+        if (reset)
+            databases[i]->ResetAsyncQueueStats();
+    }
+    return true;
+}
+
+bool ChatHandler::HandlePlayerLoginStatsCommand(char* args)
+{
+    static char const* names[MAX_PLAYER_LOGIN_QUERY] =
+    {
+        "characters", "group", "instances", "auras", "spells", "quests", "honor cp", "reputation", "inventory", "item loot",
+        "actions", "social", "homebind", "cooldowns", "guild", "bg data", "skills", "mails", "mail items", "bg data (2)",
+        "pets", "pet spells", "pet cooldowns", "pet auras"
+    };
+
+    PlayerLoginStats* stats = sWorld.GetPlayerLoginStats();
+    PSendSysMessage("Player logins: %u | wait p50 %uus p99 %uus max %uus | queries p50 %uus p99 %uus max %uus",
+        uint32(stats->execUs.count), uint32(stats->waitUs.Percentile(0.5f)), uint32(stats->waitUs.Percentile(0.99f)), uint32(stats->waitUs.max),
+        uint32(stats->execUs.Percentile(0.5f)), uint32(stats->execUs.Percentile(0.99f)), uint32(stats->execUs.max));
+    for (size_t i = 0; i < stats->queryUs.size() && i < MAX_PLAYER_LOGIN_QUERY; ++i)
+    {
+        SqlDelayQueue::Histogram const& query = stats->queryUs[i];
+        PSendSysMessage("  %-11s p50 %uus p99 %uus max %uus", names[i],
+            uint32(query.Percentile(0.5f)), uint32(query.Percentile(0.99f)), uint32(query.max));
+    }
+
+    if (args && strcmp(args, "reset") == 0)
+        stats->Reset();
+    return true;
+}
+
+namespace
+{
+    struct QueueBenchChecker
+    {
+        bool Process(uint64) { return true; }
+    };
+
+    // Producers push 'count' items each while the calling thread drains the queue.
+    // Returns the elapsed time in microseconds.
+    template <class Queue, class Adder>
+    uint64 RunQueueBench(Queue& queue, Adder add, uint32 producers, uint32 count)
+    {
+        std::atomic<bool> go(false);
+        std::vector<std::thread> threads;
+        for (uint32 i = 0; i < producers; ++i)
+            threads.emplace_back([&]()
+            {
+                while (!go)
+                    std::this_thread::yield();
+                for (uint32 j = 0; j < count; ++j)
+                    add(queue, uint64(j));
+            });
+
+        QueueBenchChecker checker;
+        uint64 item = 0;
+        uint64 const total = uint64(producers) * count;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        go = true;
+        for (uint64 received = 0; received < total;)
+        {
+            if (queue.next(item, checker))
+                ++received;
+        }
+        uint64 elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        for (std::thread& thread : threads)
+            thread.join();
+        return elapsed;
+    }
+}
+
+bool ChatHandler::HandleDebugQueueBenchCommand(char* args)
+{
+    uint32 producers = 4;
+    uint32 count = 1000000;
+    ExtractOptUInt32(&args, producers, 4);
+    ExtractOptUInt32(&args, count, 1000000);
+    if (!producers || producers > 64 || !count)
+    {
+        SendSysMessage(LANG_BAD_VALUE);
+        SetSentErrorMessage(true);
+        return false;
+    }
+
+    typedef ACE_Based::LockedQueue<uint64, ACE_Thread_Mutex> LockedBenchQueue;
+    typedef ACE_Based::MPSCQueue<uint64, 256> LockFreeBenchQueue;
+
+    LockedBenchQueue lockedQueue;
+    uint64 lockedUs = RunQueueBench(lockedQueue, [](LockedBenchQueue& q, uint64 v) { q.add(v); }, producers, count);
+
+    std::unique_ptr<LockFreeBenchQueue> lockFreeQueue(new LockFreeBenchQueue());
+    uint64 lockFreeUs = RunQueueBench(*lockFreeQueue, [](LockFreeBenchQueue& q, uint64 v) { q.add(v); }, producers, count);
+
+    double const total = double(producers) * count;
+    PSendSysMessage("%u producers x %u items, single consumer:", producers, count);
+    PSendSysMessage("LockedQueue: %8u ms, %6.1f ns/item", uint32(lockedUs / 1000), lockedUs * 1000.0 / total);
+    PSendSysMessage("MPSCQueue  : %8u ms, %6.1f ns/item", uint32(lockFreeUs / 1000), lockFreeUs * 1000.0 / total);
+    return true;
+}
+
+// Compresses the create blocks of everything the player sees at each zlib level
+bool ChatHandler::HandleDebugCompressBenchCommand(char* args)
+{
+    uint32 iterations = 100;
+    ExtractOptUInt32(&args, iterations, 100);
+    if (!iterations)
+    {
+        SendSysMessage(LANG_BAD_VALUE);
+        SetSentErrorMessage(true);
+        return false;
+    }
+
+    Player* player = m_session->GetPlayer();
+    UpdateData updateData;
+    player->m_visibleGUIDs_lock.acquire_read();
+    for (ObjectGuid const& guid : player->m_visibleGUIDs)
+        if (WorldObject* object = player->GetMap()->GetWorldObject(guid))
+            object->BuildCreateUpdateBlockForPlayer(&updateData, player);
+    player->m_visibleGUIDs_lock.release();
+
+    std::vector<ByteBuffer> payloads;
+    uint64 rawBytes = 0;
+    for (size_t i = 0; i < updateData.GetPacketsCount(); ++i)
+    {
+        payloads.emplace_back(0);
+        updateData.BuildPayload(payloads.back(), i);
+        rawBytes += payloads.back().wpos();
+    }
+    if (!rawBytes)
+    {
+        SendSysMessage("Nothing visible to compress.");
+        return true;
+    }
+
+    PSendSysMessage("%u packets, " UI64FMTD " bytes, %u iterations. Current level %u, threshold %u bytes.",
+        uint32(payloads.size()), rawBytes, iterations, sWorld.getConfig(CONFIG_UINT32_COMPRESSION), sWorld.getConfig(CONFIG_UINT32_COMPRESSION_THRESHOLD));
+
+    std::vector<uint8> output;
+    for (int level = 1; level <= 9; ++level)
+    {
+        uint64 compressedBytes = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (uint32 i = 0; i < iterations; ++i)
+        {
+            compressedBytes = 0;
+            for (ByteBuffer& payload : payloads)
+            {
+                uint32 size = compressBound(payload.wpos());
+                output.resize(size);
+                PacketCompressor::Compress(output.data(), &size, (void*)payload.contents(), payload.wpos(), level);
+                compressedBytes += size;
+            }
+        }
+        uint64 elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        PSendSysMessage("Level %u: " UI64FMTD " bytes (%.1f%% saved), %.1f us per packet, %.1f MB/s",
+            level, compressedBytes, 100.0f - compressedBytes * 100.0f / rawBytes,
+            double(elapsedUs) / (iterations * payloads.size()),
+            elapsedUs ? double(rawBytes) * iterations / elapsedUs : 0.0);
+    }
+    return true;
+}
+
 extern LootStore LootTemplates_Creature;
 extern LootStore LootTemplates_Fishing;
 extern LootStore LootTemplates_Gameobject;
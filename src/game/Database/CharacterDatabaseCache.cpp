@@ -4,53 +4,225 @@
 #include "Pet.h"
 
 
+// Owners that logged out whose pets stay cached, unless configured
+#define DEFAULT_MAX_OFFLINE_OWNERS 1000
+
+// Cached pets are only changed under the lock, their users get a copy
+static CharacterPetCachePtr CopyPet(CharacterPetCachePtr const& pet)
+{
+    return pet ? std::make_shared<CharacterPetCache>(*pet) : nullptr;
+}
+
+static CharPetVector CopyPets(CharPetVector const& pets)
+{
+    CharPetVector copies;
+    copies.reserve(pets.size());
+    for (CharPetVector::const_iterator it = pets.begin(); it != pets.end(); ++it)
+        copies.push_back(CopyPet(*it));
+    return copies;
+}
+
 CharacterDatabaseCache::~CharacterDatabaseCache()
 {
 }
 
-CharacterDatabaseCache::CharacterDatabaseCache()
+CharacterDatabaseCache::CharacterDatabaseCache() : m_maxOfflineOwners(DEFAULT_MAX_OFFLINE_OWNERS)
 {
 }
 
-void CharacterDatabaseCache::LoadAll(uint32 singlePetId)
+void CharacterDatabaseCache::LoadAll()
 {
-    if (singlePetId)
-        DeleteCharacterPetById(singlePetId);
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+
+    // Pet numbers are reused, the free ones must be known without loading the pets
+    m_usedPetNumbers.clear();
+    uint32 count = 0;
+    if (QueryResult* result = CharacterDatabase.Query("SELECT id FROM character_pet"))
+    {
+        do
+        {
+            SetPetNumberUsed(result->Fetch()[0].GetUInt32(), true);
+            ++count;
+        }
+        while (result->NextRow());
+        delete result;
+    }
+    sLog.outString(">> %u pet numbers in use, pets will be loaded with their owner.", count);
+}
+
+void CharacterDatabaseCache::ReloadCharacterPet(uint32 petId)
+{
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    DeleteCharacterPetById(petId);
+
+    QueryResult* result = CharacterDatabase.PQuery(
+                              "SELECT id, entry, owner, modelid, level, exp, Reactstate, loyaltypoints, loyalty, trainpoint, "
+                              "slot, name, renamed, curhealth, curmana, curhappiness, abdata, TeachSpelldata, savetime, resettalents_cost, "
+                              "resettalents_time, CreatedBySpell, PetType FROM character_pet WHERE id=%u", petId
+                          );
+    if (!result)
+        return;
 
-    LoadCharacterPet(singlePetId);
-    LoadPetSpell(singlePetId);
-    LoadPetSpellCooldown(singlePetId);
-    LoadPetAura(singlePetId);
+    // Read along with the other pets of its owner when they are needed
+    SetPetNumberUsed(petId, true);
+    if (m_petsByCharacter.find(result->Fetch()[2].GetUInt32()) == m_petsByCharacter.end())
+    {
+        delete result;
+        return;
+    }
+
+    LoadCharacterPet(result);
+    delete result;
+
+    result = CharacterDatabase.PQuery("SELECT guid,spell,active FROM pet_spell WHERE guid=%u", petId);
+    LoadPetSpell(result);
+    delete result;
+
+    result = CharacterDatabase.PQuery("SELECT guid,spell,time FROM pet_spell_cooldown WHERE guid=%u", petId);
+    LoadPetSpellCooldown(result);
+    delete result;
+
+    result = CharacterDatabase.PQuery(
+                 "SELECT guid, caster_guid, item_guid, spell, stackcount, remaincharges, maxduration, remaintime, effIndexMask, "
+                 "basepoints0, basepoints1, basepoints2, periodictime0, periodictime1, periodictime2 "
+                 "FROM pet_aura WHERE guid=%u", petId
+             );
+    LoadPetAura(result);
+    delete result;
 }
 
-void CharacterDatabaseCache::LoadCharacterPet(uint32 singlePetId)
+void CharacterDatabaseCache::LoadOwnerPets(uint32 owner, QueryResult* pets, QueryResult* spells, QueryResult* cooldowns, QueryResult* auras)
 {
-    QueryResult* result = NULL;
-    if (singlePetId)
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+
+    // Still cached since a previous session: the cache is at least as recent as the database
+    // The results belong to the login query holder, which deletes them
+    if (m_petsByCharacter.find(owner) == m_petsByCharacter.end())
     {
-        result = CharacterDatabase.PQuery(
-                     "SELECT id, entry, owner, modelid, level, exp, Reactstate, loyaltypoints, loyalty, trainpoint, "
-                     "slot, name, renamed, curhealth, curmana, curhappiness, abdata, TeachSpelldata, savetime, resettalents_cost, "
-                     "resettalents_time, CreatedBySpell, PetType FROM character_pet WHERE id=%u", singlePetId
-                 );
+        m_petsByCharacter[owner];
+        LoadCharacterPet(pets);
+        LoadPetSpell(spells);
+        LoadPetSpellCooldown(cooldowns);
+        LoadPetAura(auras);
     }
-    else if (!singlePetId)
+
+    // Online owners are never evicted
+    std::unordered_map<uint32, std::list<uint32>::iterator>::iterator position = m_offlinePositions.find(owner);
+    if (position != m_offlinePositions.end())
     {
-        m_petsByCharacter.clear();
-        sLog.outString("* Loading de `character_pet`");
-        result = CharacterDatabase.Query(
-                     "SELECT id, entry, owner, modelid, level, exp, Reactstate, loyaltypoints, loyalty, trainpoint, "
-                     "slot, name, renamed, curhealth, curmana, curhappiness, abdata, TeachSpelldata, savetime, resettalents_cost, "
-                     "resettalents_time, CreatedBySpell, PetType FROM character_pet"
-                 );
+        m_offlineOwners.erase(position->second);
+        m_offlinePositions.erase(position);
     }
+}
+
+void CharacterDatabaseCache::OnOwnerLogout(uint32 owner)
+{
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    if (m_petsByCharacter.find(owner) == m_petsByCharacter.end())
+        return;
+
+    std::unordered_map<uint32, std::list<uint32>::iterator>::iterator position = m_offlinePositions.find(owner);
+    if (position != m_offlinePositions.end())
+        m_offlineOwners.splice(m_offlineOwners.begin(), m_offlineOwners, position->second);
+    else
+    {
+        m_offlineOwners.push_front(owner);
+        m_offlinePositions[owner] = m_offlineOwners.begin();
+    }
+
+    while (m_offlineOwners.size() > m_maxOfflineOwners)
+        EvictOwner(m_offlineOwners.back());
+}
+
+CharPetMap::iterator CharacterDatabaseCache::LoadOwner(uint32 owner)
+{
+    CharPetMap::iterator ownerPets = m_petsByCharacter.find(owner);
+    if (ownerPets != m_petsByCharacter.end())
+    {
+        std::unordered_map<uint32, std::list<uint32>::iterator>::iterator position = m_offlinePositions.find(owner);
+        if (position != m_offlinePositions.end())
+            m_offlineOwners.splice(m_offlineOwners.begin(), m_offlineOwners, position->second);
+        return ownerPets;
+    }
+
+    // Logged in characters got their pets with the login queries, this one is offline
+    ownerPets = m_petsByCharacter.insert(CharPetMap::value_type(owner, CharPetVector())).first;
+    QueryResult* result = CharacterDatabase.PQuery(PET_CACHE_QUERY_PETS, owner);
+    LoadCharacterPet(result);
+    delete result;
+
+    result = CharacterDatabase.PQuery(PET_CACHE_QUERY_SPELLS, owner);
+    LoadPetSpell(result);
+    delete result;
+
+    result = CharacterDatabase.PQuery(PET_CACHE_QUERY_COOLDOWNS, owner);
+    LoadPetSpellCooldown(result);
+    delete result;
+
+    result = CharacterDatabase.PQuery(PET_CACHE_QUERY_AURAS, owner);
+    LoadPetAura(result);
+    delete result;
+
+    m_offlineOwners.push_front(owner);
+    m_offlinePositions[owner] = m_offlineOwners.begin();
+    while (m_offlineOwners.size() > m_maxOfflineOwners && m_offlineOwners.back() != owner)
+        EvictOwner(m_offlineOwners.back());
+
+    return ownerPets;
+}
+
+void CharacterDatabaseCache::EvictOwner(uint32 owner)
+{
+    CharPetMap::iterator ownerPets = m_petsByCharacter.find(owner);
+    if (ownerPets != m_petsByCharacter.end())
+    {
+        for (CharPetVector::iterator it = ownerPets->second.begin(); it != ownerPets->second.end(); ++it)
+            m_petsByGuid.erase((*it)->id);
+        m_petsByCharacter.erase(ownerPets);
+    }
+
+    std::unordered_map<uint32, std::list<uint32>::iterator>::iterator position = m_offlinePositions.find(owner);
+    if (position != m_offlinePositions.end())
+    {
+        m_offlineOwners.erase(position->second);
+        m_offlinePositions.erase(position);
+    }
+}
+
+void CharacterDatabaseCache::SetPetNumberUsed(uint32 id, bool used)
+{
+    if (id >= m_usedPetNumbers.size())
+    {
+        if (!used)
+            return;
+        m_usedPetNumbers.resize(std::max<size_t>(id + 1, m_usedPetNumbers.size() * 2));
+    }
+    m_usedPetNumbers[id] = used;
+}
+
+uint32 CharacterDatabaseCache::GetCachedOwnersCount()
+{
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    return m_petsByCharacter.size();
+}
+
+uint32 CharacterDatabaseCache::GetCachedPetsCount()
+{
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    return m_petsByGuid.size();
+}
+
+void CharacterDatabaseCache::LoadCharacterPet(QueryResult* result)
+{
     if (!result)
         return;
-    uint32 count = 0;
     do
     {
         Field *fields = result->Fetch();
-        CharacterPetCache* pCache = new CharacterPetCache;
+        if (FindPet(fields[0].GetUInt32()))
+            continue;
+
+        CharacterPetCachePtr pCache = std::make_shared<CharacterPetCache>();
         pCache->id = fields[0].GetUInt32();
         pCache->entry = fields[1].GetUInt32();
         pCache->owner = fields[2].GetUInt32();
@@ -74,42 +246,16 @@ void CharacterDatabaseCache::LoadCharacterPet(uint32 singlePetId)
         pCache->resettalents_time = fields[20].GetUInt32();
         pCache->CreatedBySpell = fields[21].GetUInt32();
         pCache->PetType = fields[22].GetUInt32();
-        ++count;
         InsertCharacterPet(pCache);
     }
     while (result->NextRow());
-    delete result;
-    if (!singlePetId)
-        sLog.outString("-> %u rows loaded.", count);
 }
 
-void CharacterDatabaseCache::LoadPetSpell(uint32 singlePetId)
+void CharacterDatabaseCache::LoadPetSpell(QueryResult* result)
 {
-    QueryResult* result = NULL;
-    if (singlePetId)
-    {
-        result = CharacterDatabase.PQuery(
-                     "SELECT guid,spell,active "
-                     "FROM pet_spell WHERE guid=%u", singlePetId
-                 );
-    }
-    else
-    {
-        // Clear previously stored spells
-        for (PetGuidToPetMap::iterator it = m_petsByGuid.begin(); it != m_petsByGuid.end(); ++it)
-            it->second->spells.clear();
-
-        sLog.outString("* Loading `pet_spell`");
-        result = CharacterDatabase.Query(
-                     "SELECT guid,spell,active "
-                     "FROM pet_spell ORDER BY guid ASC"
-                 );
-    }
-
     if (!result)
         return;
-    uint32 count = 0;
-    CharacterPetCache* lastPetCache = NULL;
+    CharacterPetCachePtr lastPetCache;
     do
     {
         Field *fields = result->Fetch();
@@ -117,47 +263,22 @@ void CharacterDatabaseCache::LoadPetSpell(uint32 singlePetId)
         uint32 spellId = fields[1].GetUInt32();
         uint8  active  = fields[2].GetUInt32();
         if (!lastPetCache || lastPetCache->id != lowGuid)
-            lastPetCache = GetCharacterPetById(lowGuid);
+            lastPetCache = FindPet(lowGuid);
         if (!lastPetCache)
             continue;
         PetSpellCache _spellStruct;
         _spellStruct.spell = spellId;
         _spellStruct.active = active;
         lastPetCache->spells.push_back(_spellStruct);
-        ++count;
     }
     while (result->NextRow());
-    delete result;
-    if (!singlePetId)
-        sLog.outString("-> %u rows loaded.", count);
 }
 
-void CharacterDatabaseCache::LoadPetSpellCooldown(uint32 singlePetId)
+void CharacterDatabaseCache::LoadPetSpellCooldown(QueryResult* result)
 {
-    QueryResult* result = NULL;
-    if (singlePetId)
-    {
-        result = CharacterDatabase.PQuery(
-                     "SELECT guid,spell,time "
-                     "FROM pet_spell_cooldown WHERE guid=%u", singlePetId
-                 );
-    }
-    else
-    {
-        // Clear previously stored cooldowns
-        for (PetGuidToPetMap::iterator it = m_petsByGuid.begin(); it != m_petsByGuid.end(); ++it)
-            it->second->spellCooldown.clear();
-
-        sLog.outString("* Loading `pet_spell_cooldown`");
-        result = CharacterDatabase.Query(
-                     "SELECT guid,spell,time "
-                     "FROM pet_spell_cooldown ORDER BY guid ASC"
-                 );
-    }
     if (!result)
         return;
-    uint32 count = 0;
-    CharacterPetCache* lastPetCache = NULL;
+    CharacterPetCachePtr lastPetCache;
     do
     {
         Field *fields = result->Fetch();
@@ -165,51 +286,22 @@ void CharacterDatabaseCache::LoadPetSpellCooldown(uint32 singlePetId)
         uint32 spellId = fields[1].GetUInt32();
         uint64 time    = fields[2].GetUInt64();
         if (!lastPetCache || lastPetCache->id != lowGuid)
-            lastPetCache = GetCharacterPetById(lowGuid);
+            lastPetCache = FindPet(lowGuid);
         if (!lastPetCache)
             continue;
         PetSpellCoodown _spellStruct;
         _spellStruct.spell = spellId;
         _spellStruct.time  = time;
         lastPetCache->spellCooldown.push_back(_spellStruct);
-        ++count;
     }
     while (result->NextRow());
-    delete result;
-    if (!singlePetId)
-        sLog.outString("-> %u rows loaded.", count);
 }
 
-void CharacterDatabaseCache::LoadPetAura(uint32 singlePetId)
+void CharacterDatabaseCache::LoadPetAura(QueryResult* result)
 {
-    QueryResult* result = NULL;
-    if (singlePetId)
-    {
-        result = CharacterDatabase.PQuery(
-                     "SELECT guid, caster_guid, item_guid, spell, stackcount, remaincharges, maxduration, remaintime, effIndexMask, "
-                     "basepoints0, basepoints1, basepoints2, periodictime0, periodictime1, periodictime2 "
-                     "FROM pet_aura WHERE guid=%u", singlePetId
-                 );
-    }
-    else
-    {
-        // Clear previously stored auras
-        for (PetGuidToPetMap::iterator it = m_petsByGuid.begin(); it != m_petsByGuid.end(); ++it)
-            it->second->auras.clear();
-
-        sLog.outString("* Loading table `pet_aura`");
-        result = CharacterDatabase.Query(
-                                  //          0     1             2           3    4           5              6            7              8
-                                  "SELECT guid, caster_guid, item_guid, spell, stackcount, remaincharges, maxduration, remaintime, effIndexMask, "
-                                  // 9 -> 11                              12 -> 14
-                                  "basepoints0, basepoints1, basepoints2, periodictime0, periodictime1, periodictime2 "
-                                  "FROM pet_aura ORDER BY guid ASC"
-                              );
-    }
     if (!result)
         return;
-    uint32 count = 0;
-    CharacterPetCache* lastPetCache = NULL;
+    CharacterPetCachePtr lastPetCache;
 #define NEXT_UINT32(where) { where = fields[uiFieldCount].GetUInt32(); ++uiFieldCount; }
 #define NEXT_INT32(where) { where = fields[uiFieldCount].GetInt32(); ++uiFieldCount; }
     do
@@ -218,7 +310,7 @@ void CharacterDatabaseCache::LoadPetAura(uint32 singlePetId)
         uint32 lowGuid = fields[0].GetUInt32();
 
         if (!lastPetCache || lastPetCache->id != lowGuid)
-            lastPetCache = GetCharacterPetById(lowGuid);
+            lastPetCache = FindPet(lowGuid);
         if (!lastPetCache)
             continue;
         uint32 uiFieldCount = 1;
@@ -243,114 +335,179 @@ void CharacterDatabaseCache::LoadPetAura(uint32 singlePetId)
             continue;
 
         lastPetCache->auras.push_back(_auraStruct);
-        ++count;
     }
     while (result->NextRow());
-    delete result;
-    if (!singlePetId)
-        sLog.outString("-> %u rows loaded.", count);
 }
 
-CharacterPetCache* CharacterDatabaseCache::GetCharacterPetById(uint32 id)
+CharacterPetCachePtr CharacterDatabaseCache::FindPet(uint32 id)
 {
     PetGuidToPetMap::iterator petStruct = m_petsByGuid.find(id);
     if (petStruct == m_petsByGuid.end())
-        return NULL;
+        return nullptr;
     return petStruct->second;
 }
 
-CharacterPetCache* CharacterDatabaseCache::GetCharacterPetCacheByOwnerAndId(uint64 owner, uint32 id)
+CharacterPetCachePtr CharacterDatabaseCache::GetCharacterPetById(uint32 id)
+{
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    if (CharacterPetCachePtr pCache = FindPet(id))
+        return CopyPet(pCache);
+    if (id >= m_usedPetNumbers.size() || !m_usedPetNumbers[id])
+        return nullptr;
+
+    // Owner is offline and not cached
+    QueryResult* result = CharacterDatabase.PQuery("SELECT owner FROM character_pet WHERE id=%u", id);
+    if (!result)
+        return nullptr;
+    uint32 owner = result->Fetch()[0].GetUInt32();
+    delete result;
+    LoadOwner(owner);
+    return CopyPet(FindPet(id));
+}
+
+CharPetVector CharacterDatabaseCache::LoadCharacterPets(uint32 owner)
+{
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    return CopyPets(LoadOwner(owner)->second);
+}
+
+CharPetVector CharacterDatabaseCache::GetCharacterPets(uint32 owner)
+{
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    CharPetMap::const_iterator ownerPets = m_petsByCharacter.find(owner);
+    if (ownerPets == m_petsByCharacter.end())
+        return CharPetVector();
+    return CopyPets(ownerPets->second);
+}
+
+CharacterPetCachePtr CharacterDatabaseCache::GetCharacterPetCacheByOwnerAndId(uint64 owner, uint32 id)
 {
     // FROM character_pet WHERE owner = '%u' AND id = '%u'
-    CharPetMap::iterator ownerPets = m_petsByCharacter.find(owner);
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    CharPetMap::const_iterator ownerPets = m_petsByCharacter.find(owner);
     if (ownerPets == m_petsByCharacter.end())
-        return NULL;
-    for (CharPetVector::iterator it = ownerPets->second.begin(); it != ownerPets->second.end(); ++it)
+        return nullptr;
+    for (CharPetVector::const_iterator it = ownerPets->second.begin(); it != ownerPets->second.end(); ++it)
         if ((*it)->id == id)
-            return (*it);
+            return CopyPet(*it);
 
-    return NULL;
+    return nullptr;
 }
 
-CharacterPetCache* CharacterDatabaseCache::GetCharacterCurrentPet(uint64 owner)
+CharacterPetCachePtr CharacterDatabaseCache::GetCharacterCurrentPet(uint64 owner)
 {
     // FROM character_pet WHERE owner = '%u' AND slot = 'PET_SAVE_AS_CURRENT'
-    CharPetMap::iterator ownerPets = m_petsByCharacter.find(owner);
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    CharPetMap::const_iterator ownerPets = m_petsByCharacter.find(owner);
     if (ownerPets == m_petsByCharacter.end())
-        return NULL;
-    for (CharPetVector::iterator it = ownerPets->second.begin(); it != ownerPets->second.end(); ++it)
+        return nullptr;
+    for (CharPetVector::const_iterator it = ownerPets->second.begin(); it != ownerPets->second.end(); ++it)
         if ((*it)->slot == PET_SAVE_AS_CURRENT)
-            return (*it);
+            return CopyPet(*it);
 
-    return NULL;
+    return nullptr;
 }
 
-CharacterPetCache* CharacterDatabaseCache::GetCharacterPetByOwnerAndEntry(uint64 owner, uint32 entry)
+CharacterPetCachePtr CharacterDatabaseCache::GetCharacterPetByOwnerAndEntry(uint64 owner, uint32 entry)
 {
     // FROM character_pet WHERE owner = '%u' AND entry = '%u' AND (slot = 'PET_SAVE_AS_CURRENT' OR slot > 'PET_SAVE_LAST_STABLE_SLOT')
-    CharPetMap::iterator ownerPets = m_petsByCharacter.find(owner);
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    CharPetMap::const_iterator ownerPets = m_petsByCharacter.find(owner);
     if (ownerPets == m_petsByCharacter.end())
-        return NULL;
-    for (CharPetVector::iterator it = ownerPets->second.begin(); it != ownerPets->second.end(); ++it)
+        return nullptr;
+    for (CharPetVector::const_iterator it = ownerPets->second.begin(); it != ownerPets->second.end(); ++it)
         if ((*it)->entry == entry && ((*it)->slot == PET_SAVE_AS_CURRENT || (*it)->slot > PET_SAVE_LAST_STABLE_SLOT))
-            return (*it);
+            return CopyPet(*it);
 
-    return NULL;
+    return nullptr;
 }
 
-CharacterPetCache* CharacterDatabaseCache::GetCharacterPetByOwner(uint64 owner)
+CharacterPetCachePtr CharacterDatabaseCache::GetCharacterPetByOwner(uint64 owner)
 {
     // FROM character_pet WHERE owner = '%u' AND (slot = 'PET_SAVE_AS_CURRENT' OR slot > 'PET_SAVE_LAST_STABLE_SLOT')
-    CharPetMap::iterator ownerPets = m_petsByCharacter.find(owner);
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    CharPetMap::const_iterator ownerPets = m_petsByCharacter.find(owner);
     if (ownerPets == m_petsByCharacter.end())
-        return NULL;
-    for (CharPetVector::iterator it = ownerPets->second.begin(); it != ownerPets->second.end(); ++it)
+        return nullptr;
+    for (CharPetVector::const_iterator it = ownerPets->second.begin(); it != ownerPets->second.end(); ++it)
         if ((*it)->slot == PET_SAVE_AS_CURRENT || (*it)->slot > PET_SAVE_LAST_STABLE_SLOT)
-            return (*it);
+            return CopyPet(*it);
 
-    return NULL;
+    return nullptr;
 }
 
-void CharacterDatabaseCache::CharacterPetSetOthersNotInSlot(CharacterPetCache* pCache)
+void CharacterDatabaseCache::SetCharacterCurrentPet(uint32 owner, uint32 id)
 {
-    CharPetMap::iterator ownerPets = m_petsByCharacter.find(pCache->owner);
+    // UPDATE character_pet SET slot = 'PET_SAVE_NOT_IN_SLOT' WHERE owner = '%u' AND slot = 'PET_SAVE_AS_CURRENT' AND id <> '%u'
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    CharPetMap::iterator ownerPets = m_petsByCharacter.find(owner);
     if (ownerPets == m_petsByCharacter.end())
         return;
     for (CharPetVector::iterator it = ownerPets->second.begin(); it != ownerPets->second.end(); ++it)
-        if ((*it)->id != pCache->id && (*it)->slot == PET_SAVE_AS_CURRENT)
+    {
+        if ((*it)->id == id)
+            (*it)->slot = PET_SAVE_AS_CURRENT;
+        else if ((*it)->slot == PET_SAVE_AS_CURRENT)
             (*it)->slot = PET_SAVE_NOT_IN_SLOT;
+    }
 }
 
-void CharacterDatabaseCache::InsertCharacterPet(CharacterPetCache* cache)
+void CharacterDatabaseCache::SetCharacterPetName(uint32 id, std::string const& name)
 {
-    m_petsByCharacter[cache->owner].push_back(cache);
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    if (CharacterPetCachePtr pCache = FindPet(id))
+        pCache->name = name;
+}
+
+void CharacterDatabaseCache::InsertCharacterPet(CharacterPetCachePtr const& cache)
+{
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+
+    // The database may still hold an older copy of this pet
+    CharacterPetCachePtr previous = FindPet(cache->id);
+    if (previous && previous->owner != cache->owner)
+    {
+        DeleteCharacterPetById(cache->id);
+        previous = nullptr;
+    }
+    SetPetNumberUsed(cache->id, true);
+
+    // Read with the other pets of its owner when they are needed
+    CharPetMap::iterator ownerPets = m_petsByCharacter.find(cache->owner);
+    if (ownerPets == m_petsByCharacter.end())
+        return;
+
+    if (previous)
+        std::replace(ownerPets->second.begin(), ownerPets->second.end(), previous, cache);
+    else
+        ownerPets->second.push_back(cache);
     m_petsByGuid[cache->id] = cache;
 }
 
 void CharacterDatabaseCache::DeleteCharacterPetById(uint32 id)
 {
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    SetPetNumberUsed(id, false);
     PetGuidToPetMap::iterator petStruct = m_petsByGuid.find(id);
     if (petStruct == m_petsByGuid.end())
         return;
     CharPetMap::iterator ownerPets = m_petsByCharacter.find(petStruct->second->owner);
-    for (CharPetVector::iterator it = ownerPets->second.begin(); it != ownerPets->second.end(); ++it)
-        if ((*it)->id == id)
-        {
-            ownerPets->second.erase(it);
-            break;
-        }
-    delete petStruct->second;
+    if (ownerPets != m_petsByCharacter.end())
+    {
+        for (CharPetVector::iterator it = ownerPets->second.begin(); it != ownerPets->second.end(); ++it)
+            if ((*it)->id == id)
+            {
+                ownerPets->second.erase(it);
+                break;
+            }
+    }
     m_petsByGuid.erase(petStruct);
 }
 
-uint32 CharacterDatabaseCache::GetNextAvailablePetNumber(uint32 minimumValue) const
+uint32 CharacterDatabaseCache::GetNextAvailablePetNumber(uint32 minimumValue)
 {
-    // Returns an iterator pointing to $minimumValue if exists, or greater than $minimumValue
-    PetGuidToPetMap::const_iterator it = m_petsByGuid.lower_bound(minimumValue);
-    while (it != m_petsByGuid.end() && it->first == minimumValue)
-    {
+    std::lock_guard<std::recursive_mutex> guard(m_lock);
+    while (minimumValue < m_usedPetNumbers.size() && m_usedPetNumbers[minimumValue])
         ++minimumValue;
-        ++it;
-    }
     return minimumValue;
 }
@@ -2,6 +2,10 @@
 #define _CHARACTER_DATABASE_CACHE_H
 
 #include "Common.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 // pet_spell_cooldown
 struct PetSpellCoodown
@@ -54,10 +58,31 @@ struct CharacterPetCache
     PetAuras    auras;
 };
 
-typedef std::vector<CharacterPetCache*> CharPetVector;
+// Kept alive by its users after the eviction of its owner
+typedef std::shared_ptr<CharacterPetCache> CharacterPetCachePtr;
+typedef std::vector<CharacterPetCachePtr> CharPetVector;
 typedef std::map<uint32 /*owner guid*/, CharPetVector> CharPetMap;
-typedef std::map<uint32 /*pet guid*/, CharacterPetCache*> PetGuidToPetMap;
-
+typedef std::map<uint32 /*pet guid*/, CharacterPetCachePtr> PetGuidToPetMap;
+
+class QueryResult;
+
+// Pets of one owner, also part of the login queries
+#define PET_CACHE_QUERY_PETS        "SELECT id, entry, owner, modelid, level, exp, Reactstate, loyaltypoints, loyalty, trainpoint, " \
+                                    "slot, name, renamed, curhealth, curmana, curhappiness, abdata, TeachSpelldata, savetime, resettalents_cost, " \
+                                    "resettalents_time, CreatedBySpell, PetType FROM character_pet WHERE owner = '%u'"
+#define PET_CACHE_QUERY_SPELLS      "SELECT s.guid, s.spell, s.active FROM pet_spell s JOIN character_pet p ON p.id = s.guid WHERE p.owner = '%u'"
+#define PET_CACHE_QUERY_COOLDOWNS   "SELECT c.guid, c.spell, c.time FROM pet_spell_cooldown c JOIN character_pet p ON p.id = c.guid WHERE p.owner = '%u'"
+#define PET_CACHE_QUERY_AURAS       "SELECT a.guid, a.caster_guid, a.item_guid, a.spell, a.stackcount, a.remaincharges, a.maxduration, a.remaintime, a.effIndexMask, " \
+                                    "a.basepoints0, a.basepoints1, a.basepoints2, a.periodictime0, a.periodictime1, a.periodictime2 " \
+                                    "FROM pet_aura a JOIN character_pet p ON p.id = a.guid WHERE p.owner = '%u'"
+
+/**
+ * Pets of the characters, loaded per owner instead of all at startup.
+ * Online characters get theirs with the login queries, the pets of offline ones
+ * are only read by GM commands. Users get copies of the cached pets, and pet saves
+ * replace them along with the database. The pets of characters that logged out
+ * are kept until too many others did.
+ */
 class CharacterDatabaseCache
 {
     public:
@@ -69,29 +94,61 @@ class CharacterDatabaseCache
             static CharacterDatabaseCache* i = new CharacterDatabaseCache();
             return i;
         }
-        void LoadAll(uint32 singlePetId = 0);
-
-        void LoadCharacterPet(uint32 singlePetId);
-        void LoadPetSpell(uint32 singlePetId);
-        void LoadPetSpellCooldown(uint32 singlePetId);
-        void LoadPetAura(uint32 singlePetId);
-
-        CharacterPetCache* GetCharacterPetCacheByOwnerAndId(uint64 owner, uint32 id);
-        CharacterPetCache* GetCharacterCurrentPet(uint64 owner);
-        CharacterPetCache* GetCharacterPetByOwnerAndEntry(uint64 owner, uint32 entry);
-        CharacterPetCache* GetCharacterPetByOwner(uint64 owner);
-        CharacterPetCache* GetCharacterPetById(uint32 id); // Very slow method (iterates over all the stored pets)
-        void CharacterPetSetOthersNotInSlot(CharacterPetCache* pCache);
-        void InsertCharacterPet(CharacterPetCache* cache);
+        // Only reads the used pet numbers, the pets themselves are loaded per owner
+        void LoadAll();
+        // Reads a pet again from the database, if its owner is cached
+        void ReloadCharacterPet(uint32 petId);
+
+        // Login query results of a character, ignored if its pets are already cached
+        void LoadOwnerPets(uint32 owner, QueryResult* pets, QueryResult* spells, QueryResult* cooldowns, QueryResult* auras);
+        void OnOwnerLogout(uint32 owner);
+        void SetMaxOfflineOwners(uint32 count) { m_maxOfflineOwners = count; }
+
+        // Only the pets of cached owners, never queries the database (map threads)
+        CharacterPetCachePtr GetCharacterPetCacheByOwnerAndId(uint64 owner, uint32 id);
+        CharacterPetCachePtr GetCharacterCurrentPet(uint64 owner);
+        CharacterPetCachePtr GetCharacterPetByOwnerAndEntry(uint64 owner, uint32 entry);
+        CharacterPetCachePtr GetCharacterPetByOwner(uint64 owner);
+        CharPetVector GetCharacterPets(uint32 owner);
+        // Read the owner from the database if needed, for GM commands
+        CharacterPetCachePtr GetCharacterPetById(uint32 id);
+        CharPetVector LoadCharacterPets(uint32 owner);
+
+        void SetCharacterCurrentPet(uint32 owner, uint32 id);
+        void SetCharacterPetName(uint32 id, std::string const& name);
+        // The cache keeps this copy, it must not be changed afterwards
+        void InsertCharacterPet(CharacterPetCachePtr const& cache);
         void DeleteCharacterPetById(uint32 id);
-        CharPetMap const& GetCharPetsMap() const { return m_petsByCharacter; }
-        uint32 GetNextAvailablePetNumber(uint32 minimumValue) const;
+        uint32 GetNextAvailablePetNumber(uint32 minimumValue);
+
+        uint32 GetCachedOwnersCount();
+        uint32 GetCachedPetsCount();
 
     protected:
-        // @TODO: Lock these structures for thread safety, and process stable opcodes per map
+        // Add the rows of the results to the cached pets, the results are not deleted
+        void LoadCharacterPet(QueryResult* result);
+        void LoadPetSpell(QueryResult* result);
+        void LoadPetSpellCooldown(QueryResult* result);
+        void LoadPetAura(QueryResult* result);
+
+        CharPetMap::iterator LoadOwner(uint32 owner);
+        void EvictOwner(uint32 owner);
+        CharacterPetCachePtr FindPet(uint32 id);
+        void SetPetNumberUsed(uint32 id, bool used);
+
+        // Loaded owners, with an entry even if they have no pet
         CharPetMap      m_petsByCharacter;
         PetGuidToPetMap m_petsByGuid;
 
+        // Offline owners, most recently used first
+        std::list<uint32> m_offlineOwners;
+        std::unordered_map<uint32, std::list<uint32>::iterator> m_offlinePositions;
+        uint32 m_maxOfflineOwners;
+
+        // Every pet number in the database, cached or not
+        std::vector<bool> m_usedPetNumbers;
+
+        std::recursive_mutex m_lock;
 };
 
 #define sCharacterDatabaseCache (*(CharacterDatabaseCache::instance()))
@@ -44,6 +44,7 @@
 #include "Anticheat.h"
 #include "MasterPlayer.h"
 #include "PlayerBroadcaster.h"
+#include "CharacterDatabaseCache.h"
 
 // config option SkipCinematics supported values
 enum CinematicsSkipMode
@@ -110,6 +111,10 @@ bool LoginQueryHolder::Initialize()
     res &= SetPQuery(PLAYER_LOGIN_QUERY_LOADSKILLS,          "SELECT skill, value, max FROM character_skills WHERE guid = '%u'", m_guid.GetCounter());
     res &= SetPQuery(PLAYER_LOGIN_QUERY_LOADMAILS,           "SELECT id,messageType,sender,receiver,subject,itemTextId,expire_time,deliver_time,money,cod,checked,stationery,mailTemplateId,has_items FROM mail WHERE receiver = '%u' ORDER BY id DESC", m_guid.GetCounter());
     res &= SetPQuery(PLAYER_LOGIN_QUERY_LOADMAILEDITEMS,     "SELECT creatorGuid, giftCreatorGuid, count, duration, charges, flags, enchantments, randomPropertyId, durability, text, mail_id, item_guid, itemEntry, generated_loot FROM mail_items JOIN item_instance ON item_guid = guid WHERE receiver = '%u'", m_guid.GetCounter());
+    res &= SetPQuery(PLAYER_LOGIN_QUERY_LOADPETS,            PET_CACHE_QUERY_PETS, m_guid.GetCounter());
+    res &= SetPQuery(PLAYER_LOGIN_QUERY_LOADPETSPELLS,       PET_CACHE_QUERY_SPELLS, m_guid.GetCounter());
+    res &= SetPQuery(PLAYER_LOGIN_QUERY_LOADPETCOOLDOWNS,    PET_CACHE_QUERY_COOLDOWNS, m_guid.GetCounter());
+    res &= SetPQuery(PLAYER_LOGIN_QUERY_LOADPETAURAS,        PET_CACHE_QUERY_AURAS, m_guid.GetCounter());
 
     return res;
 }
@@ -133,6 +138,7 @@ public:
     void HandlePlayerLoginCallback(QueryResult * /*dummy*/, SqlQueryHolder * holder)
     {
         if (!holder) return;
+        sWorld.GetPlayerLoginStats()->Record(holder);
         WorldSession *session = sWorld.FindSession(((LoginQueryHolder*)holder)->GetAccountId());
         if (!session)
         {
@@ -513,6 +519,11 @@ void WorldSession::HandlePlayerLogin(LoginQueryHolder *holder)
         pCurrChar->GetMotionMaster()->Initialize();
     }
 
+    // Ignored if the pets are still cached from a previous session
+    sCharacterDatabaseCache.LoadOwnerPets(playerGuid.GetCounter(),
+        holder->GetResult(PLAYER_LOGIN_QUERY_LOADPETS), holder->GetResult(PLAYER_LOGIN_QUERY_LOADPETSPELLS),
+        holder->GetResult(PLAYER_LOGIN_QUERY_LOADPETCOOLDOWNS), holder->GetResult(PLAYER_LOGIN_QUERY_LOADPETAURAS));
+
     // "GetAccountId()==db stored account id" checked in LoadFromDB (prevent login not own character using cheating tools)
     if (alreadyOnline)
         pCurrChar->SendPacketsAtRelogin();
@@ -581,7 +581,7 @@ void WorldSession::SendStablePet(ObjectGuid guid)
         ++num;
     }
     // Pet may be despawned if owner went far away from pet for example.
-    else if (CharacterPetCache const* currentPetData = sCharacterDatabaseCache.GetCharacterPetByOwner(_player->GetGUIDLow()))
+    else if (CharacterPetCachePtr currentPetData = sCharacterDatabaseCache.GetCharacterPetByOwner(_player->GetGUIDLow()))
     {
         data << uint32(currentPetData->id);
         data << uint32(currentPetData->entry);
@@ -591,20 +591,18 @@ void WorldSession::SendStablePet(ObjectGuid guid)
         data << uint8(0x01);                                    // client slot 1 == current pet (0)
         ++num;
     }
-    CharPetMap const& pets = sCharacterDatabaseCache.GetCharPetsMap();
-    CharPetMap::const_iterator myPets = pets.find(GetPlayer()->GetGUIDLow());
-    if (myPets != pets.end())
-        for (CharPetVector::const_iterator it = myPets->second.begin(); it != myPets->second.end(); ++it)
-            if ((*it)->slot >= PET_SAVE_FIRST_STABLE_SLOT && (*it)->slot <= PET_SAVE_LAST_STABLE_SLOT)
-            {
-                data << uint32((*it)->id);                 // petnumber
-                data << uint32((*it)->entry);              // creature entry
-                data << uint32((*it)->level);              // level
-                data << (*it)->name;                       // name
-                data << uint32((*it)->loyalty);            // loyalty
-                data << uint8((*it)->slot + 1);            // slot
-                ++num;
-            }
+    CharPetVector const pets = sCharacterDatabaseCache.GetCharacterPets(GetPlayer()->GetGUIDLow());
+    for (CharPetVector::const_iterator it = pets.begin(); it != pets.end(); ++it)
+        if ((*it)->slot >= PET_SAVE_FIRST_STABLE_SLOT && (*it)->slot <= PET_SAVE_LAST_STABLE_SLOT)
+        {
+            data << uint32((*it)->id);                     // petnumber
+            data << uint32((*it)->entry);                  // creature entry
+            data << uint32((*it)->level);                  // level
+            data << (*it)->name;                           // name
+            data << uint32((*it)->loyalty);                // loyalty
+            data << uint8((*it)->slot + 1);                // slot
+            ++num;
+        }
 
     data.put<uint8>(wpos, num);                             // set real data to placeholder
     SendPacket(&data);
@@ -677,12 +675,10 @@ void WorldSession::HandleStablePet(WorldPacket & recv_data)
 
     // Find free slot for pet
     bool usedSlots[PET_SAVE_LAST_STABLE_SLOT - PET_SAVE_FIRST_STABLE_SLOT + 1] = {false};
-    CharPetMap const& pets = sCharacterDatabaseCache.GetCharPetsMap();
-    CharPetMap::const_iterator myPets = pets.find(GetPlayer()->GetGUIDLow());
-    if (myPets != pets.end())
-        for (CharPetVector::const_iterator it = myPets->second.begin(); it != myPets->second.end(); ++it)
-            if ((*it)->slot >= PET_SAVE_FIRST_STABLE_SLOT && (*it)->slot <= PET_SAVE_LAST_STABLE_SLOT)
-                usedSlots[(*it)->slot - PET_SAVE_FIRST_STABLE_SLOT] = true;
+    CharPetVector const pets = sCharacterDatabaseCache.GetCharacterPets(GetPlayer()->GetGUIDLow());
+    for (CharPetVector::const_iterator it = pets.begin(); it != pets.end(); ++it)
+        if ((*it)->slot >= PET_SAVE_FIRST_STABLE_SLOT && (*it)->slot <= PET_SAVE_LAST_STABLE_SLOT)
+            usedSlots[(*it)->slot - PET_SAVE_FIRST_STABLE_SLOT] = true;
 
     for (free_slot = PET_SAVE_FIRST_STABLE_SLOT; free_slot <= PET_SAVE_LAST_STABLE_SLOT && usedSlots[free_slot - PET_SAVE_FIRST_STABLE_SLOT]; ++free_slot);
 
@@ -713,7 +709,7 @@ void WorldSession::HandleUnstablePet(WorldPacket & recv_data)
 
     uint32 creature_id = 0;
 
-    CharacterPetCache const* petData = sCharacterDatabaseCache.GetCharacterPetCacheByOwnerAndId(_player->GetGUIDLow(), petnumber);
+    CharacterPetCachePtr petData = sCharacterDatabaseCache.GetCharacterPetCacheByOwnerAndId(_player->GetGUIDLow(), petnumber);
 
     if (!petData || petData->slot < PET_SAVE_FIRST_STABLE_SLOT || petData->slot > PET_SAVE_LAST_STABLE_SLOT)
     {
@@ -811,7 +807,7 @@ void WorldSession::HandleStableSwapPet(WorldPacket & recv_data)
     }
 
     // find swapped pet slot in stable
-    CharacterPetCache const* swappedPet = sCharacterDatabaseCache.GetCharacterPetCacheByOwnerAndId(_player->GetGUIDLow(), pet_number);
+    CharacterPetCachePtr swappedPet = sCharacterDatabaseCache.GetCharacterPetCacheByOwnerAndId(_player->GetGUIDLow(), pet_number);
     if (!swappedPet)
     {
         SendStableResult(STABLE_ERR_STABLE);
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "LoaderGraph.h"
+#include "Log.h"
+#include "Errors.h"
+#include <algorithm>
+#include <mutex>
+
+typedef std::chrono::steady_clock LoaderClock;
+
+static inline uint64 ElapsedUs(LoaderClock::time_point from, LoaderClock::time_point to)
+{
+    return uint64(std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+void LoaderGraph::Add(char const* name, Loader const& loader, std::initializer_list<char const*> dependencies)
+{
+    Node node;
+    node.name = name;
+    node.loader = loader;
+    node.pending = 0;
+    node.startUs = 0;
+    node.endUs = 0;
+
+    uint32 const index = m_nodes.size();
+    for (char const* dependency : dependencies)
+    {
+        uint32 found = 0;
+        while (found < index && m_nodes[found].name != dependency)
+            ++found;
+        MANGOS_ASSERT(found < index && "loader dependency must be added first");
+        node.dependencies.push_back(found);
+        m_nodes[found].dependents.push_back(index);
+    }
+    m_nodes.push_back(node);
+}
+
+void LoaderGraph::RunNode(uint32 index, LoaderClock::time_point origin)
+{
+    Node& node = m_nodes[index];
+    node.startUs = ElapsedUs(origin, LoaderClock::now());
+    node.loader();
+    node.endUs = ElapsedUs(origin, LoaderClock::now());
+}
+
+void LoaderGraph::Run(ThreadPool* pool)
+{
+    LoaderClock::time_point const origin = LoaderClock::now();
+
+    if (!pool)
+    {
+        for (uint32 i = 0; i < m_nodes.size(); ++i)
+            RunNode(i, origin);
+    }
+    else
+    {
+        for (Node& node : m_nodes)
+            node.pending = node.dependencies.size();
+
+        std::mutex lock;
+        TaskGroup group(pool);
+        std::function<void(uint32)> start = [&](uint32 index)
+        {
+            group.run([&, index]()
+            {
+                RunNode(index, origin);
+
+                std::vector<uint32> ready;
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    for (uint32 dependent : m_nodes[index].dependents)
+                        if (--m_nodes[dependent].pending == 0)
+                            ready.push_back(dependent);
+                }
+                for (uint32 dependent : ready)
+                    start(dependent);
+            });
+        };
+
+        for (uint32 i = 0; i < m_nodes.size(); ++i)
+            if (m_nodes[i].dependencies.empty())
+                start(i);
+        group.wait();
+    }
+
+    m_wallUs = ElapsedUs(origin, LoaderClock::now());
+}
+
+void LoaderGraph::LogTimeline() const
+{
+    if (m_nodes.empty())
+        return;
+
+    std::vector<uint32> order(m_nodes.size());
+    uint64 workUs = 0;
+    uint32 last = 0;
+    for (uint32 i = 0; i < m_nodes.size(); ++i)
+    {
+        order[i] = i;
+        workUs += m_nodes[i].endUs - m_nodes[i].startUs;
+        if (m_nodes[i].endUs > m_nodes[last].endUs)
+            last = i;
+    }
+    std::sort(order.begin(), order.end(), [this](uint32 a, uint32 b) { return m_nodes[a].startUs < m_nodes[b].startUs; });
+
+    sLog.outString("Startup loaders: %u ms elapsed for %u ms of loading", uint32(m_wallUs / 1000), uint32(workUs / 1000));
+    for (uint32 index : order)
+    {
+        Node const& node = m_nodes[index];
+        sLog.outString("  %7u ms +%6u ms  %s", uint32(node.startUs / 1000), uint32((node.endUs - node.startUs) / 1000), node.name.c_str());
+    }
+
+    // Walk back from the last loader to finish through the dependency that finished last
+    std::string chain = m_nodes[last].name;
+    for (uint32 current = last; !m_nodes[current].dependencies.empty();)
+    {
+        uint32 previous = m_nodes[current].dependencies.front();
+        for (uint32 dependency : m_nodes[current].dependencies)
+            if (m_nodes[dependency].endUs > m_nodes[previous].endUs)
+                previous = dependency;
+        chain = m_nodes[previous].name + " > " + chain;
+        current = previous;
+    }
+    sLog.outString("  longest chain: %s", chain.c_str());
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_LOADERGRAPH_H
+#define MANGOS_LOADERGRAPH_H
+
+#include "Platform/Define.h"
+#include "ThreadPool.h"
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+/**
+ * Startup loaders and the loaders they must wait for.
+ * With a pool, a loader starts as soon as all of its dependencies are done.
+ * Dependencies must be added before the loaders needing them, so the order of
+ * declaration is always a valid order to run them one by one without pool.
+ */
+class LoaderGraph
+{
+    public:
+        typedef std::function<void()> Loader;
+
+        LoaderGraph() : m_wallUs(0) {}
+
+        void Add(char const* name, Loader const& loader, std::initializer_list<char const*> dependencies = {});
+        void Run(ThreadPool* pool);
+
+        // Start and end of each loader, and the chain of loaders that took the longest
+        void LogTimeline() const;
+
+    private:
+        struct Node
+        {
+            std::string name;
+            Loader loader;
+            std::vector<uint32> dependencies;
+            std::vector<uint32> dependents;
+            uint32 pending;
+            uint64 startUs;
+            uint64 endUs;
+        };
+
+        void RunNode(uint32 index, std::chrono::steady_clock::time_point origin);
+
+        std::vector<Node> m_nodes;
+        uint64 m_wallUs;
+};
+
+#endif
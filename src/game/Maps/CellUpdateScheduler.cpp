@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "CellUpdateScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// Regions created per worker, so that work stealing can compensate a bad estimation
+#define REGIONS_PER_THREAD 4
+
+CellUpdateScheduler::CellUpdateScheduler(uint32 cellsPerSide) : m_cellsPerSide(cellsPerSide),
+    m_tileSize(0), m_tilesPerSide(0), m_defaultCostPerCell(1), m_lastRegionsCount(0), m_lastMaxConcurrency(0)
+{
+}
+
+void CellUpdateScheduler::AddCell(uint32 cellX, uint32 cellY)
+{
+    m_cells.push_back((cellY << 16) | cellX);
+}
+
+void CellUpdateScheduler::ResizeTiles(uint32 tileSize)
+{
+    if (!tileSize)
+        tileSize = 1;
+    if (tileSize == m_tileSize)
+        return;
+
+    m_tileSize = tileSize;
+    m_tilesPerSide = (m_cellsPerSide + tileSize - 1) / tileSize;
+    m_tiles.clear();
+    m_tiles.resize(m_tilesPerSide * m_tilesPerSide);
+}
+
+uint64 CellUpdateScheduler::EstimatedCost(uint32 tileX, uint32 tileY) const
+{
+    Tile const& tile = m_tiles[tileY * m_tilesPerSide + tileX];
+    return uint64(tile.cells.size()) * (tile.costPerCell ? tile.costPerCell : m_defaultCostPerCell);
+}
+
+uint64 CellUpdateScheduler::RectCost(uint32 lowX, uint32 lowY, uint32 highX, uint32 highY) const
+{
+    uint64 cost = 0;
+    for (uint32 y = lowY; y <= highY; ++y)
+        for (uint32 x = lowX; x <= highX; ++x)
+            cost += EstimatedCost(x, y);
+    return cost;
+}
+
+void CellUpdateScheduler::Split(uint32 lowX, uint32 lowY, uint32 highX, uint32 highY, uint64 target)
+{
+    // Shrink to the active part of the rectangle, it reduces the conflicts with other regions
+    uint32 minX = highX, minY = highY, maxX = lowX, maxY = lowY;
+    bool active = false;
+    for (uint32 y = lowY; y <= highY; ++y)
+        for (uint32 x = lowX; x <= highX; ++x)
+            if (!m_tiles[y * m_tilesPerSide + x].cells.empty())
+            {
+                minX = std::min(minX, x);
+                minY = std::min(minY, y);
+                maxX = std::max(maxX, x);
+                maxY = std::max(maxY, y);
+                active = true;
+            }
+    if (!active)
+        return;
+
+    uint64 cost = RectCost(minX, minY, maxX, maxY);
+    if (cost <= target || (minX == maxX && minY == maxY))
+    {
+        Region region;
+        region.lowX = minX;
+        region.lowY = minY;
+        region.highX = maxX;
+        region.highY = maxY;
+        region.cost = cost;
+        m_regions.push_back(region);
+        return;
+    }
+
+    // Cut the longest side where half of the cost is reached
+    bool alongX = (maxX - minX) >= (maxY - minY);
+    uint32 low = alongX ? minX : minY;
+    uint32 high = alongX ? maxX : maxY;
+    uint32 cut = low;
+    uint64 accumulated = 0;
+    for (; cut < high - 1; ++cut)
+    {
+        accumulated += alongX ? RectCost(cut, minY, cut, maxY) : RectCost(minX, cut, maxX, cut);
+        if (accumulated * 2 >= cost)
+            break;
+    }
+
+    if (alongX)
+    {
+        Split(minX, minY, cut, maxY, target);
+        Split(cut + 1, minY, maxX, maxY, target);
+    }
+    else
+    {
+        Split(minX, minY, maxX, cut, target);
+        Split(minX, cut + 1, maxX, maxY, target);
+    }
+}
+
+void CellUpdateScheduler::BuildConflicts()
+{
+    // Regions conflict when their rectangles, grown by one tile, overlap
+    for (uint32 i = 0; i < m_regions.size(); ++i)
+    {
+        Region& a = m_regions[i];
+        for (uint32 j = i + 1; j < m_regions.size(); ++j)
+        {
+            Region& b = m_regions[j];
+            if (a.lowX > b.highX + 1 || b.lowX > a.highX + 1)
+                continue;
+            if (a.lowY > b.highY + 1 || b.lowY > a.highY + 1)
+                continue;
+            a.conflicts.push_back(j);
+            b.conflicts.push_back(i);
+        }
+    }
+}
+
+void CellUpdateScheduler::UpdateRegion(Region const& region, CellUpdater const& updater)
+{
+    for (uint32 y = region.lowY; y <= region.highY; ++y)
+        for (uint32 x = region.lowX; x <= region.highX; ++x)
+        {
+            Tile& tile = m_tiles[y * m_tilesPerSide + x];
+            if (tile.cells.empty())
+                continue;
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (uint32 cell : tile.cells)
+                updater(cell & 0xFFFF, cell >> 16);
+            tile.measuredUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+}
+
+void CellUpdateScheduler::Run(ThreadPool* pool, TaskPhaseStats* stats, uint32 threads, uint32 tileSize, CellUpdater const& updater)
+{
+    m_regions.clear();
+    m_lastRegionsCount = 0;
+    m_lastMaxConcurrency = 0;
+    if (m_cells.empty())
+        return;
+    if (!threads)
+        threads = 1;
+
+    ResizeTiles(tileSize);
+    for (uint32 cell : m_cells)
+    {
+        uint32 tileId = ((cell >> 16) / m_tileSize) * m_tilesPerSide + (cell & 0xFFFF) / m_tileSize;
+        Tile& tile = m_tiles[tileId];
+        if (tile.cells.empty())
+            m_activeTiles.push_back(tileId);
+        tile.cells.push_back(cell);
+    }
+    m_cells.clear();
+
+    uint32 minX = m_tilesPerSide, minY = m_tilesPerSide, maxX = 0, maxY = 0;
+    uint64 totalCost = 0;
+    for (uint32 tileId : m_activeTiles)
+    {
+        uint32 x = tileId % m_tilesPerSide;
+        uint32 y = tileId / m_tilesPerSide;
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+        totalCost += EstimatedCost(x, y);
+    }
+    Split(minX, minY, maxX, maxY, std::max<uint64>(totalCost / (threads * REGIONS_PER_THREAD), 1));
+    BuildConflicts();
+
+    std::vector<uint32> order(m_regions.size());
+    for (uint32 i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [this](uint32 a, uint32 b) { return m_regions[a].cost > m_regions[b].cost; });
+
+    std::mutex lock;
+    std::condition_variable regionFinished;
+    std::vector<uint32> blockers(m_regions.size(), 0);
+    std::vector<bool> started(m_regions.size(), false);
+    size_t notStarted = m_regions.size();
+    uint32 running = 0;
+
+    auto worker = [&]()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true)
+        {
+            int32 picked = -1;
+            regionFinished.wait(guard, [&]()
+            {
+                if (!notStarted)
+                    return true;
+                for (uint32 idx : order)
+                    if (!started[idx] && !blockers[idx])
+                    {
+                        picked = idx;
+                        return true;
+                    }
+                return false;
+            });
+            if (picked < 0)
+                return;
+
+            Region const& region = m_regions[picked];
+            started[picked] = true;
+            --notStarted;
+            for (uint32 other : region.conflicts)
+                ++blockers[other];
+            m_lastMaxConcurrency = std::max(m_lastMaxConcurrency, ++running);
+
+            guard.unlock();
+            UpdateRegion(region, updater);
+            guard.lock();
+
+            for (uint32 other : region.conflicts)
+                --blockers[other];
+            --running;
+            regionFinished.notify_all();
+        }
+    };
+
+    {
+        TaskGroup group(pool, stats);
+        uint32 workers = std::min<uint32>(threads, m_regions.size());
+        for (uint32 i = 0; i < workers; ++i)
+            group.run(worker);
+        group.wait();
+    }
+    m_lastRegionsCount = m_regions.size();
+
+    // Keep the measures for the next tick
+    uint64 measuredUs = 0;
+    uint64 measuredCells = 0;
+    for (uint32 tileId : m_activeTiles)
+    {
+        Tile& tile = m_tiles[tileId];
+        uint32 cost = std::max<uint32>(tile.measuredUs / tile.cells.size(), 1);
+        tile.costPerCell = tile.costPerCell ? (tile.costPerCell + cost) / 2 : cost;
+        measuredUs += tile.measuredUs;
+        measuredCells += tile.cells.size();
+        tile.measuredUs = 0;
+        tile.cells.clear();
+    }
+    m_activeTiles.clear();
+    m_defaultCostPerCell = std::max<uint32>(measuredUs / measuredCells, 1);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_CELLUPDATESCHEDULER_H
+#define MANGOS_CELLUPDATESCHEDULER_H
+
+#include "Platform/Define.h"
+#include "ThreadPool.h"
+#include <functional>
+#include <vector>
+
+/**
+ * Parallel update of the active cells of a continent.
+ *
+ * The map is cut in square tiles whose side is the configured safe distance.
+ * Active tiles are grouped in rectangular regions by bisecting the active area
+ * at its cost-weighted median, the cost of a tile being the time its cells took
+ * to update during the previous tick. Two regions are never updated at the same
+ * time if any of their tiles touch each other, so cells updated concurrently
+ * are always at least the safe distance apart. There is no fixed step: a region
+ * starts as soon as no neighbouring region is running, most expensive first.
+ */
+class CellUpdateScheduler
+{
+    public:
+        typedef std::function<void(uint32 cellX, uint32 cellY)> CellUpdater;
+
+        CellUpdateScheduler(uint32 cellsPerSide);
+
+        // Registers a cell to update this tick. Each cell must be added only once.
+        void AddCell(uint32 cellX, uint32 cellY);
+
+        // Updates all added cells using up to 'threads' workers, then forgets them
+        void Run(ThreadPool* pool, TaskPhaseStats* stats, uint32 threads, uint32 tileSize, CellUpdater const& updater);
+
+        uint32 GetLastRegionsCount() const { return m_lastRegionsCount; }
+        uint32 GetLastMaxConcurrency() const { return m_lastMaxConcurrency; }
+
+    private:
+        struct Tile
+        {
+            Tile() : costPerCell(0), measuredUs(0) {}
+            std::vector<uint32> cells;
+            uint32 costPerCell;                             // microseconds, smoothed over the previous ticks
+            uint64 measuredUs;
+        };
+
+        struct Region
+        {
+            uint32 lowX, lowY, highX, highY;                // tiles, inclusive
+            uint64 cost;
+            std::vector<uint32> conflicts;                  // regions that must not run at the same time
+        };
+
+        void ResizeTiles(uint32 tileSize);
+        uint64 EstimatedCost(uint32 tileX, uint32 tileY) const;
+        uint64 RectCost(uint32 lowX, uint32 lowY, uint32 highX, uint32 highY) const;
+        void Split(uint32 lowX, uint32 lowY, uint32 highX, uint32 highY, uint64 target);
+        void BuildConflicts();
+        void UpdateRegion(Region const& region, CellUpdater const& updater);
+
+        uint32 const m_cellsPerSide;
+        std::vector<uint32> m_cells;                        // added this tick, packed (y << 16 | x)
+        uint32 m_tileSize;
+        uint32 m_tilesPerSide;
+        std::vector<Tile> m_tiles;
+        std::vector<uint32> m_activeTiles;
+        std::vector<Region> m_regions;
+        uint32 m_defaultCostPerCell;
+
+        uint32 m_lastRegionsCount;
+        uint32 m_lastMaxConcurrency;
+};
+
+#endif
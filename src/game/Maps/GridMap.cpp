@@ -30,6 +30,7 @@
 #include "Policies/SingletonImp.h"
 #include "Util.h"
 #include "SQLStorages.h"
+#include "ace/OS_NS_unistd.h"
 
 char const* MAP_MAGIC         = "MAPS";
 char const* MAP_VERSION_MAGIC = "z1.3";
@@ -62,6 +63,8 @@ GridMap::GridMap()
     m_liquidFlags = NULL;
     m_liquidEntry = NULL;
     m_liquid_map  = NULL;
+
+    m_mappedFile = NULL;
 }
 
 GridMap::~GridMap()
@@ -74,122 +77,160 @@ bool GridMap::loadData(char* filename)
     // Unload old data if exist
     unloadData();
 
-    GridMapFileHeader header;
     // Not return error if file not found
-    FILE* in = fopen(filename, "rb");
-    if (!in)
+    if (ACE_OS::access(filename, R_OK) == -1)
         return true;
 
-    fread(&header, sizeof(header), 1, in);
-    if (header.mapMagic     == *((uint32 const*)(MAP_MAGIC)) &&
+    m_mappedFile = new ACE_Mem_Map();
+    if (m_mappedFile->map(filename, static_cast<size_t>(-1), O_RDONLY, ACE_DEFAULT_FILE_PERMS, PROT_READ, ACE_MAP_PRIVATE) == -1)
+    {
+        sLog.outError("Unable to map file '%s' in memory.", filename);
+        delete m_mappedFile;
+        m_mappedFile = NULL;
+        return false;
+    }
+    // The mapping stays valid without the descriptor, thousands of grids can be loaded
+    m_mappedFile->close_handle();
+
+    GridMapFileHeader header;
+    if (readMapped(&header, 0, sizeof(header)) &&
+            header.mapMagic     == *((uint32 const*)(MAP_MAGIC)) &&
             header.versionMagic == *((uint32 const*)(MAP_VERSION_MAGIC)))
     {
         // loadup area data
-        if (header.areaMapOffset && !loadAreaData(in, header.areaMapOffset, header.areaMapSize))
+        if (header.areaMapOffset && !loadAreaData(header.areaMapOffset, header.areaMapSize))
         {
             sLog.outError("Error loading map area data\n");
-            fclose(in);
+            unloadData();
             return false;
         }
 
         // loadup height data
-        if (header.heightMapOffset && !loadHeightData(in, header.heightMapOffset, header.heightMapSize))
+        if (header.heightMapOffset && !loadHeightData(header.heightMapOffset, header.heightMapSize))
         {
             sLog.outError("Error loading map height data\n");
-            fclose(in);
+            unloadData();
             return false;
         }
 
         // loadup liquid data
-        if (header.liquidMapOffset && !loadGridMapLiquidData(in, header.liquidMapOffset, header.liquidMapSize))
+        if (header.liquidMapOffset && !loadGridMapLiquidData(header.liquidMapOffset, header.liquidMapSize))
         {
             sLog.outError("Error loading map liquids data\n");
-            fclose(in);
+            unloadData();
             return false;
         }
 
-        fclose(in);
         return true;
     }
 
     sLog.outError("Map file '%s' is non-compatible version (outdated?). Please, create new using ad.exe program.", filename);
-    fclose(in);
+    unloadData();
     return false;
 }
 
 void GridMap::unloadData()
 {
-    delete[] m_area_map;
-    delete[] m_V9;
-    delete[] m_V8;
-    delete[] m_liquidEntry;
-    delete[] m_liquidFlags;
-    delete[] m_liquid_map;
-
-    m_area_map = NULL;
-    m_V9 = NULL;
-    m_V8 = NULL;
-    m_liquidEntry = NULL;
-    m_liquidFlags = NULL;
-    m_liquid_map  = NULL;
+    unmapArray(m_area_map);
+    unmapArray(m_V9);
+    unmapArray(m_V8);
+    unmapArray(m_liquidEntry);
+    unmapArray(m_liquidFlags);
+    unmapArray(m_liquid_map);
     m_gridGetHeight = &GridMap::getHeightFromFlat;
+
+    delete m_mappedFile;
+    m_mappedFile = NULL;
+}
+
+bool GridMap::readMapped(void* dest, uint32 offset, uint32 size) const
+{
+    if (uint64(offset) + size > m_mappedFile->size())
+        return false;
+
+    memcpy(dest, static_cast<uint8 const*>(m_mappedFile->addr()) + offset, size);
+    return true;
+}
+
+// Points into the mapped file, or into a copy when the data is not aligned for T. NULL if out of the file.
+template<typename T>
+T* GridMap::mapArray(uint32 offset, uint32 count)
+{
+    if (uint64(offset) + uint64(count) * sizeof(T) > m_mappedFile->size())
+        return NULL;
+
+    uint8* data = static_cast<uint8*>(m_mappedFile->addr()) + offset;
+    if (reinterpret_cast<uintptr_t>(data) % alignof(T) == 0)
+        return reinterpret_cast<T*>(data);
+
+    T* copy = new T[count];
+    memcpy(copy, data, count * sizeof(T));
+    return copy;
 }
 
-bool GridMap::loadAreaData(FILE* in, uint32 offset, uint32 /*size*/)
+template<typename T>
+void GridMap::unmapArray(T*& array)
+{
+    uint8 const* data = reinterpret_cast<uint8 const*>(array);
+    uint8 const* begin = m_mappedFile ? static_cast<uint8 const*>(m_mappedFile->addr()) : NULL;
+    if (!begin || data < begin || data >= begin + m_mappedFile->size())
+        delete[] array;
+    array = NULL;
+}
+
+bool GridMap::loadAreaData(uint32 offset, uint32 /*size*/)
 {
     GridMapAreaHeader header;
-    fseek(in, offset, SEEK_SET);
-    fread(&header, sizeof(header), 1, in);
+    if (!readMapped(&header, offset, sizeof(header)))
+        return false;
     if (header.fourcc != *((uint32 const*)(MAP_AREA_MAGIC)))
         return false;
 
     m_gridArea = header.gridArea;
     if (!(header.flags & MAP_AREA_NO_AREA))
     {
-        m_area_map = new uint16 [16 * 16];
-        fread(m_area_map, sizeof(uint16), 16 * 16, in);
+        m_area_map = mapArray<uint16>(offset + sizeof(header), 16 * 16);
+        if (!m_area_map)
+            return false;
     }
 
     return true;
 }
 
-bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
+bool GridMap::loadHeightData(uint32 offset, uint32 /*size*/)
 {
     GridMapHeightHeader header;
-    fseek(in, offset, SEEK_SET);
-    fread(&header, sizeof(header), 1, in);
+    if (!readMapped(&header, offset, sizeof(header)))
+        return false;
     if (header.fourcc != *((uint32 const*)(MAP_HEIGHT_MAGIC)))
         return false;
 
+    offset += sizeof(header);
     m_gridHeight = header.gridHeight;
     if (!(header.flags & MAP_HEIGHT_NO_HEIGHT))
     {
         if ((header.flags & MAP_HEIGHT_AS_INT16))
         {
-            m_uint16_V9 = new uint16 [129 * 129];
-            m_uint16_V8 = new uint16 [128 * 128];
-            fread(m_uint16_V9, sizeof(uint16), 129 * 129, in);
-            fread(m_uint16_V8, sizeof(uint16), 128 * 128, in);
+            m_uint16_V9 = mapArray<uint16>(offset, 129 * 129);
+            m_uint16_V8 = mapArray<uint16>(offset + sizeof(uint16) * 129 * 129, 128 * 128);
             m_gridIntHeightMultiplier = (header.gridMaxHeight - header.gridHeight) / 65535;
             m_gridGetHeight = &GridMap::getHeightFromUint16;
         }
         else if ((header.flags & MAP_HEIGHT_AS_INT8))
         {
-            m_uint8_V9 = new uint8 [129 * 129];
-            m_uint8_V8 = new uint8 [128 * 128];
-            fread(m_uint8_V9, sizeof(uint8), 129 * 129, in);
-            fread(m_uint8_V8, sizeof(uint8), 128 * 128, in);
+            m_uint8_V9 = mapArray<uint8>(offset, 129 * 129);
+            m_uint8_V8 = mapArray<uint8>(offset + sizeof(uint8) * 129 * 129, 128 * 128);
             m_gridIntHeightMultiplier = (header.gridMaxHeight - header.gridHeight) / 255;
             m_gridGetHeight = &GridMap::getHeightFromUint8;
         }
         else
         {
-            m_V9 = new float [129 * 129];
-            m_V8 = new float [128 * 128];
-            fread(m_V9, sizeof(float), 129 * 129, in);
-            fread(m_V8, sizeof(float), 128 * 128, in);
+            m_V9 = mapArray<float>(offset, 129 * 129);
+            m_V8 = mapArray<float>(offset + sizeof(float) * 129 * 129, 128 * 128);
             m_gridGetHeight = &GridMap::getHeightFromFloat;
         }
+        if (!m_V9 || !m_V8)
+            return false;
     }
     else
         m_gridGetHeight = &GridMap::getHeightFromFlat;
@@ -197,11 +238,11 @@ bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
     return true;
 }
 
-bool GridMap::loadGridMapLiquidData(FILE* in, uint32 offset, uint32 /*size*/)
+bool GridMap::loadGridMapLiquidData(uint32 offset, uint32 /*size*/)
 {
     GridMapLiquidHeader header;
-    fseek(in, offset, SEEK_SET);
-    fread(&header, sizeof(header), 1, in);
+    if (!readMapped(&header, offset, sizeof(header)))
+        return false;
     if (header.fourcc != *((uint32 const*)(MAP_LIQUID_MAGIC)))
         return false;
 
@@ -212,19 +253,24 @@ bool GridMap::loadGridMapLiquidData(FILE* in, uint32 offset, uint32 /*size*/)
     m_liquid_height = header.height;
     m_liquidLevel   = header.liquidLevel;
 
+    offset += sizeof(header);
     if (!(header.flags & MAP_LIQUID_NO_TYPE))
     {
-        m_liquidEntry = new uint16[16 * 16];
-        fread(m_liquidEntry, sizeof(uint16), 16 * 16, in);
+        m_liquidEntry = mapArray<uint16>(offset, 16 * 16);
+        offset += sizeof(uint16) * 16 * 16;
+
+        m_liquidFlags = mapArray<uint8>(offset, 16 * 16);
+        offset += sizeof(uint8) * 16 * 16;
 
-        m_liquidFlags = new uint8[16 * 16];
-        fread(m_liquidFlags, sizeof(uint8), 16 * 16, in);
+        if (!m_liquidEntry || !m_liquidFlags)
+            return false;
     }
 
     if (!(header.flags & MAP_LIQUID_NO_HEIGHT))
     {
-        m_liquid_map = new float [m_liquid_width * m_liquid_height];
-        fread(m_liquid_map, sizeof(float), m_liquid_width * m_liquid_height, in);
+        m_liquid_map = mapArray<float>(offset, m_liquid_width * m_liquid_height);
+        if (!m_liquid_map)
+            return false;
     }
 
     return true;
@@ -20,6 +20,7 @@
 #define MANGOS_GRIDMAP_H
 
 #include "Platform/Define.h"
+#include "ace/Mem_Map.h"
 #include "Policies/Singleton.h"
 #include "DBCStructure.h"
 #include "GridDefines.h"
@@ -154,9 +155,16 @@ class GridMap
         uint8* m_liquidFlags;
         float* m_liquid_map;
 
-        bool loadAreaData(FILE* in, uint32 offset, uint32 size);
-        bool loadHeightData(FILE* in, uint32 offset, uint32 size);
-        bool loadGridMapLiquidData(FILE* in, uint32 offset, uint32 size);
+        // The map file is mapped read-only, its pages are loaded on demand and shared with the other readers
+        ACE_Mem_Map* m_mappedFile;
+
+        bool loadAreaData(uint32 offset, uint32 size);
+        bool loadHeightData(uint32 offset, uint32 size);
+        bool loadGridMapLiquidData(uint32 offset, uint32 size);
+
+        bool readMapped(void* dest, uint32 offset, uint32 size) const;
+        template<typename T> T* mapArray(uint32 offset, uint32 count);
+        template<typename T> void unmapArray(T*& array);
 
         // Get height functions and pointers
         typedef float(GridMap::*pGetHeightPtr)(float x, float y) const;
@@ -33,6 +33,8 @@
 #include "PlayerBroadcaster.h"
 #include "World.h"
 
+#include <algorithm>
+
 using namespace MaNGOS;
 
 void
@@ -42,10 +44,45 @@ VisibleChangesNotifier::Visit(CameraMapType &m)
         iter->getSource()->UpdateVisibilityOf(&i_object);
 }
 
+void
+VisibleNotifier::SetIncremental(float oldX, float oldY, float visibilityDistance)
+{
+    i_incremental = true;
+    i_oldX = oldX;
+    i_oldY = oldY;
+    i_insideSq = visibilityDistance * visibilityDistance;
+    i_outside = visibilityDistance + std::max(World::GetVisibleUnitGreyDistance(), World::GetVisibleObjectGreyDistance()) +
+                i_camera.GetBody()->GetObjectBoundingRadius();
+}
+
+bool
+VisibleNotifier::IsUnchangedByMove(WorldObject const* target) const
+{
+    WorldObject const* viewPoint = i_camera.GetBody();
+    float dx = target->GetPositionX() - i_oldX;
+    float dy = target->GetPositionY() - i_oldY;
+    float oldDistSq = dx * dx + dy * dy;
+    dx = target->GetPositionX() - viewPoint->GetPositionX();
+    dy = target->GetPositionY() - viewPoint->GetPositionY();
+    float newDistSq = dx * dx + dy * dy;
+
+    // Within visibility distance from both positions: only the distance depends on the viewpoint position
+    if (oldDistSq <= i_insideSq && newDistSq <= i_insideSq)
+        return true;
+
+    // Beyond the grey distance from both positions, and not at client
+    float outside = i_outside + target->GetVisibilityModifier() + target->GetObjectBoundingRadius();
+    outside *= outside;
+    return oldDistSq > outside && newDistSq > outside && i_clientGUIDs.find(target->GetObjectGuid()) == i_clientGUIDs.end();
+}
+
 void
 VisibleNotifier::Notify()
 {
     Player& player = *i_camera.GetOwner();
+    std::sort(i_visitedGUIDs.begin(), i_visitedGUIDs.end());
+    i_clientGUIDs.EraseSorted(i_visitedGUIDs);
+
     // at this moment i_clientGUIDs have guids that not iterate at grid level checks
     // but exist one case when this possible and object not out of range: transports
     if (Transport* transport = player.GetTransport())
@@ -104,8 +141,8 @@ VisibleNotifier::Notify()
         i_data.Send(player.GetSession());
 
         // send out of range to other players if need
-        ObjectGuidSet const& oor = i_data.GetOutOfRangeGUIDs();
-        for (ObjectGuidSet::const_iterator iter = oor.begin(); iter != oor.end(); ++iter)
+        std::vector<ObjectGuid> const& oor = i_data.GetOutOfRangeGUIDs();
+        for (std::vector<ObjectGuid>::const_iterator iter = oor.begin(); iter != oor.end(); ++iter)
         {
             if (!iter->IsPlayer())
                 continue;
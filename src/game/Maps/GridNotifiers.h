@@ -44,12 +44,25 @@ namespace MaNGOS
     {
         Camera& i_camera;
         UpdateData i_data;
-        ObjectGuidSet i_clientGUIDs;
-        std::set<WorldObject*> i_visibleNow;
-
-        explicit VisibleNotifier(Camera &c) : i_camera(c), i_clientGUIDs(c.GetOwner()->m_visibleGUIDs) {}
+        ObjectGuidSortedSet i_clientGUIDs;
+        std::vector<ObjectGuid> i_visitedGUIDs;
+        std::vector<WorldObject*> i_visibleNow;
+        uint32 i_evaluated;
+        uint32 i_skipped;
+
+        // Incremental mode: objects whose distance to the viewpoint cannot have crossed the visibility
+        // range between the previous and the current position keep their state without evaluation.
+        bool i_incremental;
+        float i_oldX, i_oldY;
+        float i_insideSq;
+        float i_outside;
+
+        explicit VisibleNotifier(Camera &c) : i_camera(c), i_clientGUIDs(c.GetOwner()->m_visibleGUIDs),
+            i_evaluated(0), i_skipped(0), i_incremental(false), i_oldX(0.0f), i_oldY(0.0f), i_insideSq(0.0f), i_outside(0.0f) {}
+        void SetIncremental(float oldX, float oldY, float visibilityDistance);
         template<class T> void Visit(GridRefManager<T> &m);
         void Visit(CameraMapType&) {}
+        bool IsUnchangedByMove(WorldObject const* target) const;
         void Notify(void);
     };
 
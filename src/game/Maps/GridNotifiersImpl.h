@@ -39,8 +39,14 @@ inline void MaNGOS::VisibleNotifier::Visit(GridRefManager<T> &m)
 {
     for(typename GridRefManager<T>::iterator iter = m.begin(); iter != m.end(); ++iter)
     {
-        i_camera.UpdateVisibilityOf(iter->getSource(), i_data, i_visibleNow);
-        i_clientGUIDs.erase(iter->getSource()->GetObjectGuid());
+        if (i_incremental && IsUnchangedByMove(iter->getSource()))
+            ++i_skipped;
+        else
+        {
+            i_camera.UpdateVisibilityOf(iter->getSource(), i_data, i_visibleNow);
+            ++i_evaluated;
+        }
+        i_visitedGUIDs.push_back(iter->getSource()->GetObjectGuid());
     }
 }
 
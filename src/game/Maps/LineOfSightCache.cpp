@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "LineOfSightCache.h"
+#include <algorithm>
+#include <cmath>
+
+// Size of the grid positions are snapped to, in yards
+#define LOS_CACHE_PRECISION     0.5f
+// Side of the invalidation regions, in yards
+#define LOS_CACHE_REGION_SIZE   32.0f
+// Longer rays are not cached, checking their regions would cost too much
+#define LOS_CACHE_MAX_RAY_REGIONS 16
+// Bigger changes invalidate the whole cache
+#define LOS_CACHE_MAX_CHANGE_REGIONS 64
+
+static inline int32 SnapPosition(float value)
+{
+    return int32(std::floor(value / LOS_CACHE_PRECISION));
+}
+
+static inline int32 RegionOf(float value)
+{
+    return int32(std::floor(value / LOS_CACHE_REGION_SIZE));
+}
+
+// Regions covered by the snapping cells lowCell to highCell
+static inline void CellsToRegions(int32 lowCell, int32 highCell, int32& lowRegion, int32& highRegion)
+{
+    lowRegion = RegionOf(lowCell * LOS_CACHE_PRECISION);
+    highRegion = RegionOf((highCell + 1) * LOS_CACHE_PRECISION);
+}
+
+static inline void RaiseTo(std::atomic<uint32>& value, uint32 target)
+{
+    uint32 current = value.load(std::memory_order_relaxed);
+    while (current < target && !value.compare_exchange_weak(current, target, std::memory_order_release))
+        ;
+}
+
+LineOfSightCache::LineOfSightCache() : m_epoch(0), m_clearEpoch(0), m_hits(0), m_misses(0), m_invalidated(0), m_expired(0)
+{
+    for (std::atomic<uint32>& regionEpoch : m_regionEpochs)
+        regionEpoch = 0;
+}
+
+size_t LineOfSightCache::KeyHash::operator()(Key const& key) const
+{
+    size_t hash = key.checkDynLos ? 1 : 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        hash ^= std::hash<int32>()(key.from[i]) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        hash ^= std::hash<int32>()(key.to[i]) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+bool LineOfSightCache::MakeKey(float x1, float y1, float z1, float x2, float y2, float z2, bool checkDynLos, Key& key)
+{
+    int32 a[3] = { SnapPosition(x1), SnapPosition(y1), SnapPosition(z1) };
+    int32 b[3] = { SnapPosition(x2), SnapPosition(y2), SnapPosition(z2) };
+    bool swap = std::lexicographical_compare(b, b + 3, a, a + 3);
+    std::copy(swap ? b : a, (swap ? b : a) + 3, key.from);
+    std::copy(swap ? a : b, (swap ? a : b) + 3, key.to);
+    key.checkDynLos = checkDynLos;
+
+    int32 lowX, highX, lowY, highY;
+    CellsToRegions(std::min(a[0], b[0]), std::max(a[0], b[0]), lowX, highX);
+    CellsToRegions(std::min(a[1], b[1]), std::max(a[1], b[1]), lowY, highY);
+    return (highX - lowX + 1) * (highY - lowY + 1) <= LOS_CACHE_MAX_RAY_REGIONS;
+}
+
+uint32 LineOfSightCache::RegionSlot(int32 regionX, int32 regionY)
+{
+    return (uint32(regionX) * 73856093u ^ uint32(regionY) * 19349663u) % REGION_SLOTS;
+}
+
+bool LineOfSightCache::IsRegionChangedSince(Key const& key, uint32 epoch) const
+{
+    if (m_clearEpoch.load(std::memory_order_acquire) > epoch)
+        return true;
+
+    int32 lowX, highX, lowY, highY;
+    CellsToRegions(std::min(key.from[0], key.to[0]), std::max(key.from[0], key.to[0]), lowX, highX);
+    CellsToRegions(std::min(key.from[1], key.to[1]), std::max(key.from[1], key.to[1]), lowY, highY);
+    for (int32 x = lowX; x <= highX; ++x)
+        for (int32 y = lowY; y <= highY; ++y)
+            if (m_regionEpochs[RegionSlot(x, y)].load(std::memory_order_acquire) > epoch)
+                return true;
+    return false;
+}
+
+LineOfSightCache::Shard& LineOfSightCache::GetShard(Key const& key)
+{
+    return m_shards[KeyHash()(key) % SHARDS];
+}
+
+bool LineOfSightCache::Find(float x1, float y1, float z1, float x2, float y2, float z2, bool checkDynLos, uint32 now, bool& result)
+{
+    Key key;
+    if (!MakeKey(x1, y1, z1, x2, y2, z2, checkDynLos, key))
+        return false;
+
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end())
+    {
+        ++m_misses;
+        return false;
+    }
+    if (int32(now - it->second.expireTime) >= 0)
+    {
+        shard.entries.erase(it);
+        ++m_expired;
+        return false;
+    }
+    if (IsRegionChangedSince(key, it->second.epoch))
+    {
+        shard.entries.erase(it);
+        ++m_invalidated;
+        return false;
+    }
+
+    result = it->second.result;
+    ++m_hits;
+    return true;
+}
+
+void LineOfSightCache::Insert(float x1, float y1, float z1, float x2, float y2, float z2, bool checkDynLos, uint32 epoch, uint32 now, uint32 lifetime, uint32 maxEntries, bool result)
+{
+    Key key;
+    if (!lifetime || !maxEntries || !MakeKey(x1, y1, z1, x2, y2, z2, checkDynLos, key))
+        return;
+
+    uint32 shardCapacity = std::max<uint32>(maxEntries / SHARDS, 1);
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    if (shard.entries.size() >= shardCapacity && shard.entries.find(key) == shard.entries.end())
+    {
+        // Make room with the expired results first, then start again
+        for (auto it = shard.entries.begin(); it != shard.entries.end();)
+        {
+            if (int32(now - it->second.expireTime) >= 0)
+                it = shard.entries.erase(it);
+            else
+                ++it;
+        }
+        if (shard.entries.size() >= shardCapacity)
+            shard.entries.clear();
+    }
+
+    Entry& entry = shard.entries[key];
+    entry.epoch = epoch;
+    entry.expireTime = now + lifetime;
+    entry.result = result;
+}
+
+void LineOfSightCache::Invalidate(float minX, float minY, float maxX, float maxY)
+{
+    uint32 epoch = m_epoch.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+    int32 lowX = RegionOf(minX), highX = RegionOf(maxX);
+    int32 lowY = RegionOf(minY), highY = RegionOf(maxY);
+    if (lowX > highX || lowY > highY || int64(highX - lowX + 1) * (highY - lowY + 1) > LOS_CACHE_MAX_CHANGE_REGIONS)
+    {
+        RaiseTo(m_clearEpoch, epoch);
+        return;
+    }
+
+    for (int32 x = lowX; x <= highX; ++x)
+        for (int32 y = lowY; y <= highY; ++y)
+            RaiseTo(m_regionEpochs[RegionSlot(x, y)], epoch);
+}
+
+void LineOfSightCache::Clear()
+{
+    RaiseTo(m_clearEpoch, m_epoch.fetch_add(1, std::memory_order_acq_rel) + 1);
+    for (Shard& shard : m_shards)
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.entries.clear();
+    }
+}
+
+LineOfSightCacheStats LineOfSightCache::GetStats()
+{
+    LineOfSightCacheStats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.invalidated = m_invalidated;
+    stats.expired = m_expired;
+    stats.entries = 0;
+    for (Shard& shard : m_shards)
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        stats.entries += shard.entries.size();
+    }
+    return stats;
+}
+
+void LineOfSightCache::ResetStats()
+{
+    m_hits = 0;
+    m_misses = 0;
+    m_invalidated = 0;
+    m_expired = 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_LINEOFSIGHTCACHE_H
+#define MANGOS_LINEOFSIGHTCACHE_H
+
+#include "Platform/Define.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+struct LineOfSightCacheStats
+{
+    uint64 hits;
+    uint64 misses;
+    uint64 invalidated;                                     // found, but a gameobject collision changed near the ray since
+    uint64 expired;
+    uint32 entries;
+};
+
+/**
+ * Line of sight results of one map, kept a short time. Positions are snapped to a
+ * small grid, so that a creature checking the same standing player at each AI
+ * update only traverses the models once. The result from A to B is also used from
+ * B to A, models collide on both faces of their triangles.
+ *
+ * The map is divided in square regions, each remembering the last time a gameobject
+ * collision model was added, removed or toggled over it. A result is only used if
+ * none of the regions its ray crosses changed after it was computed.
+ */
+class LineOfSightCache
+{
+    public:
+        LineOfSightCache();
+
+        // Value to give to Insert, read before computing the result
+        uint32 GetEpoch() const { return m_epoch.load(std::memory_order_acquire); }
+
+        bool Find(float x1, float y1, float z1, float x2, float y2, float z2, bool checkDynLos, uint32 now, bool& result);
+        void Insert(float x1, float y1, float z1, float x2, float y2, float z2, bool checkDynLos, uint32 epoch, uint32 now, uint32 lifetime, uint32 maxEntries, bool result);
+
+        // Forgets the results of the rays crossing this area
+        void Invalidate(float minX, float minY, float maxX, float maxY);
+        void Clear();
+
+        LineOfSightCacheStats GetStats();
+        void ResetStats();
+
+    private:
+        struct Key
+        {
+            bool operator==(Key const& other) const
+            {
+                return from[0] == other.from[0] && from[1] == other.from[1] && from[2] == other.from[2] &&
+                       to[0] == other.to[0] && to[1] == other.to[1] && to[2] == other.to[2] && checkDynLos == other.checkDynLos;
+            }
+
+            int32 from[3];                                  // snapped positions, lowest first
+            int32 to[3];
+            bool checkDynLos;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(Key const& key) const;
+        };
+
+        struct Entry
+        {
+            uint32 epoch;
+            uint32 expireTime;
+            bool result;
+        };
+
+        struct Shard
+        {
+            std::mutex lock;
+            std::unordered_map<Key, Entry, KeyHash> entries;
+        };
+
+        static bool MakeKey(float x1, float y1, float z1, float x2, float y2, float z2, bool checkDynLos, Key& key);
+        static uint32 RegionSlot(int32 regionX, int32 regionY);
+        bool IsRegionChangedSince(Key const& key, uint32 epoch) const;
+        Shard& GetShard(Key const& key);
+
+        static uint32 const SHARDS = 16;
+        static uint32 const REGION_SLOTS = 4096;
+
+        Shard m_shards[SHARDS];
+        std::atomic<uint32> m_epoch;
+        std::atomic<uint32> m_regionEpochs[REGION_SLOTS];   // last change of the regions hashed to each slot
+        std::atomic<uint32> m_clearEpoch;                   // results computed before are all invalid
+
+        std::atomic<uint64> m_hits;
+        std::atomic<uint64> m_misses;
+        std::atomic<uint64> m_invalidated;
+        std::atomic<uint64> m_expired;
+};
+
+#endif
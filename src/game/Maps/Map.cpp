@@ -39,6 +39,7 @@
 #include "VMapFactory.h"
 #include "BattleGroundMgr.h"
 #include "DynamicTree.h"
+#include "GameObjectModel.h"
 #include "RegularGrid.h"
 #include "PathFinder.h"
 #include "Detour/Include/DetourNavMesh.h"
@@ -91,7 +92,11 @@ void Map::LoadMapAndVMap(int gx, int gy)
 
     GridMap * pInfo = m_TerrainData->Load(gx, gy);
     if (pInfo)
+    {
         m_bLoadedGrids[gx][gy] = true;
+        // New static models may block rays cached while the grid was not loaded
+        m_losCache.Clear();
+    }
 }
 
 Map::Map(uint32 id, time_t expiry, uint32 InstanceId)
@@ -104,8 +109,9 @@ Map::Map(uint32 id, time_t expiry, uint32 InstanceId)
       _processingSendObjUpdates(false), _processingUnitsRelocation(false),
       m_updateFinished(false), m_updateDiffMod(0), m_GridActivationDistance(DEFAULT_VISIBILITY_DISTANCE),
       _lastPlayersUpdate(WorldTimer::getMSTime()), _lastMapUpdate(WorldTimer::getMSTime()),
-      _lastCellsUpdate(WorldTimer::getMSTime()), _inactivePlayersSkippedUpdates(0),
-      _objUpdatesThreads(0), _unitRelocationThreads(0), _lastPlayerLeftTime(0),
+      _lastCellsUpdate(WorldTimer::getMSTime()), _inactivePlayersSkippedUpdates(0), m_cellsScheduler(TOTAL_NUMBER_OF_CELLS_PER_MAP),
+      _objUpdatesThreads(0), _valuesBlocksBuilt(0), _valuesBlocksShared(0),
+      _visibilityEvaluated(0), _visibilitySkipped(0), _lastTickVisibilityEvaluated(0), _lastTickVisibilitySkipped(0), _unitRelocationThreads(0), _lastPlayerLeftTime(0),
       m_lastMvtSpellsUpdate(0), _bonesCleanupTimer(0), m_uiScriptedEventsTimer(1000)
 {
     m_CreatureGuids.Set(sObjectMgr.GetFirstTemporaryCreatureLowGuid());
@@ -392,7 +398,7 @@ bool Map::Add(Player *player)
 void Map::ExistingPlayerLogin(Player* player)
 {
     // Reset visibility list
-    for (ObjectGuidSet::const_iterator it = player->m_visibleGUIDs.begin(); it != player->m_visibleGUIDs.end(); ++it)
+    for (ObjectGuidSortedSet::const_iterator it = player->m_visibleGUIDs.begin(); it != player->m_visibleGUIDs.end(); ++it)
         if (Player* other = GetPlayer(*it))
             other->m_broadcaster->RemoveListener(player);
     player->m_visibleGUIDs.clear();
@@ -629,58 +635,15 @@ inline void Map::MarkCellsAroundObject(WorldObject const* object)
         for (uint32 y = area.low_bound.y_coord; y <= area.high_bound.y_coord; ++y)
         {
             uint32 cell_id = (y * TOTAL_NUMBER_OF_CELLS_PER_MAP) + x;
-            markCell(cell_id);
-        }
-    }
-}
-
-
-inline void Map::UpdateActiveCellsCallback(uint32 diff, uint32 now, uint32 threadId, uint32 totalThreads, uint32 step)
-{
-    MaNGOS::ObjectUpdater updater(diff, now);
-    TypeContainerVisitor<MaNGOS::ObjectUpdater, GridTypeMapContainer  > grid_object_update(updater);
-    TypeContainerVisitor<MaNGOS::ObjectUpdater, WorldTypeMapContainer > world_object_update(updater);
-
-    int safeDistCells = sWorld.getConfig(CONFIG_UINT32_MTCELLS_SAFEDISTANCE) / SIZE_OF_GRID_CELL + 1;
-    totalThreads *= 2;
-    threadId = 2 * threadId + step;
-    for (int y = 0; y < TOTAL_NUMBER_OF_CELLS_PER_MAP; ++y)
-    {
-        // Skip grids not for this thread
-        if ((y / safeDistCells) % totalThreads != threadId)
-            continue;
-        for (int x = 0; x < TOTAL_NUMBER_OF_CELLS_PER_MAP; ++x)
-        {
-            uint32 cellId = (y * TOTAL_NUMBER_OF_CELLS_PER_MAP) + x;
-            if (!isCellMarked(cellId))
-                continue;
-            CellPair pair(x, y);
-            Cell cell(pair);
-            cell.SetNoCreate();
-            Visit(cell, grid_object_update);
-            Visit(cell, world_object_update);
+            if (!isCellMarked(cell_id))
+            {
+                markCell(cell_id);
+                m_cellsScheduler.AddCell(x, y);
+            }
         }
     }
 }
 
-class MapAsynchCellsWorker : public ACE_Based::Runnable
-{
-public:
-    MapAsynchCellsWorker(int i, int nthreads, uint32 _diff, uint32 _now, uint32 _step, Map* m) : threadIdx(i), nThreads(nthreads), now(_now), diff(_diff), map(m), step(_step)
-    {
-    }
-
-    virtual void run()
-    {
-        map->UpdateActiveCellsCallback(diff, now, threadIdx, nThreads, step);
-    }
-    int threadIdx;
-    int nThreads;
-    uint32 diff, now, step;
-    Map* map;
-};
-
-
 inline void Map::UpdateActiveCellsAsynch(uint32 now, uint32 diff)
 {
     resetMarkedCells();
@@ -692,27 +655,21 @@ inline void Map::UpdateActiveCellsAsynch(uint32 now, uint32 diff)
     for (m_activeNonPlayersIter = m_activeNonPlayers.begin(); m_activeNonPlayersIter != m_activeNonPlayers.end(); ++m_activeNonPlayersIter)
         MarkCellsAroundObject(*m_activeNonPlayersIter);
 
-    const int nthreads = sWorld.getConfig(CONFIG_UINT32_MTCELLS_THREADS);
-    // Step 1
-    std::vector<ACE_Based::Thread*> threads;
-    for (int i = 0; i < (nthreads - 1); ++i)
-        threads.push_back(new ACE_Based::Thread(new MapAsynchCellsWorker(i, nthreads, diff, now, 0, this)));
-    UpdateActiveCellsCallback(diff, now, nthreads-1, nthreads, 0);
-    for (int i = 0; i < threads.size(); ++i)
+    // Cells updated at the same time must be at least SafeDistance away from each other
+    uint32 safeDistCells = sWorld.getConfig(CONFIG_UINT32_MTCELLS_SAFEDISTANCE) / SIZE_OF_GRID_CELL + 1;
+    m_cellsScheduler.Run(sWorld.GetThreadPool(), sWorld.GetTaskPhaseStats(TASK_PHASE_CELLS_UPDATE),
+        sWorld.getConfig(CONFIG_UINT32_MTCELLS_THREADS), safeDistCells, [this, diff, now](uint32 x, uint32 y)
     {
-        threads[i]->wait();
-        delete threads[i];
-    }
-    // Step 2
-    threads.clear();
-    for (int i = 0; i < (nthreads - 1); ++i)
-        threads.push_back(new ACE_Based::Thread(new MapAsynchCellsWorker(i, nthreads, diff, now, 1, this)));
-    UpdateActiveCellsCallback(diff, now, nthreads-1, nthreads, 1);
-    for (int i = 0; i < threads.size(); ++i)
-    {
-        threads[i]->wait();
-        delete threads[i];
-    }
+        MaNGOS::ObjectUpdater updater(diff, now);
+        TypeContainerVisitor<MaNGOS::ObjectUpdater, GridTypeMapContainer  > grid_object_update(updater);
+        TypeContainerVisitor<MaNGOS::ObjectUpdater, WorldTypeMapContainer > world_object_update(updater);
+
+        CellPair pair(x, y);
+        Cell cell(pair);
+        cell.SetNoCreate();
+        Visit(cell, grid_object_update);
+        Visit(cell, world_object_update);
+    });
 }
 
 inline void Map::UpdateActiveCellsSynch(uint32 now, uint32 diff)
@@ -739,27 +696,6 @@ inline void Map::UpdateActiveCellsSynch(uint32 now, uint32 diff)
     }
 }
 
-class UnitsMovementUpdater : public ACE_Based::Runnable
-{
-public:
-    UnitsMovementUpdater(int i, int nthreads, std::set<Unit*>& _updates, uint32 _diff) : threadIdx(i), nThreads(nthreads), updates(_updates), diff(_diff)
-    {
-    }
-
-    virtual void run()
-    {
-        int i = 0;
-        for (std::set<Unit*>::iterator iter = updates.begin(); iter != updates.end(); ++iter)
-            if (((++i) % nThreads) == threadIdx)
-                if ((*iter)->IsInWorld())
-                    (*iter)->GetMotionMaster()->UpdateMotionAsync(diff);
-    }
-    int threadIdx;
-    int nThreads;
-    std::set<Unit*>& updates;
-    uint32 diff;
-};
-
 inline void Map::UpdateCells(uint32 map_diff)
 {
     uint32 now = WorldTimer::getMSTime();
@@ -777,16 +713,19 @@ inline void Map::UpdateCells(uint32 map_diff)
     int nthreads = sWorld.getConfig(CONFIG_UINT32_CONTINENTS_MOTIONUPDATE_THREADS);
     if (IsContinent() && nthreads)
     {
-        std::vector<ACE_Based::Thread*> threads;
-        for (int i = 0; i < nthreads; ++i)
-            threads.push_back(new ACE_Based::Thread(new UnitsMovementUpdater(i, nthreads, unitsMvtUpdate, diff)));
-        for (int i = 0; i < threads.size(); ++i)
+        std::vector<Unit*> units(unitsMvtUpdate.begin(), unitsMvtUpdate.end());
+        sWorld.GetThreadPool()->ParallelFor(units.size(), nthreads, [&units, diff](size_t begin, size_t end)
         {
-            threads[i]->wait();
-            delete threads[i];
-        }
+            for (size_t i = begin; i < end; ++i)
+                if (units[i]->IsInWorld())
+                    units[i]->GetMotionMaster()->UpdateMotionAsync(diff);
+        }, sWorld.GetTaskPhaseStats(TASK_PHASE_MOTION_UPDATE));
     }
     unitsMvtUpdate.clear();
+
+    // Paths asked during this update, answered at the next one
+    m_pathRequests.Process(this, sWorld.GetThreadPool(), sWorld.getConfig(CONFIG_UINT32_PATH_REQUESTS_THREADS),
+                           sWorld.GetTaskPhaseStats(TASK_PHASE_PATH_REQUESTS));
 }
 
 
@@ -871,6 +810,8 @@ void Map::Update(uint32 t_diff)
     uint32 updateMapTime = WorldTimer::getMSTime();
     uint32 timeDiff = 0;
     _dynamicTree.update(t_diff);
+    _lastTickVisibilityEvaluated = _visibilityEvaluated.exchange(0, std::memory_order_relaxed);
+    _lastTickVisibilitySkipped = _visibilitySkipped.exchange(0, std::memory_order_relaxed);
 
     ProcessSessionPackets(PACKET_PROCESS_DB_QUERY); // TODO: Move somewhere else ?
     UpdateSessionsMovementAndSpellsIfNeeded();
@@ -1184,7 +1125,7 @@ void Map::Remove(Player *player, bool remove)
     RemoveUnitFromMovementUpdate(player);
     player->m_needUpdateVisibility = false;
 
-    for (ObjectGuidSet::const_iterator it = player->m_visibleGUIDs.begin(); it != player->m_visibleGUIDs.end(); ++it)
+    for (ObjectGuidSortedSet::const_iterator it = player->m_visibleGUIDs.begin(); it != player->m_visibleGUIDs.end(); ++it)
         if (Player* other = GetPlayer(*it))
             other->m_broadcaster->RemoveListener(player);
 
@@ -1539,9 +1480,9 @@ void Map::UpdateObjectVisibility(WorldObject* obj, Cell cell, CellPair cellpair)
 void Map::UpdateActiveObjectVisibility(Player *player)
 {
     // Params for compressed data set - will only be compressed if packet size > 100 (multiple units)
-    ObjectGuidSet guids;
+    ObjectGuidSortedSet guids;
     UpdateData data;
-    std::set<WorldObject*> visibleNow;
+    std::vector<WorldObject*> visibleNow;
 
     UpdateActiveObjectVisibility(player, guids, data, visibleNow);
 
@@ -1550,7 +1491,7 @@ void Map::UpdateActiveObjectVisibility(Player *player)
 }
 
 // Not compressed
-void Map::UpdateActiveObjectVisibility(Player *player, ObjectGuidSet &visibleGuids)
+void Map::UpdateActiveObjectVisibility(Player *player, ObjectGuidSortedSet &visibleGuids)
 {
     for (auto iter = m_activeNonPlayers.cbegin(); iter != m_activeNonPlayers.cend(); ++iter)
     {
@@ -1564,7 +1505,7 @@ void Map::UpdateActiveObjectVisibility(Player *player, ObjectGuidSet &visibleGui
 }
 
 // Support for compressed data packet
-void Map::UpdateActiveObjectVisibility(Player *player, ObjectGuidSet &visibleGuids, UpdateData &data, std::set<WorldObject*> &visibleNow)
+void Map::UpdateActiveObjectVisibility(Player *player, ObjectGuidSortedSet &visibleGuids, UpdateData &data, std::vector<WorldObject*> &visibleNow)
 {
     for (auto iter = m_activeNonPlayers.cbegin(); iter != m_activeNonPlayers.cend(); ++iter)
     {
@@ -2782,19 +2723,13 @@ WorldObject* Map::GetWorldObjectOrPlayer(ObjectGuid guid)
     return nullptr;
 }
 
-class ObjectUpdatePacketBuilder : public ACE_Based::Runnable
+class ObjectUpdatePacketBuilder
 {
 public:
     ObjectUpdatePacketBuilder(std::set<Object*>::iterator& a, std::set<Object*>::iterator& b, uint32 now) : begin(a), end(b), beginTime(now), current(a)
     {
     }
 
-    virtual void run()
-    {
-        WorldDatabase.ThreadStart(); // Not needed if we don't do SQL queries from this thread ...
-        DoUpdateObjects();
-        WorldDatabase.ThreadEnd();
-    }
     void DoUpdateObjects()
     {
         uint32 timeout = sWorld.getConfig(CONFIG_UINT32_MAP_OBJECTSUPDATE_TIMEOUT);
@@ -2844,9 +2779,8 @@ void Map::SendObjectUpdates()
         threads = objectsCount;
 
     uint32 step = objectsCount / threads;
-    uint32 i = 0;
-    ACE_Based::Thread** updaters = threads > 1 ? new ACE_Based::Thread*[threads - 1] : NULL;
-    ObjectUpdatePacketBuilder** objUpdaters = new ObjectUpdatePacketBuilder*[threads];
+    std::vector<ObjectUpdatePacketBuilder> objUpdaters;
+    objUpdaters.reserve(threads);
     std::set<Object*>::iterator itBegin = i_objectsToClientUpdate.begin();
     std::set<Object*>::iterator itEnd = i_objectsToClientUpdate.begin();
     ASSERT(step > 0);
@@ -2861,26 +2795,23 @@ void Map::SendObjectUpdates()
             for (uint32 j = 0; j < step; ++j)
                 ++itEnd;
         }
-        objUpdaters[i] = new ObjectUpdatePacketBuilder(itBegin, itEnd, now);
-        objUpdaters[i]->incReference();
+        objUpdaters.emplace_back(itBegin, itEnd, now);
+    }
 
-        if (i == (threads - 1)) // Do not create a useless supplementary thread
-            objUpdaters[i]->DoUpdateObjects();
-        else
-            updaters[i] = new ACE_Based::Thread(objUpdaters[i]);
+    {
+        TaskGroup updatersGroup(sWorld.GetThreadPool(), sWorld.GetTaskPhaseStats(TASK_PHASE_OBJECTS_UPDATE));
+        for (ObjectUpdatePacketBuilder& updater : objUpdaters)
+            updatersGroup.run([&updater]() { updater.DoUpdateObjects(); });
+        updatersGroup.wait();
     }
-    for (uint32 i = 0; i < (threads - 1); ++i)
-        updaters[i]->wait();
-    for (uint32 i = 0; i < threads; ++i)
+
+    for (ObjectUpdatePacketBuilder& updater : objUpdaters)
     {
         /* std::set::erase
          * Iterators, pointers and references referring to elements removed by the function are invalidated.
          * All other iterators, pointers and references keep their validity.
          */
-        i_objectsToClientUpdate.erase(objUpdaters[i]->begin, objUpdaters[i]->current);
-        objUpdaters[i]->decReference();
-        if (i != (threads - 1))
-            delete updaters[i];
+        i_objectsToClientUpdate.erase(updater.begin, updater.current);
     }
 
     // If we timeout, use more threads !
@@ -2890,8 +2821,6 @@ void Map::SendObjectUpdates()
         --_objUpdatesThreads;
 
     _processingSendObjUpdates = false;
-    delete[] updaters;
-    delete[] objUpdaters;
 #ifdef MAP_SENDOBJECTUPDATES_PROFILE
     uint32 diff = WorldTimer::getMSTimeDiffToNow(now);
     if (diff > 50)
@@ -2899,19 +2828,13 @@ void Map::SendObjectUpdates()
 #endif
 }
 
-class VisibilityUpdater : public ACE_Based::Runnable
+class VisibilityUpdater
 {
 public:
     VisibilityUpdater(std::set<Unit*>::iterator& a, std::set<Unit*>::iterator& b, uint32 now) : begin(a), end(b), beginTime(now), current(a)
     {
     }
 
-    virtual void run()
-    {
-        WorldDatabase.ThreadStart();
-        DoUpdateVisibility();
-        WorldDatabase.ThreadEnd();
-    }
     void DoUpdateVisibility()
     {
         uint32 timeout = sWorld.getConfig(CONFIG_UINT32_MAP_VISIBILITYUPDATE_TIMEOUT);
@@ -2955,9 +2878,8 @@ void Map::UpdateVisibilityForRelocations()
         threads = objectsCount;
 
     uint32 step = objectsCount / threads;
-    uint32 i = 0;
-    ACE_Based::Thread** updaters = threads > 1 ? new ACE_Based::Thread*[threads - 1] : NULL;
-    VisibilityUpdater** visUpdaters = new VisibilityUpdater*[threads];
+    std::vector<VisibilityUpdater> visUpdaters;
+    visUpdaters.reserve(threads);
     std::set<Unit*>::iterator itBegin = i_unitsRelocated.begin();
     std::set<Unit*>::iterator itEnd = i_unitsRelocated.begin();
     ASSERT(step > 0);
@@ -2971,31 +2893,25 @@ void Map::UpdateVisibilityForRelocations()
             for (uint32 j = 0; j < step; ++j)
                 ++itEnd;
         }
-        visUpdaters[i] = new VisibilityUpdater(itBegin, itEnd, now);
-        visUpdaters[i]->incReference();
-        if (i == (threads - 1))
-            visUpdaters[i]->DoUpdateVisibility();
-        else
-            updaters[i] = new ACE_Based::Thread(visUpdaters[i]);
+        visUpdaters.emplace_back(itBegin, itEnd, now);
     }
-    for (uint32 i = 0; i < threads - 1; ++i)
-        updaters[i]->wait();
-    for (uint32 i = 0; i < threads; ++i)
+
     {
-        i_unitsRelocated.erase(visUpdaters[i]->begin, visUpdaters[i]->current);
-        visUpdaters[i]->decReference();
-        if (i != (threads - 1))
-            delete updaters[i];
+        TaskGroup updatersGroup(sWorld.GetThreadPool(), sWorld.GetTaskPhaseStats(TASK_PHASE_VISIBILITY_UPDATE));
+        for (VisibilityUpdater& updater : visUpdaters)
+            updatersGroup.run([&updater]() { updater.DoUpdateVisibility(); });
+        updatersGroup.wait();
     }
 
+    for (VisibilityUpdater& updater : visUpdaters)
+        i_unitsRelocated.erase(updater.begin, updater.current);
+
     if (i_unitsRelocated.size())
         ++_unitRelocationThreads;
     else
         --_unitRelocationThreads;
 
     _processingUnitsRelocation = false;
-    delete[] updaters;
-    delete[] visUpdaters;
 
 #ifdef MAP_UPDATEVISIBILITY_PROFILE
     uint32 diff = WorldTimer::getMSTimeDiffToNow(now);
@@ -3146,8 +3062,45 @@ bool Map::isInLineOfSight(float x1, float y1, float z1, float x2, float y2, floa
     ASSERT(MaNGOS::IsValidMapCoord(x1, y1, z1));
     ASSERT(MaNGOS::IsValidMapCoord(x2, y2, z2));
 
-    return VMAP::VMapFactory::createOrGetVMapManager()->isInLineOfSight(GetId(), x1, y1, z1, x2, y2, z2)
+    uint32 lifetime = sWorld.getConfig(CONFIG_UINT32_LOS_CACHE_LIFETIME);
+    uint32 now = 0;
+    bool result;
+    if (lifetime)
+    {
+        now = WorldTimer::getMSTime();
+        if (m_losCache.Find(x1, y1, z1, x2, y2, z2, checkDynLos, now, result))
+            return result;
+    }
+
+    // Read before the check, a gameobject changing meanwhile must invalidate the result
+    uint32 epoch = m_losCache.GetEpoch();
+    result = VMAP::VMapFactory::createOrGetVMapManager()->isInLineOfSight(GetId(), x1, y1, z1, x2, y2, z2)
     && (!checkDynLos || CheckDynamicTreeLoS(x1, y1, z1, x2, y2, z2));
+
+    if (lifetime)
+        m_losCache.Insert(x1, y1, z1, x2, y2, z2, checkDynLos, epoch, now, lifetime, sWorld.getConfig(CONFIG_UINT32_LOS_CACHE_MAX_ENTRIES), result);
+    return result;
+}
+
+void Map::InvalidateLoSCache(GameObjectModel const& model)
+{
+    G3D::AABox const& bounds = model.getBounds();
+    m_losCache.Invalidate(bounds.low().x, bounds.low().y, bounds.high().x, bounds.high().y);
+}
+
+void Map::isInLineOfSight(float srcX, float srcY, float srcZ, std::vector<G3D::Vector3> const& targets, std::vector<bool>& results, bool checkDynLos) const
+{
+    ASSERT(MaNGOS::IsValidMapCoord(srcX, srcY, srcZ));
+    for (G3D::Vector3 const& target : targets)
+        ASSERT(MaNGOS::IsValidMapCoord(target.x, target.y, target.z));
+
+    VMAP::VMapFactory::createOrGetVMapManager()->isInLineOfSight(GetId(), srcX, srcY, srcZ, targets, results);
+    if (!checkDynLos)
+        return;
+
+    for (size_t i = 0; i < targets.size(); ++i)
+        if (results[i])
+            results[i] = CheckDynamicTreeLoS(srcX, srcY, srcZ, targets[i].x, targets[i].y, targets[i].z);
 }
 
 bool Map::GetLosHitPosition(float srcX, float srcY, float srcZ, float& destX, float& destY, float& destZ, float modifyDist) const
@@ -3200,7 +3153,7 @@ bool Map::GetWalkHitPosition(Transport* transport, float srcX, float srcY, float
     }
 
     MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
-    const dtNavMeshQuery* m_navMeshQuery = transport ? mmap->GetModelNavMeshQuery(transport->GetDisplayId()) : mmap->GetNavMeshQuery(GetId());
+    MMAP::NavMeshQueryHandle m_navMeshQuery = transport ? mmap->GetModelNavMeshQuery(transport->GetDisplayId()) : mmap->GetNavMeshQuery(GetId());
     if (!m_navMeshQuery)
     {
         DETAIL_LOG("WalkHitPos: No nav mesh loaded !");
@@ -3223,7 +3176,7 @@ bool Map::GetWalkHitPosition(Transport* transport, float srcX, float srcY, float
     if (!locatedOnSteepSlope)
         filter.setExcludeFlags(NAV_STEEP_SLOPES);
 
-    dtPolyRef startRef = PathInfo::FindWalkPoly(m_navMeshQuery, point, filter, closestPoint, zSearchDist);
+    dtPolyRef startRef = PathInfo::FindWalkPoly(m_navMeshQuery.get(), point, filter, closestPoint, zSearchDist);
     if (!startRef)
     {
         DETAIL_LOG("WalkHitPos: Start poly not found");
@@ -3297,7 +3250,7 @@ bool Map::GetWalkRandomPosition(Transport* transport, float &x, float &y, float
 
     // Trouver le navMeshQuery
     MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
-    const dtNavMeshQuery* m_navMeshQuery = transport ? mmap->GetModelNavMeshQuery(transport->GetDisplayId()) : mmap->GetNavMeshQuery(GetId());
+    MMAP::NavMeshQueryHandle m_navMeshQuery = transport ? mmap->GetModelNavMeshQuery(transport->GetDisplayId()) : mmap->GetNavMeshQuery(GetId());
     float radius = maxRadius * rand_norm_f();
     if (!m_navMeshQuery)
         return false;
@@ -3311,7 +3264,7 @@ bool Map::GetWalkRandomPosition(Transport* transport, float &x, float &y, float
     dtQueryFilter filter;
     filter.setIncludeFlags(moveAllowedFlags);
     filter.setExcludeFlags(NAV_STEEP_SLOPES);
-    dtPolyRef startRef = PathInfo::FindWalkPoly(m_navMeshQuery, point, filter, closestPoint);
+    dtPolyRef startRef = PathInfo::FindWalkPoly(m_navMeshQuery.get(), point, filter, closestPoint);
     if (!startRef)
         return false;
 
@@ -3452,7 +3405,13 @@ void Map::PrintInfos(ChatHandler& handler)
     handler.PSendSysMessage("Performance infos on Map (%u, %u)", GetId(), GetInstanceId());
     handler.PSendSysMessage("%u non player active", m_activeNonPlayers.size());
     handler.PSendSysMessage("%u objects to client update [%u threads]", i_objectsToClientUpdate.size(), _objUpdatesThreads);
+    uint64 built = _valuesBlocksBuilt;
+    uint64 shared = _valuesBlocksShared;
+    handler.PSendSysMessage("Values blocks: " UI64FMTD " built, " UI64FMTD " shared (%.1f%% cache hits)",
+        built, shared, (built + shared) ? shared * 100.0f / (built + shared) : 0.0f);
     handler.PSendSysMessage("%u objects relocated [%u threads]", i_unitsRelocated.size(), _unitRelocationThreads);
+    handler.PSendSysMessage("Visibility last tick: %u objects evaluated, %u skipped", _lastTickVisibilityEvaluated, _lastTickVisibilitySkipped);
+    handler.PSendSysMessage("Cells update: %u regions, %u updated at the same time", m_cellsScheduler.GetLastRegionsCount(), m_cellsScheduler.GetLastMaxConcurrency());
     handler.PSendSysMessage("%u scripts scheduled", m_scriptSchedule.size());
     handler.PSendSysMessage("Vis:%.1f Act:%.1f", m_VisibleDistance, m_GridActivationDistance);
 }
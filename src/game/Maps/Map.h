@@ -44,7 +44,11 @@
 #include "WorldSession.h"
 #include "SQLStorages.h"
 #include "CreatureLinkingMgr.h"
+#include "CellUpdateScheduler.h"
+#include "PathRequestQueue.h"
+#include "LineOfSightCache.h"
 
+#include <atomic>
 #include <bitset>
 #include <list>
 #include <set>
@@ -330,6 +334,20 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
     public:
         virtual ~Map();
         void PrintInfos(ChatHandler& handler);
+        // Values update blocks built for viewers, and copied from another viewer's block
+        void AddValuesUpdateStats(uint32 built, uint32 shared)
+        {
+            if (built)
+                _valuesBlocksBuilt.fetch_add(built, std::memory_order_relaxed);
+            if (shared)
+                _valuesBlocksShared.fetch_add(shared, std::memory_order_relaxed);
+        }
+        // Objects evaluated and skipped by the visibility updates of the cameras
+        void AddVisibilityStats(uint32 evaluated, uint32 skipped)
+        {
+            _visibilityEvaluated.fetch_add(evaluated, std::memory_order_relaxed);
+            _visibilitySkipped.fetch_add(skipped, std::memory_order_relaxed);
+        }
         void SpawnActiveObjects();
         // currently unused for normal maps
         bool CanUnload(uint32 diff)
@@ -352,7 +370,6 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
         inline void UpdateActiveCellsSynch(uint32 now, uint32 diff);
         inline void MarkCellsAroundObject(WorldObject const* object);
         inline void UpdateActiveCellsAsynch(uint32 now, uint32 diff);
-        inline void UpdateActiveCellsCallback(uint32 diff, uint32 now, uint32 threadId, uint32 totalThreads, uint32 step);
         inline void UpdateCells(uint32 diff);
         void UpdateSync(const uint32);
         void UpdatePlayers();
@@ -434,8 +451,8 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
         void UpdateObjectVisibility(WorldObject* obj, Cell cell, CellPair cellpair);
 
         void UpdateActiveObjectVisibility(Player *player);
-        void UpdateActiveObjectVisibility(Player *player, ObjectGuidSet &visibleGuids);
-        void UpdateActiveObjectVisibility(Player *player, ObjectGuidSet &visibleGuids, UpdateData &data, std::set<WorldObject*> &visibleNow);
+        void UpdateActiveObjectVisibility(Player *player, ObjectGuidSortedSet &visibleGuids);
+        void UpdateActiveObjectVisibility(Player *player, ObjectGuidSortedSet &visibleGuids, UpdateData &data, std::vector<WorldObject*> &visibleNow);
 
         void resetMarkedCells() { marked_cells.reset(); }
         bool isCellMarked(uint32 pCellId) { return marked_cells.test(pCellId); }
@@ -563,6 +580,7 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
             unitsMvtUpdate.erase(unit);
             unitsMvtUpdate_lock.release();
         }
+        PathRequestQueue& GetPathRequests() { return m_pathRequests; }
         // DynObjects currently
         uint32 GenerateLocalLowGuid(HighGuid guidhigh);
 
@@ -581,6 +599,8 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
         // GameObjectCollision
         float GetHeight(float x, float y, float z, bool vmap = true, float maxSearchDist = DEFAULT_HEIGHT_SEARCH) const;
         bool isInLineOfSight(float x1, float y1, float z1, float x2, float y2, float z2, bool checkDynLos = true) const;
+        // Line of sight from one position to several, the static models are traversed once for all of them
+        void isInLineOfSight(float srcX, float srcY, float srcZ, std::vector<G3D::Vector3> const& targets, std::vector<bool>& results, bool checkDynLos = true) const;
         // First collision with object
         bool GetLosHitPosition(float srcX, float srcY, float srcZ, float& destX, float& destY, float& destZ, float modifyDist) const;
         // Use navemesh to walk
@@ -596,6 +616,7 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
             _dynamicTree.remove(model);
             _dynamicTree.balance();
             _dynamicTree_lock.release();
+            InvalidateLoSCache(model);
         }
         void InsertGameObjectModel(const GameObjectModel& model)
         {
@@ -603,7 +624,11 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
             _dynamicTree.insert(model);
             _dynamicTree.balance();
             _dynamicTree_lock.release();
+            InvalidateLoSCache(model);
         }
+        // Forgets the cached line of sight results around a gameobject whose collision changed
+        void InvalidateLoSCache(GameObjectModel const& model);
+        LineOfSightCache& GetLoSCache() { return m_losCache; }
         bool ContainsGameObjectModel(const GameObjectModel& model) const
         {
             _dynamicTree_lock.acquire_read();
@@ -705,6 +730,12 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
 
         bool                    _processingSendObjUpdates;
         uint32                  _objUpdatesThreads;
+        std::atomic<uint64>     _valuesBlocksBuilt;
+        std::atomic<uint64>     _valuesBlocksShared;
+        std::atomic<uint32>     _visibilityEvaluated;
+        std::atomic<uint32>     _visibilitySkipped;
+        uint32                  _lastTickVisibilityEvaluated;
+        uint32                  _lastTickVisibilitySkipped;
         mutable MapMutexType    i_objectsToClientUpdate_lock;
         std::set<Object *>      i_objectsToClientUpdate;
 
@@ -715,6 +746,7 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
 
         mutable MapMutexType    unitsMvtUpdate_lock;
         std::set<Unit*>         unitsMvtUpdate;
+        PathRequestQueue        m_pathRequests;
 
         mutable MapMutexType    _corpseRemovalLock;
         typedef std::list<std::pair<Corpse*, ObjectGuid>> CorpseRemoveList;
@@ -737,6 +769,7 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
 
         mutable ACE_RW_Mutex   _dynamicTree_lock;
         DynamicMapTree _dynamicTree;
+        mutable LineOfSightCache m_losCache;
 
         MapPersistentState* m_persistentState;
 
@@ -800,6 +833,7 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
         uint32 _lastPlayersUpdate;
         uint32 _inactivePlayersSkippedUpdates;
         uint32 _lastCellsUpdate;
+        CellUpdateScheduler m_cellsScheduler;
 
         int8 _updateIdx;
 
@@ -231,7 +231,7 @@ void MapManager::DeleteInstance(uint32 mapid, uint32 instanceId)
     }
 }
 
-class MapAsyncUpdater : public ACE_Based::Runnable
+class MapAsyncUpdater
 {
 public:
     MapAsyncUpdater(bool* updFinished, uint32 updateDiff) :
@@ -239,9 +239,8 @@ public:
     {
     }
 
-    virtual void run()
+    void run()
     {
-        WorldDatabase.ThreadStart();
         do
         {
             for (std::vector<Map*>::iterator it = maps.begin(); it != maps.end(); ++it)
@@ -255,7 +254,6 @@ public:
             ++loops;
         }
         while (!(*updateFinished));
-        WorldDatabase.ThreadEnd();
     }
     std::vector<Map*> maps;
     volatile bool* updateFinished;
@@ -263,23 +261,6 @@ public:
     uint32 loops;
 };
 
-class ContinentAsyncUpdater : public ACE_Based::Runnable
-{
-public:
-    ContinentAsyncUpdater(uint32 updateDiff, Map* m) : diff(updateDiff), map(m)
-    {
-    }
-
-    virtual void run()
-    {
-        WorldDatabase.ThreadStart();
-        map->DoUpdate(diff);
-        WorldDatabase.ThreadEnd();
-    }
-    Map* map;
-    uint32 diff;
-};
-
 void MapManager::Update(uint32 diff)
 {
     i_timer.Update(diff);
@@ -293,10 +274,8 @@ void MapManager::Update(uint32 diff)
     uint32 mapsDiff = (uint32)i_timer.GetCurrent();
     bool updateFinished = false;
     asyncMapUpdating = true;
-    std::vector<MapAsyncUpdater*> instanceUpdaters(sWorld.getConfig(CONFIG_UINT32_MAPUPDATE_INSTANCED_UPDATE_THREADS));
-    std::vector<ContinentAsyncUpdater*> continentsUpdaters;
-    for (int i = 0; i < instanceUpdaters.size(); ++i)
-        instanceUpdaters[i] = new MapAsyncUpdater(&updateFinished, mapsDiff); // Will be deleted at thread end
+    std::vector<MapAsyncUpdater> instanceUpdaters(sWorld.getConfig(CONFIG_UINT32_MAPUPDATE_INSTANCED_UPDATE_THREADS), MapAsyncUpdater(&updateFinished, mapsDiff));
+    std::vector<Map*> continents;
 
     int mapIdx = 0;
     int continentsIdx = 0;
@@ -315,7 +294,7 @@ void MapManager::Update(uint32 diff)
         {
             if (instanceUpdaters.size())
             {
-                instanceUpdaters[mapIdx % instanceUpdaters.size()]->maps.push_back(iter->second);
+                instanceUpdaters[mapIdx % instanceUpdaters.size()].maps.push_back(iter->second);
                 ++mapIdx;
             }
             else
@@ -324,8 +303,7 @@ void MapManager::Update(uint32 diff)
         else // One threat per continent part
         {
             iter->second->SetMapUpdateIndex(continentsIdx++);
-            ContinentAsyncUpdater* task = new ContinentAsyncUpdater(mapsDiff, iter->second);
-            continentsUpdaters.push_back(task);
+            continents.push_back(iter->second);
         }
     }
     i_maxContinentThread = continentsIdx;
@@ -333,29 +311,27 @@ void MapManager::Update(uint32 diff)
     for (int i = 0; i < i_maxContinentThread; ++i)
         i_continentUpdateFinished[i] = false;
 
-    std::vector<ACE_Based::Thread*> asyncUpdateThreads(instanceUpdaters.size() + continentsUpdaters.size());
+    // Continents wait for each other and instance updaters loop until continents are done:
+    // every one of them needs its own worker.
+    ThreadPool* pool = sWorld.GetThreadPool();
+    pool->Grow(instanceUpdaters.size() + continents.size());
+
+    TaskGroup instancesGroup(pool, sWorld.GetTaskPhaseStats(TASK_PHASE_INSTANCES_UPDATE));
+    for (MapAsyncUpdater& updater : instanceUpdaters)
+        instancesGroup.run([&updater]() { updater.run(); });
 
-    for (int tid = 0; tid < instanceUpdaters.size(); ++tid)
-        asyncUpdateThreads[tid]                             = new ACE_Based::Thread(instanceUpdaters[tid]);
-    for (int tid = 0; tid < continentsUpdaters.size(); ++tid)
-        asyncUpdateThreads[tid + instanceUpdaters.size()]   = new ACE_Based::Thread(continentsUpdaters[tid]);
+    TaskGroup continentsGroup(pool, sWorld.GetTaskPhaseStats(TASK_PHASE_CONTINENTS_UPDATE));
+    for (Map* continent : continents)
+        continentsGroup.run([continent, mapsDiff]() { continent->DoUpdate(mapsDiff); });
 
     // Finish continents updating
-    for (int tid = instanceUpdaters.size(); tid < asyncUpdateThreads.size(); ++tid)
-    {
-        asyncUpdateThreads[tid]->wait();
-        delete asyncUpdateThreads[tid];
-    }
+    continentsGroup.wait();
 
     updateFinished = true;
     SwitchPlayersInstances();
 
     // And then instances updating
-    for (int tid = 0; tid < instanceUpdaters.size(); ++tid)
-    {
-        asyncUpdateThreads[tid]->wait();
-        delete asyncUpdateThreads[tid];
-    }
+    instancesGroup.wait();
     delete[] i_continentUpdateFinished;
     i_continentUpdateFinished = NULL;
     asyncMapUpdating = false;
@@ -23,6 +23,9 @@
 
 #include "MoveMap.h"
 #include "MoveMapSharedDefines.h"
+#include "PathFinder.h"
+
+#include <chrono>
 
 namespace MMAP
 {
@@ -47,6 +50,181 @@ void MMapFactory::clear()
     }
 }
 
+// ######################## NavMeshQueryPool ########################
+// Nodes of each query, bounds the number of polygons a path search can visit
+#define NAVMESH_QUERY_MAX_NODES 2048
+
+// Slot the current thread used last, most likely free again and still in its cache
+static thread_local uint32 s_lastQuerySlot = 0;
+
+static inline uint64 ElapsedUs(std::chrono::steady_clock::time_point from)
+{
+    return uint64(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - from).count());
+}
+
+NavMeshQueryHandle& NavMeshQueryHandle::operator=(NavMeshQueryHandle&& other)
+{
+    if (this != &other)
+    {
+        Release();
+        m_pool = other.m_pool;
+        m_slot = other.m_slot;
+        m_query = other.m_query;
+        other.m_pool = nullptr;
+        other.m_query = nullptr;
+    }
+    return *this;
+}
+
+void NavMeshQueryHandle::Release()
+{
+    if (m_pool)
+        m_pool->Release(m_slot);
+    m_pool = nullptr;
+    m_query = nullptr;
+}
+
+void NavMeshQueryPoolStats::Add(NavMeshQueryPoolStats const& other)
+{
+    created += other.created;
+    inUse += other.inUse;
+    maxQueries += other.maxQueries;
+    checkouts += other.checkouts;
+    waits += other.waits;
+    waitUs += other.waitUs;
+    maxWaitUs = std::max(maxWaitUs, other.maxWaitUs);
+}
+
+NavMeshQueryPool::NavMeshQueryPool(dtNavMesh const* mesh, uint32 maxQueries, uint32 preallocated) :
+    m_navMesh(mesh), m_maxQueries(std::max<uint32>(maxQueries, 1)), m_slots(new Slot[std::max<uint32>(maxQueries, 1)]),
+    m_waiters(0), m_created(0), m_inUse(0), m_checkouts(0), m_waits(0), m_waitUs(0), m_maxWaitUs(0)
+{
+    for (uint32 i = 0; i < preallocated && i < m_maxQueries; ++i)
+    {
+        m_slots[i].query = CreateQuery();
+        if (!m_slots[i].query)
+            break;
+        m_slots[i].state = SLOT_FREE;
+    }
+}
+
+NavMeshQueryPool::~NavMeshQueryPool()
+{
+    for (uint32 i = 0; i < m_maxQueries; ++i)
+        if (m_slots[i].query)
+            dtFreeNavMeshQuery(m_slots[i].query);
+}
+
+dtNavMeshQuery* NavMeshQueryPool::CreateQuery()
+{
+    dtNavMeshQuery* query = dtAllocNavMeshQuery();
+    MANGOS_ASSERT(query);
+    if (dtStatusFailed(query->init(m_navMesh, NAVMESH_QUERY_MAX_NODES)))
+    {
+        dtFreeNavMeshQuery(query);
+        return nullptr;
+    }
+    ++m_created;
+    return query;
+}
+
+bool NavMeshQueryPool::TryAcquire(uint32& slot, dtNavMeshQuery*& query, bool& failed)
+{
+    // A query already created first, starting from the one this thread used last
+    uint32 const start = s_lastQuerySlot < m_maxQueries ? s_lastQuerySlot : 0;
+    for (uint32 i = 0; i < m_maxQueries; ++i)
+    {
+        uint32 const index = (start + i) % m_maxQueries;
+        uint8 expected = SLOT_FREE;
+        if (m_slots[index].state.compare_exchange_strong(expected, SLOT_BUSY))
+        {
+            slot = index;
+            query = m_slots[index].query;
+            return true;
+        }
+    }
+
+    for (uint32 index = 0; index < m_maxQueries; ++index)
+    {
+        uint8 expected = SLOT_EMPTY;
+        if (m_slots[index].state.compare_exchange_strong(expected, SLOT_BUSY))
+        {
+            m_slots[index].query = CreateQuery();
+            if (!m_slots[index].query)
+            {
+                m_slots[index].state = SLOT_EMPTY;
+                failed = true;
+                return false;
+            }
+            slot = index;
+            query = m_slots[index].query;
+            return true;
+        }
+    }
+    return false;
+}
+
+NavMeshQueryHandle NavMeshQueryPool::Acquire()
+{
+    ++m_checkouts;
+    uint32 slot = 0;
+    dtNavMeshQuery* query = nullptr;
+    bool failed = false;
+    if (!TryAcquire(slot, query, failed))
+    {
+        if (failed)
+            return NavMeshQueryHandle();
+
+        // Every query is in use: wait for one to be given back
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(m_waitLock);
+            ++m_waiters;
+            m_queryReleased.wait(lock, [&]() { return TryAcquire(slot, query, failed) || failed; });
+            --m_waiters;
+        }
+        if (failed)
+            return NavMeshQueryHandle();
+
+        uint64 waitedUs = ElapsedUs(start);
+        ++m_waits;
+        m_waitUs += waitedUs;
+        uint64 currentMax = m_maxWaitUs;
+        while (currentMax < waitedUs && !m_maxWaitUs.compare_exchange_weak(currentMax, waitedUs))
+            ;
+    }
+
+    s_lastQuerySlot = slot;
+    ++m_inUse;
+    return NavMeshQueryHandle(this, slot, query);
+}
+
+void NavMeshQueryPool::Release(uint32 slot)
+{
+    --m_inUse;
+    m_slots[slot].state = SLOT_FREE;
+
+    // A waiter registers itself before checking the slots, so it either sees this one free or gets notified
+    if (m_waiters)
+    {
+        std::lock_guard<std::mutex> lock(m_waitLock);
+        m_queryReleased.notify_one();
+    }
+}
+
+NavMeshQueryPoolStats NavMeshQueryPool::GetStats() const
+{
+    NavMeshQueryPoolStats stats;
+    stats.created = m_created;
+    stats.inUse = m_inUse;
+    stats.maxQueries = m_maxQueries;
+    stats.checkouts = m_checkouts;
+    stats.waits = m_waits;
+    stats.waitUs = m_waitUs;
+    stats.maxWaitUs = m_maxWaitUs;
+    return stats;
+}
+
 // ######################## MMapManager ########################
 MMapManager::~MMapManager()
 {
@@ -104,7 +282,7 @@ bool MMapManager::loadMapData(uint32 mapId)
     DETAIL_LOG("MMAP:loadMapData: Loaded %03i.mmap", mapId);
 
     // store inside our map list
-    MMapData* mmap_data = new MMapData(mesh);
+    MMapData* mmap_data = new MMapData(mesh, maxQueries, preallocatedQueries);
     mmap_data->mmapLoadedTiles.clear();
 
     loadedMMaps_lock.acquire_write();
@@ -276,37 +454,12 @@ bool MMapManager::unloadMap(uint32 mapId)
 
     delete mmap;
     loadedMMaps.erase(mapId);
+    sPathCorridorCache.Invalidate(mapId);
     DETAIL_LOG("MMAP:unloadMap: Unloaded %03i.mmap", mapId);
 
     return true;
 }
 
-bool MMapManager::unloadMapInstance(uint32 mapId, uint32 instanceId)
-{
-    // check if we have this map loaded
-    if (loadedMMaps.find(mapId) == loadedMMaps.end())
-    {
-        // file may not exist, therefore not loaded
-        DEBUG_LOG("MMAP:unloadMapInstance: Asked to unload not loaded navmesh map %03u", mapId);
-        return false;
-    }
-
-    MMapData* mmap = loadedMMaps[mapId];
-    if (mmap->navMeshQueries.find(instanceId) == mmap->navMeshQueries.end())
-    {
-        DEBUG_LOG("MMAP:unloadMapInstance: Asked to unload not loaded dtNavMeshQuery mapId %03u instanceId %u", mapId, instanceId);
-        return false;
-    }
-
-    dtNavMeshQuery* query = mmap->navMeshQueries[instanceId];
-
-    dtFreeNavMeshQuery(query);
-    mmap->navMeshQueries.erase(instanceId);
-    DETAIL_LOG("MMAP:unloadMapInstance: Unloaded mapId %03u instanceId %u", mapId, instanceId);
-
-    return true;
-}
-
 dtNavMesh const* MMapManager::GetNavMesh(uint32 mapId)
 {
     if (loadedMMaps.find(mapId) == loadedMMaps.end())
@@ -315,41 +468,46 @@ dtNavMesh const* MMapManager::GetNavMesh(uint32 mapId)
     return loadedMMaps[mapId]->navMesh;
 }
 
-dtNavMeshQuery const* MMapManager::GetNavMeshQuery(uint32 mapId)
+NavMeshQueryHandle MMapManager::GetNavMeshQuery(uint32 mapId)
 {
-    if (loadedMMaps.find(mapId) == loadedMMaps.end())
-        return NULL;
-
-    uint32 tid = ACE_Based::Thread::currentId();
-    MMapData* mmap = loadedMMaps[mapId];
-    mmap->navMeshQueries_lock.acquire_read();
+    loadedMMaps_lock.acquire_read();
+    MMapDataSet::iterator it = loadedMMaps.find(mapId);
+    MMapData* mmap = it != loadedMMaps.end() ? it->second : NULL;
+    loadedMMaps_lock.release();
+    if (!mmap)
+        return NavMeshQueryHandle();
 
-    NavMeshQuerySet::iterator it = mmap->navMeshQueries.find(tid);
-    dtNavMeshQuery* navMeshQuery = NULL;
-    if (it == mmap->navMeshQueries.end())
-    {
-        mmap->navMeshQueries_lock.release();
-        mmap->navMeshQueries_lock.acquire_write();
+    NavMeshQueryHandle query = mmap->navMeshQueries.Acquire();
+    if (!query)
+        sLog.outError("MMAP:GetNavMeshQuery: Failed to initialize dtNavMeshQuery for mapId %03u", mapId);
+    return query;
+}
 
-        // allocate mesh query
-        navMeshQuery = dtAllocNavMeshQuery();
-        MANGOS_ASSERT(navMeshQuery);
-        if (DT_SUCCESS != navMeshQuery->init(mmap->navMesh, 2048))
-        {
-            mmap->navMeshQueries_lock.release();
-            dtFreeNavMeshQuery(navMeshQuery);
-            sLog.outError("MMAP:GetNavMeshQuery: Failed to initialize dtNavMeshQuery for mapId %03u thread %u", mapId, tid);
-            return NULL;
-        }
+void MMapManager::SetQueryPoolSize(uint32 maxQueriesPerMap, uint32 preallocatedPerMap)
+{
+    maxQueries = std::max<uint32>(maxQueriesPerMap, 1);
+    preallocatedQueries = std::min(preallocatedPerMap, maxQueries);
+}
 
-        DETAIL_LOG("MMAP:GetNavMeshQuery: created dtNavMeshQuery for mapId %03u thread %u", mapId, tid);
-        mmap->navMeshQueries.insert(std::pair<uint32, dtNavMeshQuery*>(tid, navMeshQuery));
-    }
-    else
-        navMeshQuery = it->second;
-    mmap->navMeshQueries_lock.release();
+bool MMapManager::GetQueryPoolStats(uint32 mapId, NavMeshQueryPoolStats& stats)
+{
+    ACE_Read_Guard<ACE_RW_Mutex> guard(loadedMMaps_lock);
+    MMapDataSet::iterator it = loadedMMaps.find(mapId);
+    if (it == loadedMMaps.end())
+        return false;
+    stats = it->second->navMeshQueries.GetStats();
+    return true;
+}
 
-    return navMeshQuery;
+NavMeshQueryPoolStats MMapManager::GetQueryPoolsStats()
+{
+    NavMeshQueryPoolStats stats;
+    ACE_Read_Guard<ACE_RW_Mutex> guard(loadedMMaps_lock);
+    for (MMapDataSet::iterator it = loadedMMaps.begin(); it != loadedMMaps.end(); ++it)
+        stats.Add(it->second->navMeshQueries.GetStats());
+    for (MMapDataSet::iterator it = loadedModels.begin(); it != loadedModels.end(); ++it)
+        stats.Add(it->second->navMeshQueries.GetStats());
+    return stats;
 }
 
 bool MMapManager::loadGameObject(uint32 displayId)
@@ -414,38 +572,20 @@ bool MMapManager::loadGameObject(uint32 displayId)
     DETAIL_LOG("MMAP:loadGameObject: Loaded file %s [size=%u]", fileName, fileHeader.size);
     delete [] fileName;
 
-    MMapData* mmap_data = new MMapData(mesh);
+    MMapData* mmap_data = new MMapData(mesh, maxQueries, preallocatedQueries);
     loadedModels.insert(std::pair<uint32, MMapData*>(displayId, mmap_data));
     return true;
 }
 
-dtNavMeshQuery const* MMapManager::GetModelNavMeshQuery(uint32 displayId)
+NavMeshQueryHandle MMapManager::GetModelNavMeshQuery(uint32 displayId)
 {
-    if (loadedModels.find(displayId) == loadedModels.end())
-        return NULL;
-
-    uint32 tid = ACE_Based::Thread::currentId();
-    MMapData* mmap = loadedModels[displayId];
-    if (mmap->navMeshQueries.find(tid) == mmap->navMeshQueries.end())
-    {
-        ACE_Guard<ACE_Thread_Mutex> g(lockForModels);
-        if (mmap->navMeshQueries.find(tid) == mmap->navMeshQueries.end())
-        {
-            // allocate mesh query
-            dtNavMeshQuery* query = dtAllocNavMeshQuery();
-            MANGOS_ASSERT(query);
-            if (dtStatusFailed(query->init(mmap->navMesh, 2048)))
-            {
-                dtFreeNavMeshQuery(query);
-                sLog.outError("MMAP:GetNavMeshQuery: Failed to initialize dtNavMeshQuery for displayid %03u tid %u", displayId, tid);
-                return NULL;
-            }
-
-            DETAIL_LOG("MMAP:GetNavMeshQuery: created dtNavMeshQuery for displayid %03u tid %u", displayId, tid);
-            mmap->navMeshQueries.insert(std::pair<uint32, dtNavMeshQuery*>(tid, query));
-        }
-    }
-
-    return mmap->navMeshQueries[tid];
+    MMapDataSet::iterator it = loadedModels.find(displayId);
+    if (it == loadedModels.end())
+        return NavMeshQueryHandle();
+
+    NavMeshQueryHandle query = it->second->navMeshQueries.Acquire();
+    if (!query)
+        sLog.outError("MMAP:GetModelNavMeshQuery: Failed to initialize dtNavMeshQuery for displayid %03u", displayId);
+    return query;
 }
 }
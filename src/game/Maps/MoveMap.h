@@ -25,6 +25,10 @@
 
 #include "Platform/CompilerDefs.h"
 #include "Platform/Define.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include "Detour/Include/DetourAlloc.h"
@@ -46,26 +50,111 @@ inline void dtCustomFree(void* ptr)
 namespace MMAP
 {
     typedef std::unordered_map<uint32, dtTileRef> MMapTileSet;
-    typedef std::unordered_map<uint32, dtNavMeshQuery*> NavMeshQuerySet;
+
+    class NavMeshQueryPool;
+
+    // dtNavMeshQuery checked out of a pool, given back when the handle is destroyed.
+    // Must not be kept longer than the computation it is used for.
+    class NavMeshQueryHandle
+    {
+        public:
+            NavMeshQueryHandle() : m_pool(nullptr), m_slot(0), m_query(nullptr) {}
+            NavMeshQueryHandle(NavMeshQueryPool* pool, uint32 slot, dtNavMeshQuery* query) : m_pool(pool), m_slot(slot), m_query(query) {}
+            NavMeshQueryHandle(NavMeshQueryHandle&& other) : m_pool(other.m_pool), m_slot(other.m_slot), m_query(other.m_query) { other.m_pool = nullptr; other.m_query = nullptr; }
+            NavMeshQueryHandle& operator=(NavMeshQueryHandle&& other);
+            ~NavMeshQueryHandle() { Release(); }
+
+            void Release();
+
+            dtNavMeshQuery const* get() const { return m_query; }
+            dtNavMeshQuery const* operator->() const { return m_query; }
+            explicit operator bool() const { return m_query != nullptr; }
+
+        private:
+            NavMeshQueryHandle(NavMeshQueryHandle const&);
+            NavMeshQueryHandle& operator=(NavMeshQueryHandle const&);
+
+            NavMeshQueryPool* m_pool;
+            uint32 m_slot;
+            dtNavMeshQuery* m_query;
+    };
+
+    struct NavMeshQueryPoolStats
+    {
+        NavMeshQueryPoolStats() : created(0), inUse(0), maxQueries(0), checkouts(0), waits(0), waitUs(0), maxWaitUs(0) {}
+        void Add(NavMeshQueryPoolStats const& other);
+
+        uint32 created;
+        uint32 inUse;
+        uint32 maxQueries;
+        uint64 checkouts;
+        uint64 waits;                       // checkouts that found every query of the pool in use
+        uint64 waitUs;
+        uint64 maxWaitUs;
+    };
+
+    // Fixed number of queries shared by all the threads using a navmesh, since those are not thread safe.
+    // Queries are created on demand up to the limit, then reused. A checkout only blocks when all of
+    // them are in use, otherwise it takes a free slot without locking.
+    class NavMeshQueryPool
+    {
+        public:
+            NavMeshQueryPool(dtNavMesh const* mesh, uint32 maxQueries, uint32 preallocated);
+            ~NavMeshQueryPool();
+
+            // Returns an empty handle only if a query could not be initialized
+            NavMeshQueryHandle Acquire();
+            void Release(uint32 slot);
+
+            NavMeshQueryPoolStats GetStats() const;
+
+        private:
+            enum SlotState
+            {
+                SLOT_EMPTY,                 // query not created yet
+                SLOT_FREE,
+                SLOT_BUSY
+            };
+
+            struct Slot
+            {
+                Slot() : state(SLOT_EMPTY), query(nullptr) {}
+                std::atomic<uint8> state;
+                dtNavMeshQuery* query;      // only accessed by the thread that moved the slot to SLOT_BUSY
+            };
+
+            bool TryAcquire(uint32& slot, dtNavMeshQuery*& query, bool& failed);
+            dtNavMeshQuery* CreateQuery();
+
+            dtNavMesh const* m_navMesh;
+            uint32 const m_maxQueries;
+            std::unique_ptr<Slot[]> m_slots;
+
+            std::mutex m_waitLock;
+            std::condition_variable m_queryReleased;
+            std::atomic<uint32> m_waiters;
+
+            std::atomic<uint32> m_created;
+            std::atomic<uint32> m_inUse;
+            std::atomic<uint64> m_checkouts;
+            std::atomic<uint64> m_waits;
+            std::atomic<uint64> m_waitUs;
+            std::atomic<uint64> m_maxWaitUs;
+    };
 
     // dummy struct to hold map's mmap data
     struct MMapData
     {
-        MMapData(dtNavMesh* mesh) : navMesh(mesh) {}
+        MMapData(dtNavMesh* mesh, uint32 maxQueries, uint32 preallocatedQueries) : navMesh(mesh), navMeshQueries(mesh, maxQueries, preallocatedQueries) {}
         ~MMapData()
         {
-            for (NavMeshQuerySet::iterator i = navMeshQueries.begin(); i != navMeshQueries.end(); ++i)
-                dtFreeNavMeshQuery(i->second);
-
             if (navMesh)
                 dtFreeNavMesh(navMesh);
         }
 
         dtNavMesh* navMesh;
 
-        // we have to use single dtNavMeshQuery for every instance, since those are not thread safe
-        NavMeshQuerySet navMeshQueries;     // threadId to query
-        ACE_RW_Mutex navMeshQueries_lock;
+        NavMeshQueryPool navMeshQueries;
         MMapTileSet mmapLoadedTiles;        // maps [map grid coords] to [dtTile]
         ACE_Thread_Mutex tilesLoading_lock;
     };
@@ -77,21 +166,24 @@ namespace MMAP
     class MMapManager
     {
         public:
-            MMapManager() : loadedTiles(0) {}
+            MMapManager() : loadedTiles(0), maxQueries(16), preallocatedQueries(2) {}
             ~MMapManager();
 
             bool loadMap(uint32 mapId, int32 x, int32 y);
             bool loadGameObject(uint32 displayId);
             bool unloadMap(uint32 mapId, int32 x, int32 y);
             bool unloadMap(uint32 mapId);
-            bool unloadMapInstance(uint32 mapId, uint32 instanceId);
 
-            // The returned [dtNavMeshQuery const*] is NOT threadsafe
-            // Returns a NavMeshQuery valid for current thread only.
-            dtNavMeshQuery const* GetNavMeshQuery(uint32 mapId);
-            dtNavMeshQuery const* GetModelNavMeshQuery(uint32 displayId);
+            // The query is reserved to the caller until the handle is destroyed
+            NavMeshQueryHandle GetNavMeshQuery(uint32 mapId);
+            NavMeshQueryHandle GetModelNavMeshQuery(uint32 displayId);
             dtNavMesh const* GetNavMesh(uint32 mapId);
 
+            // Applies to the navmeshes loaded afterwards
+            void SetQueryPoolSize(uint32 maxQueriesPerMap, uint32 preallocatedPerMap);
+            bool GetQueryPoolStats(uint32 mapId, NavMeshQueryPoolStats& stats);
+            NavMeshQueryPoolStats GetQueryPoolsStats();
+
             uint32 getLoadedTilesCount() const { return loadedTiles; }
             uint32 getLoadedMapsCount() const { return loadedMMaps.size(); }
         private:
@@ -102,7 +194,8 @@ namespace MMAP
             ACE_RW_Mutex loadedMMaps_lock;
             MMapDataSet loadedModels;
             uint32 loadedTiles;
-            ACE_Thread_Mutex lockForModels;
+            uint32 maxQueries;
+            uint32 preallocatedQueries;
     };
 
     // static class
@@ -23,6 +23,7 @@
 #include "Log.h"
 #include "Map.h"
 #include "Transport.h"
+#include "Policies/SingletonImp.h"
 
 #include "Detour/Include/DetourCommon.h"
 
@@ -31,6 +32,154 @@
 // Distance between path steps
 #define SMOOTH_PATH_STEP_SIZE 2.0f
 
+INSTANTIATE_SINGLETON_1(PathCorridorCache);
+
+////////////////// PathCorridorCache //////////////////
+PathCorridorCache::PathCorridorCache() : m_shardCapacity(0), m_hits(0), m_misses(0)
+{
+}
+
+size_t PathCorridorCache::KeyHash::operator()(Key const& key) const
+{
+    size_t hash = std::hash<uint64>()(uint64(key.startPoly));
+    hash ^= std::hash<uint64>()(uint64(key.endPoly)) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<uint64>()((uint64(key.navMeshId) << 33) | (uint64(key.model) << 32) | (uint32(key.includeFlags) << 16) | key.excludeFlags)
+            + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+PathCorridorCache::Key PathCorridorCache::MakeKey(uint32 navMeshId, bool model, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter)
+{
+    Key key;
+    key.startPoly = startPoly;
+    key.endPoly = endPoly;
+    key.navMeshId = navMeshId;
+    key.model = model;
+    key.includeFlags = filter.getIncludeFlags();
+    key.excludeFlags = filter.getExcludeFlags();
+    return key;
+}
+
+PathCorridorCache::Shard& PathCorridorCache::GetShard(Key const& key)
+{
+    return m_shards[KeyHash()(key) % SHARDS];
+}
+
+void PathCorridorCache::SetCapacity(uint32 entries)
+{
+    m_shardCapacity = entries ? std::max<uint32>(entries / SHARDS, 1) : 0;
+    for (Shard& shard : m_shards)
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        while (shard.entries.size() > m_shardCapacity)
+        {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+        }
+    }
+}
+
+bool PathCorridorCache::Find(uint32 navMeshId, bool model, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter, dtPolyRef* path, uint32& length)
+{
+    if (!m_shardCapacity)
+        return false;
+
+    Key key = MakeKey(navMeshId, model, startPoly, endPoly, filter);
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end())
+    {
+        ++m_misses;
+        return false;
+    }
+
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    std::vector<dtPolyRef> const& corridor = it->second->second;
+    length = corridor.size();
+    memcpy(path, corridor.data(), sizeof(dtPolyRef) * length);
+    ++m_hits;
+    return true;
+}
+
+void PathCorridorCache::Insert(uint32 navMeshId, bool model, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter, dtPolyRef const* path, uint32 length)
+{
+    uint32 capacity = m_shardCapacity;
+    if (!capacity || !length)
+        return;
+
+    Key key = MakeKey(navMeshId, model, startPoly, endPoly, filter);
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end())
+    {
+        it->second->second.assign(path, path + length);
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+
+    shard.entries.emplace_front(key, std::vector<dtPolyRef>(path, path + length));
+    shard.index[key] = shard.entries.begin();
+    while (shard.entries.size() > capacity)
+    {
+        shard.index.erase(shard.entries.back().first);
+        shard.entries.pop_back();
+    }
+}
+
+void PathCorridorCache::Erase(uint32 navMeshId, bool model, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter)
+{
+    Key key = MakeKey(navMeshId, model, startPoly, endPoly, filter);
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end())
+        return;
+
+    shard.entries.erase(it->second);
+    shard.index.erase(it);
+}
+
+void PathCorridorCache::Invalidate(uint32 mapId)
+{
+    for (Shard& shard : m_shards)
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        for (EntryList::iterator it = shard.entries.begin(); it != shard.entries.end();)
+        {
+            if (!it->first.model && it->first.navMeshId == mapId)
+            {
+                shard.index.erase(it->first);
+                it = shard.entries.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+}
+
+PathCorridorCacheStats PathCorridorCache::GetStats()
+{
+    PathCorridorCacheStats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.entries = 0;
+    stats.capacity = m_shardCapacity * SHARDS;
+    for (Shard& shard : m_shards)
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        stats.entries += shard.entries.size();
+    }
+    return stats;
+}
+
+void PathCorridorCache::ResetStats()
+{
+    m_hits = 0;
+    m_misses = 0;
+}
+
 ////////////////// PathInfo //////////////////
 PathInfo::PathInfo(const Unit* owner) :
     m_polyLength(0), m_type(PATHFIND_BLANK),
@@ -41,6 +190,15 @@ PathInfo::PathInfo(const Unit* owner) :
     createFilter();
 }
 
+PathInfo::PathInfo(PathInfo const& other, Unit const* owner) :
+    m_polyLength(other.m_polyLength), m_pathPoints(other.m_pathPoints), m_type(other.m_type),
+    m_useStraightPath(other.m_useStraightPath), m_forceDestination(other.m_forceDestination), m_pointPathLimit(other.m_pointPathLimit),
+    m_startPosition(other.m_startPosition), m_endPosition(other.m_endPosition), m_actualEndPosition(other.m_actualEndPosition),
+    m_transport(other.m_transport), m_sourceUnit(owner), m_navMesh(other.m_navMesh), m_navMeshQuery(NULL),
+    m_targetAllowedFlags(other.m_targetAllowedFlags), m_filter(other.m_filter)
+{
+    memcpy(m_pathPolyRefs, other.m_pathPolyRefs, sizeof(dtPolyRef) * m_polyLength);
+}
 
 PathInfo::~PathInfo()
 {
@@ -55,20 +213,29 @@ void PathInfo::setPathLengthLimit(float dist)
 bool PathInfo::calculate(float destX, float destY, float destZ, bool forceDest, bool offsets)
 {
     // A m_navMeshQuery object is not thread safe, but a same PathInfo can be shared between threads.
-    // So need to get a new one.
+    // So need to get a new one, given back to the pool once the path is built.
     MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
+    MMAP::NavMeshQueryHandle query;
     if (m_transport)
     {
         if (!offsets)
             m_transport->CalculatePassengerOffset(destX, destY, destZ);
-        m_navMeshQuery = mmap->GetModelNavMeshQuery(m_transport->GetDisplayId());
+        query = mmap->GetModelNavMeshQuery(m_transport->GetDisplayId());
     }
     else
-        m_navMeshQuery = mmap->GetNavMeshQuery(m_sourceUnit->GetMapId());
+        query = mmap->GetNavMeshQuery(m_sourceUnit->GetMapId());
 
+    m_navMeshQuery = query.get();
     if (m_navMeshQuery)
         m_navMesh = m_navMeshQuery->getAttachedNavMesh();
 
+    bool updated = calculateWithQuery(destX, destY, destZ, forceDest);
+    m_navMeshQuery = NULL;
+    return updated;
+}
+
+bool PathInfo::calculateWithQuery(float destX, float destY, float destZ, bool forceDest)
+{
     m_pathPoints.clear();
 
     Vector3 oldDest = getEndPosition();
@@ -350,23 +517,41 @@ void PathInfo::BuildPolyPath(const Vector3 &startPos, const Vector3 &endPos)
         //if (threadId != m_navMeshQuery->m_owningThread)
             //sLog.outError("CRASH: We are using a dtNavMeshQuery from thread %u which belongs to thread %u!", threadId, m_navMeshQuery->m_owningThread);
 
-        dtStatus dtResult = m_navMeshQuery->findPath(
-                                startPoly,          // start polygon
-                                endPoly,            // end polygon
-                                startPoint,         // start position
-                                endPoint,           // end position
-                                &m_filter,           // polygon search filter
-                                m_pathPolyRefs,     // [out] path
-                                (int*)&m_polyLength,
-                                MAX_PATH_LENGTH);   // max number of polygons in output path
+        // another unit may already have gone from this poly to that one
+        uint32 navMeshId = m_transport ? m_transport->GetDisplayId() : m_sourceUnit->GetMapId();
+        bool cached = sPathCorridorCache.Find(navMeshId, m_transport != NULL, startPoly, endPoly, m_filter, m_pathPolyRefs, m_polyLength);
+        for (uint32 i = 0; cached && i < m_polyLength; ++i)
+            if (!m_navMesh->isValidPolyRef(m_pathPolyRefs[i]))
+            {
+                // Crosses a tile unloaded since, the search below replaces it if it succeeds
+                sPathCorridorCache.Erase(navMeshId, m_transport != NULL, startPoly, endPoly, m_filter);
+                cached = false;
+            }
 
-        if (!m_polyLength || dtStatusFailed(dtResult))
+        if (!cached)
         {
-            // only happens if we passed bad data to findPath(), or navmesh is messed up
-            sLog.outError("%u's Path Build failed: 0 length path. Result=0x%x", m_sourceUnit->GetGUIDLow(), dtResult);
-            BuildShortcut();
-            m_type = PATHFIND_NOPATH;
-            return;
+            dtStatus dtResult = m_navMeshQuery->findPath(
+                                    startPoly,          // start polygon
+                                    endPoly,            // end polygon
+                                    startPoint,         // start position
+                                    endPoint,           // end position
+                                    &m_filter,           // polygon search filter
+                                    m_pathPolyRefs,     // [out] path
+                                    (int*)&m_polyLength,
+                                    MAX_PATH_LENGTH);   // max number of polygons in output path
+
+            if (!m_polyLength || dtStatusFailed(dtResult))
+            {
+                // only happens if we passed bad data to findPath(), or navmesh is messed up
+                sLog.outError("%u's Path Build failed: 0 length path. Result=0x%x", m_sourceUnit->GetGUIDLow(), dtResult);
+                BuildShortcut();
+                m_type = PATHFIND_NOPATH;
+                return;
+            }
+            // A partial corridor may stop at a tile not loaded yet, loading it keeps the cut corridor valid
+            if (m_pathPolyRefs[m_polyLength - 1] == endPoly &&
+                    !dtStatusDetail(dtResult, DT_PARTIAL_RESULT) && !dtStatusDetail(dtResult, DT_OUT_OF_NODES))
+                sPathCorridorCache.Insert(navMeshId, m_transport != NULL, startPoly, endPoly, m_filter, m_pathPolyRefs, m_polyLength);
         }
     }
 
@@ -514,21 +699,27 @@ void PathInfo::BuildUnderwaterPath()
     m_type |= PATHFIND_UNDERWATER;
 }
 
-void PathInfo::createFilter()
+void PathInfo::GetFilterFlags(Unit const* unit, unsigned short& includeFlags, unsigned short& excludeFlags)
 {
-    unsigned short includeFlags = 0x0;
-    unsigned short excludeFlags = 0x0;
+    includeFlags = 0x0;
+    excludeFlags = 0x0;
 
-    if (m_sourceUnit->CanWalk())
+    if (unit->CanWalk())
         includeFlags |= NAV_GROUND;          // walk
 
-    if (m_sourceUnit->CanSwim())
+    if (unit->CanSwim())
     {
-        if (m_sourceUnit->GetTypeId() == TYPEID_PLAYER)
+        if (unit->GetTypeId() == TYPEID_PLAYER)
             includeFlags |= NAV_WATER;
         else // creatures don't take environmental damage
             includeFlags |= (NAV_WATER | NAV_MAGMA | NAV_SLIME);
     }
+}
+
+void PathInfo::createFilter()
+{
+    unsigned short includeFlags, excludeFlags;
+    GetFilterFlags(m_sourceUnit, includeFlags, excludeFlags);
 
     m_filter.setIncludeFlags(includeFlags);
     m_filter.setExcludeFlags(excludeFlags);
@@ -24,6 +24,12 @@
 #include "../recastnavigation/Detour/Include/DetourNavMesh.h"
 #include "../recastnavigation/Detour/Include/DetourNavMeshQuery.h"
 #include "MoveSplineInitArgs.h"
+#include "Policies/Singleton.h"
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 
 using Movement::Vector3;
@@ -56,10 +62,90 @@ enum PathType
     PATHFIND_CASTER         = 0x0100,
 };
 
+struct PathCorridorCacheStats
+{
+    uint64 hits;
+    uint64 misses;
+    uint32 entries;
+    uint32 capacity;
+};
+
+/**
+ * Polygon paths found by Detour between two polygons, shared by all the path searches.
+ * Guards going to the same gate, or creatures evading to the same spot, only search
+ * their corridor once. The point path still depends on the exact start and end
+ * positions, so it is built from the corridor at each search.
+ */
+class PathCorridorCache
+{
+    public:
+        PathCorridorCache();
+
+        // 0 disables the cache
+        void SetCapacity(uint32 entries);
+
+        // navMeshId is the map id, or the display id for transport models
+        bool Find(uint32 navMeshId, bool model, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter, dtPolyRef* path, uint32& length);
+        void Insert(uint32 navMeshId, bool model, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter, dtPolyRef const* path, uint32 length);
+        // Forgets a corridor going through a polygon that is not loaded anymore
+        void Erase(uint32 navMeshId, bool model, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter);
+
+        // Forgets the corridors of a map, when it is unloaded. The polygon references of
+        // an unloaded tile are not valid anymore, even if the tile is loaded again.
+        void Invalidate(uint32 mapId);
+
+        PathCorridorCacheStats GetStats();
+        void ResetStats();
+
+    private:
+        struct Key
+        {
+            bool operator==(Key const& other) const
+            {
+                return startPoly == other.startPoly && endPoly == other.endPoly && navMeshId == other.navMeshId &&
+                       model == other.model && includeFlags == other.includeFlags && excludeFlags == other.excludeFlags;
+            }
+
+            dtPolyRef startPoly;
+            dtPolyRef endPoly;
+            uint32 navMeshId;
+            bool model;
+            uint16 includeFlags;
+            uint16 excludeFlags;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(Key const& key) const;
+        };
+
+        typedef std::list<std::pair<Key, std::vector<dtPolyRef> > > EntryList;
+
+        // Locked separately so that concurrent searches rarely wait for each other
+        struct Shard
+        {
+            std::mutex lock;
+            EntryList entries;              // most recently used first
+            std::unordered_map<Key, EntryList::iterator, KeyHash> index;
+        };
+
+        static Key MakeKey(uint32 navMeshId, bool model, dtPolyRef startPoly, dtPolyRef endPoly, dtQueryFilter const& filter);
+        Shard& GetShard(Key const& key);
+
+        static uint32 const SHARDS = 16;
+        Shard m_shards[SHARDS];
+        std::atomic<uint32> m_shardCapacity;
+        std::atomic<uint64> m_hits;
+        std::atomic<uint64> m_misses;
+};
+
+#define sPathCorridorCache MaNGOS::Singleton<PathCorridorCache>::Instance()
+
 class PathInfo
 {
     public:
         PathInfo(Unit const* owner);
+        PathInfo(PathInfo const& other, Unit const* owner); // path computed for another unit
         ~PathInfo();
 
         // return value : true if new path was calculated
@@ -88,6 +174,9 @@ class PathInfo
         static dtPolyRef FindWalkPoly(dtNavMeshQuery const* query, float const* pointYZX, dtQueryFilter const& filter, float* closestPointYZX, float zSearchDist = 10.0f);
         void SetTransport(Transport* t) { m_transport = t; }
         Transport* GetTransport() const { return m_transport; }
+        dtQueryFilter const& GetFilter() const { return m_filter; }
+        // Navigation flags of the filter a path of this unit starts with
+        static void GetFilterFlags(Unit const* unit, unsigned short& includeFlags, unsigned short& excludeFlags);
         void FillTargetAllowedFlags(Unit* target);
     private:
 
@@ -107,11 +196,14 @@ class PathInfo
         Transport*     m_transport;
         const Unit* const       m_sourceUnit;       // the unit that is moving
         const dtNavMesh*        m_navMesh;          // the nav mesh
-        const dtNavMeshQuery*   m_navMeshQuery;     // the nav mesh query used to find the path
+        const dtNavMeshQuery*   m_navMeshQuery;     // the nav mesh query used to find the path, only set during calculate()
         uint32          m_targetAllowedFlags;
 
         dtQueryFilter m_filter;                     // use single filter for all movements, update it when needed
 
+        // Body of calculate(), while m_navMeshQuery is checked out of the pool
+        bool calculateWithQuery(float destX, float destY, float destZ, bool forceDest);
+
         inline void setStartPosition(Vector3 point) { m_startPosition = point; }
         inline void setEndPosition(Vector3 point) { m_actualEndPosition = point; m_endPosition = point; }
         inline void setActualEndPosition(Vector3 point) { m_actualEndPosition = point; }
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "PathRequestQueue.h"
+#include "Map.h"
+#include "Unit.h"
+#include "ThreadPool.h"
+#include "Transport.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+// Size of the grid positions are snapped to before comparing requests, in yards
+#define PATH_REQUEST_PRECISION 1.0f
+
+typedef std::chrono::steady_clock PathClock;
+
+static inline int32 Quantize(float value)
+{
+    return int32(std::floor(value / PATH_REQUEST_PRECISION));
+}
+
+bool PathRequestQueue::Key::operator==(Key const& other) const
+{
+    return start[0] == other.start[0] && start[1] == other.start[1] && start[2] == other.start[2] &&
+           dest[0] == other.dest[0] && dest[1] == other.dest[1] && dest[2] == other.dest[2] &&
+           transport == other.transport && includeFlags == other.includeFlags && excludeFlags == other.excludeFlags &&
+           forceDest == other.forceDest && ignorePathfinding == other.ignorePathfinding;
+}
+
+size_t PathRequestQueue::KeyHash::operator()(Key const& key) const
+{
+    size_t hash = std::hash<uint64>()(key.transport.GetRawValue());
+    auto combine = [&hash](size_t value) { hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2); };
+    for (int i = 0; i < 3; ++i)
+    {
+        combine(std::hash<int32>()(key.start[i]));
+        combine(std::hash<int32>()(key.dest[i]));
+    }
+    combine((uint32(key.includeFlags) << 16) | key.excludeFlags);
+    combine((key.forceDest ? 1 : 0) | (key.ignorePathfinding ? 2 : 0));
+    return hash;
+}
+
+PathRequestQueue::Ticket PathRequestQueue::Submit(Unit const* unit, Transport* transport, float x, float y, float z, bool forceDest)
+{
+    Key key;
+    key.start[0] = Quantize(unit->GetPositionX());
+    key.start[1] = Quantize(unit->GetPositionY());
+    key.start[2] = Quantize(unit->GetPositionZ());
+    key.dest[0] = Quantize(x);
+    key.dest[1] = Quantize(y);
+    key.dest[2] = Quantize(z);
+    key.transport = transport ? transport->GetObjectGuid() : ObjectGuid();
+    // Same filter as the search would use
+    PathInfo::GetFilterFlags(unit, key.includeFlags, key.excludeFlags);
+    key.forceDest = forceDest;
+    key.ignorePathfinding = unit->hasUnitState(UNIT_STAT_IGNORE_PATHFINDING);
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    Ticket ticket = m_nextTicket++;
+    auto it = m_pendingByKey.find(key);
+    if (it != m_pendingByKey.end())
+    {
+        m_pendingTickets[ticket] = it->second;
+        return ticket;
+    }
+
+    Request request;
+    request.unit = unit->GetObjectGuid();
+    request.transport = key.transport;
+    request.x = x;
+    request.y = y;
+    request.z = z;
+    request.forceDest = forceDest;
+    m_pendingByKey[key] = m_pending.size();
+    m_pendingTickets[ticket] = m_pending.size();
+    m_pending.push_back(request);
+    return ticket;
+}
+
+PathRequestQueue::Status PathRequestQueue::Fetch(Ticket ticket, Result& result)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    auto it = m_results.find(ticket);
+    if (it != m_results.end())
+    {
+        result = it->second;
+        m_results.erase(it);
+        return PATH_REQUEST_READY;
+    }
+    return m_pendingTickets.find(ticket) != m_pendingTickets.end() ? PATH_REQUEST_PENDING : PATH_REQUEST_EXPIRED;
+}
+
+void PathRequestQueue::Process(Map* map, ThreadPool* pool, uint32 threads, TaskPhaseStats* stats)
+{
+    std::vector<Request> requests;
+    uint32 expired;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        expired = m_results.size();
+        m_results.clear();
+        requests.swap(m_pending);
+        m_pendingByKey.clear();
+    }
+
+    m_lastBatch.Reset();
+    m_lastBatch.expired = expired;
+    m_total.expired += expired;
+    if (requests.empty())
+        return;
+
+    PathClock::time_point batchStart = PathClock::now();
+
+    // Resolved here, requesters and transports may have left the map since they asked
+    std::vector<Unit*> units(requests.size(), nullptr);
+    std::vector<Transport*> transports(requests.size(), nullptr);
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        Unit* unit = map->GetUnit(requests[i].unit);
+        if (!unit || !unit->IsInWorld() || unit->GetMap() != map)
+            continue;
+        if (!requests[i].transport.IsEmpty())
+        {
+            transports[i] = map->GetTransport(requests[i].transport);
+            if (!transports[i])
+                continue;
+        }
+        units[i] = unit;
+    }
+
+    std::vector<Result> results(requests.size());
+    std::atomic<uint64> maxSearchUs(0);
+    auto search = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (!units[i])
+                continue;
+
+            PathClock::time_point start = PathClock::now();
+            Request const& request = requests[i];
+            std::shared_ptr<PathInfo> path = std::make_shared<PathInfo>(units[i]);
+            path->SetTransport(transports[i]);
+            path->calculate(request.x, request.y, request.z, request.forceDest);
+            results[i] = path;
+
+            uint64 elapsed = std::chrono::duration_cast<std::chrono::microseconds>(PathClock::now() - start).count();
+            uint64 current = maxSearchUs.load(std::memory_order_relaxed);
+            while (current < elapsed && !maxSearchUs.compare_exchange_weak(current, elapsed, std::memory_order_relaxed))
+                ;
+        }
+    };
+    if (pool && threads > 1)
+        pool->ParallelFor(requests.size(), threads, search, stats);
+    else
+        search(0, requests.size());
+
+    uint32 answered = 0;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        for (auto const& pending : m_pendingTickets)
+        {
+            if (results[pending.second])
+                m_results[pending.first] = results[pending.second];
+            ++answered;
+        }
+        m_pendingTickets.clear();
+    }
+
+    m_lastBatch.requests = answered;
+    m_lastBatch.searches = requests.size();
+    m_lastBatch.shared = answered - requests.size();
+    m_lastBatch.batchUs = std::chrono::duration_cast<std::chrono::microseconds>(PathClock::now() - batchStart).count();
+    m_lastBatch.maxSearchUs = maxSearchUs;
+
+    m_total.requests += m_lastBatch.requests;
+    m_total.searches += m_lastBatch.searches;
+    m_total.shared += m_lastBatch.shared;
+    m_total.batchUs += m_lastBatch.batchUs;
+    m_total.maxSearchUs = std::max(m_total.maxSearchUs, m_lastBatch.maxSearchUs);
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_PATHREQUESTQUEUE_H
+#define MANGOS_PATHREQUESTQUEUE_H
+
+#include "Platform/Define.h"
+#include "ObjectGuid.h"
+#include "PathFinder.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class Map;
+class ThreadPool;
+class Transport;
+class Unit;
+struct TaskPhaseStats;
+
+struct PathRequestStats
+{
+    PathRequestStats() { Reset(); }
+    void Reset() { requests = 0; searches = 0; shared = 0; expired = 0; batchUs = 0; maxSearchUs = 0; }
+
+    uint32 requests;
+    uint32 searches;                                        // requests actually computed
+    uint32 shared;                                          // requests answered by the search of an identical one
+    uint32 expired;                                         // results not fetched before the next batch
+    uint64 batchUs;
+    uint64 maxSearchUs;
+};
+
+/**
+ * Path searches of the movement generators of one map, computed together once
+ * per cells update on the thread pool. A request made during a tick is answered
+ * at the next one. Requests from the same place to the same place with the same
+ * navigation flags (a pack chasing the same player for example) share one search.
+ */
+class PathRequestQueue
+{
+    public:
+        typedef uint64 Ticket;
+        typedef std::shared_ptr<PathInfo const> Result;
+
+        enum Status
+        {
+            PATH_REQUEST_PENDING,
+            PATH_REQUEST_READY,
+            PATH_REQUEST_EXPIRED                            // unknown ticket, or result not fetched in time
+        };
+
+        PathRequestQueue() : m_nextTicket(1) {}
+
+        // Thread safe
+        Ticket Submit(Unit const* unit, Transport* transport, float x, float y, float z, bool forceDest);
+        Status Fetch(Ticket ticket, Result& result);
+
+        // Computes the pending requests. Must be called by the map update thread, while no unit of the map is updated.
+        void Process(Map* map, ThreadPool* pool, uint32 threads, TaskPhaseStats* stats);
+
+        PathRequestStats const& GetLastBatchStats() const { return m_lastBatch; }
+        PathRequestStats const& GetTotalStats() const { return m_total; }
+        void ResetStats() { m_total.Reset(); }
+
+    private:
+        struct Key
+        {
+            bool operator==(Key const& other) const;
+
+            int32 start[3];                                 // quantized positions
+            int32 dest[3];
+            ObjectGuid transport;
+            uint16 includeFlags;
+            uint16 excludeFlags;
+            bool forceDest;
+            bool ignorePathfinding;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(Key const& key) const;
+        };
+
+        struct Request
+        {
+            ObjectGuid unit;
+            ObjectGuid transport;                           // resolved at processing time, as the unit
+            float x, y, z;
+            bool forceDest;
+        };
+
+        std::mutex m_lock;
+        Ticket m_nextTicket;
+        std::vector<Request> m_pending;
+        std::unordered_map<Key, uint32, KeyHash> m_pendingByKey;
+        std::unordered_map<Ticket, uint32> m_pendingTickets;    // ticket to index in m_pending
+        std::unordered_map<Ticket, Result> m_results;           // answers of the last batch
+
+        PathRequestStats m_lastBatch;
+        PathRequestStats m_total;
+};
+
+#endif
@@ -32,7 +32,7 @@
 
 //-----------------------------------------------//
 template<class T, typename D>
-void TargetedMovementGeneratorMedium<T, D>::_setTargetLocation(T &owner)
+void TargetedMovementGeneratorMedium<T, D>::_setTargetLocation(T &owner, bool batched)
 {
     // Note: Any method that accesses the target's movespline here must be
     // internally locked by the target's spline lock
@@ -97,13 +97,29 @@ void TargetedMovementGeneratorMedium<T, D>::_setTargetLocation(T &owner)
     m_bTargetOnTransport = transport;
     i_target->GetPosition(m_fTargetLastX, m_fTargetLastY, m_fTargetLastZ, transport);
 
-    PathFinder path(&owner);
-
     // allow pets following their master to cheat while generating paths
     bool petFollowing = (isPet && owner.hasUnitState(UNIT_STAT_FOLLOW));
-    Movement::MoveSplineInit init(owner, "TargetedMovementGenerator");
+    if (batched && sWorld.getConfig(CONFIG_UINT32_PATH_REQUESTS_THREADS))
+    {
+        m_pathTicket = owner.GetMap()->GetPathRequests().Submit(&owner, transport, x, y, z, petFollowing);
+        m_bRecalculateTravel = false;
+        return;
+    }
+
+    PathFinder path(&owner);
     path.SetTransport(transport);
     path.calculate(x, y, z, petFollowing);
+    m_bRecalculateTravel = false;
+    _applyPath(owner, path, losChecked, losResult);
+}
+
+template<class T, typename D>
+void TargetedMovementGeneratorMedium<T, D>::_applyPath(T &owner, PathFinder& path, bool losChecked, bool losResult)
+{
+    Transport* transport = path.GetTransport();
+    bool isPet = (owner.GetTypeId() == TYPEID_UNIT && ((Creature*)&owner)->IsPet());
+    bool petFollowing = (isPet && owner.hasUnitState(UNIT_STAT_FOLLOW));
+    Movement::MoveSplineInit init(owner, "TargetedMovementGenerator");
 
     PathType pathType = path.getPathType();
     m_bReachable = pathType & PATHFIND_NORMAL;
@@ -121,7 +137,6 @@ void TargetedMovementGeneratorMedium<T, D>::_setTargetLocation(T &owner)
             m_bReachable = false;
     }
 
-    m_bRecalculateTravel = false;
     if (this->GetMovementGeneratorType() == CHASE_MOTION_TYPE && !transport && owner.HasDistanceCasterMovement())
         if (path.UpdateForCaster(i_target.getTarget(), owner.GetMinChaseDistance(i_target.getTarget())))
         {
@@ -221,7 +236,7 @@ void TargetedMovementGeneratorMedium<Creature, FollowMovementGenerator<Creature>
 template<class T, typename D>
 void TargetedMovementGeneratorMedium<T, D>::UpdateAsync(T &owner, uint32 /*diff*/)
 {
-    if (!m_bRecalculateTravel)
+    if (!m_bRecalculateTravel && !m_pathTicket)
         return;
     // All these cases will be handled at next sync update
     if (!i_target.isValid() || !i_target->IsInWorld() || !owner.isAlive() || owner.hasUnitState(UNIT_STAT_CAN_NOT_MOVE | UNIT_STAT_CONTROLLED)
@@ -232,7 +247,30 @@ void TargetedMovementGeneratorMedium<T, D>::UpdateAsync(T &owner, uint32 /*diff*
 
     // Lock async updates for safety, see Unit::asyncMovesplineLock doc
     ACE_Guard<ACE_Thread_Mutex> guard(owner.asyncMovesplineLock);
-    _setTargetLocation(owner);
+    if (m_pathTicket)
+    {
+        PathRequestQueue::Result result;
+        switch (owner.GetMap()->GetPathRequests().Fetch(m_pathTicket, result))
+        {
+            case PathRequestQueue::PATH_REQUEST_PENDING:
+                return;
+            case PathRequestQueue::PATH_REQUEST_READY:
+            {
+                // At most one update old, still better than nothing if the target moved again since
+                m_pathTicket = 0;
+                PathFinder path(*result, &owner);
+                _applyPath(owner, path, false, false);
+                break;
+            }
+            case PathRequestQueue::PATH_REQUEST_EXPIRED:
+                m_pathTicket = 0;
+                m_bRecalculateTravel = true;
+                break;
+        }
+    }
+
+    if (m_bRecalculateTravel)
+        _setTargetLocation(owner, true);
 }
 
 template<class T>
@@ -374,6 +412,10 @@ bool ChaseMovementGenerator<T>::Update(T &owner, const uint32 & time_diff)
     }
     else if (m_bRecalculateTravel)
         owner.GetMotionMaster()->SetNeedAsyncUpdate();
+
+    // Batched path, answered at the next cells update
+    if (m_pathTicket)
+        owner.GetMotionMaster()->SetNeedAsyncUpdate();
     return true;
 }
 
@@ -475,6 +517,7 @@ void ChaseMovementGenerator<Player>::Initialize(Player &owner)
 {
     owner.addUnitState(UNIT_STAT_CHASE | UNIT_STAT_CHASE_MOVE);
     m_bRecalculateTravel = true;
+    m_pathTicket = 0;
     owner.GetMotionMaster()->SetNeedAsyncUpdate();
 }
 
@@ -484,6 +527,7 @@ void ChaseMovementGenerator<Creature>::Initialize(Creature &owner)
     owner.SetWalk(false, false);
     owner.addUnitState(UNIT_STAT_CHASE | UNIT_STAT_CHASE_MOVE);
     m_bRecalculateTravel = true;
+    m_pathTicket = 0;
     owner.GetMotionMaster()->SetNeedAsyncUpdate();
 }
 
@@ -630,6 +674,10 @@ bool FollowMovementGenerator<T>::Update(T &owner, const uint32 & time_diff)
     }
     else if (m_bRecalculateTravel)
         owner.GetMotionMaster()->SetNeedAsyncUpdate();
+
+    // Batched path, answered at the next cells update
+    if (m_pathTicket)
+        owner.GetMotionMaster()->SetNeedAsyncUpdate();
     return true;
 }
 
@@ -667,6 +715,7 @@ void FollowMovementGenerator<Player>::Initialize(Player &owner)
 {
     owner.addUnitState(UNIT_STAT_FOLLOW | UNIT_STAT_FOLLOW_MOVE);
     _updateSpeed(owner);
+    m_pathTicket = 0;
     _setTargetLocation(owner);
 }
 
@@ -675,6 +724,7 @@ void FollowMovementGenerator<Creature>::Initialize(Creature &owner)
 {
     owner.addUnitState(UNIT_STAT_FOLLOW | UNIT_STAT_FOLLOW_MOVE);
     _updateSpeed(owner);
+    m_pathTicket = 0;
     _setTargetLocation(owner);
 }
 
@@ -733,10 +783,10 @@ void FollowMovementGenerator<Creature>::MovementInform(Creature& unit)
 }
 
 //-----------------------------------------------//
-template void TargetedMovementGeneratorMedium<Player, ChaseMovementGenerator<Player> >::_setTargetLocation(Player &);
-template void TargetedMovementGeneratorMedium<Player, FollowMovementGenerator<Player> >::_setTargetLocation(Player &);
-template void TargetedMovementGeneratorMedium<Creature, ChaseMovementGenerator<Creature> >::_setTargetLocation(Creature &);
-template void TargetedMovementGeneratorMedium<Creature, FollowMovementGenerator<Creature> >::_setTargetLocation(Creature &);
+template void TargetedMovementGeneratorMedium<Player, ChaseMovementGenerator<Player> >::_setTargetLocation(Player &, bool);
+template void TargetedMovementGeneratorMedium<Player, FollowMovementGenerator<Player> >::_setTargetLocation(Player &, bool);
+template void TargetedMovementGeneratorMedium<Creature, ChaseMovementGenerator<Creature> >::_setTargetLocation(Creature &, bool);
+template void TargetedMovementGeneratorMedium<Creature, FollowMovementGenerator<Creature> >::_setTargetLocation(Creature &, bool);
 template void TargetedMovementGeneratorMedium<Player, ChaseMovementGenerator<Player> >::UpdateAsync(Player &, uint32);
 template void TargetedMovementGeneratorMedium<Player, FollowMovementGenerator<Player> >::UpdateAsync(Player &, uint32);
 template void TargetedMovementGeneratorMedium<Creature, ChaseMovementGenerator<Creature> >::UpdateAsync(Creature &, uint32);
@@ -22,6 +22,7 @@
 #include "MovementGenerator.h"
 #include "FollowerReference.h"
 #include "PathFinder.h"
+#include "PathRequestQueue.h"
 #include "Unit.h"
 
 class MANGOS_DLL_SPEC TargetedMovementGeneratorBase
@@ -41,7 +42,7 @@ class MANGOS_DLL_SPEC TargetedMovementGeneratorMedium
         TargetedMovementGeneratorMedium(Unit &target, float offset, float angle) :
             TargetedMovementGeneratorBase(target), m_checkDistanceTimer(0), m_fOffset(offset),
             m_fAngle(angle), m_bRecalculateTravel(false), m_bTargetReached(false),
-            m_bReachable(true), m_fTargetLastX(0), m_fTargetLastY(0), m_fTargetLastZ(0), m_bTargetOnTransport(false)
+            m_bReachable(true), m_fTargetLastX(0), m_fTargetLastY(0), m_fTargetLastZ(0), m_bTargetOnTransport(false), m_pathTicket(0)
         {
         }
         ~TargetedMovementGeneratorMedium() {}
@@ -61,7 +62,9 @@ class MANGOS_DLL_SPEC TargetedMovementGeneratorMedium
         void UpdateFinalDistance(float fDistance);
 
     protected:
-        void _setTargetLocation(T &);
+        // When batched, the path is asked to the map path queue and used at the next update
+        void _setTargetLocation(T &, bool batched = false);
+        void _applyPath(T &, PathFinder& path, bool losChecked, bool losResult);
 
         ShortTimeTracker m_checkDistanceTimer;
 
@@ -75,6 +78,7 @@ class MANGOS_DLL_SPEC TargetedMovementGeneratorMedium
         float m_fTargetLastY;
         float m_fTargetLastZ;
         bool  m_bTargetOnTransport;
+        PathRequestQueue::Ticket m_pathTicket;
 };
 
 template<class T>
@@ -123,6 +127,7 @@ class MANGOS_DLL_SPEC ChaseMovementGenerator : public TargetedMovementGeneratorM
         using TargetedMovementGeneratorMedium<T, ChaseMovementGenerator<T> >::m_bTargetOnTransport;
         using TargetedMovementGeneratorMedium<T, ChaseMovementGenerator<T> >::m_bRecalculateTravel;
         using TargetedMovementGeneratorMedium<T, ChaseMovementGenerator<T> >::m_bTargetReached;
+        using TargetedMovementGeneratorMedium<T, ChaseMovementGenerator<T> >::m_pathTicket;
 };
 
 template<class T>
@@ -163,6 +168,7 @@ class MANGOS_DLL_SPEC FollowMovementGenerator : public TargetedMovementGenerator
         using TargetedMovementGeneratorMedium<T, FollowMovementGenerator<T> >::m_bTargetOnTransport;
         using TargetedMovementGeneratorMedium<T, FollowMovementGenerator<T> >::m_bRecalculateTravel;
         using TargetedMovementGeneratorMedium<T, FollowMovementGenerator<T> >::m_bTargetReached;
+        using TargetedMovementGeneratorMedium<T, FollowMovementGenerator<T> >::m_pathTicket;
 };
 
 #endif
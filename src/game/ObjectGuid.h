@@ -22,9 +22,11 @@
 #ifndef MANGOS_OBJECT_GUID_H
 #define MANGOS_OBJECT_GUID_H
 
+#include <algorithm>
 #include <functional>
 #include <queue>
 #include <unordered_set>
+#include <vector>
 
 #include "ace/Thread_Mutex.h"
 
@@ -259,6 +261,62 @@ namespace std {
 typedef std::unordered_set<ObjectGuid> ObjectGuidSet;
 typedef std::list<ObjectGuid> GuidList;
 
+// Set of guids stored as a sorted vector: compact, cheap to copy and to compare with another sorted range
+class ObjectGuidSortedSet
+{
+    public:
+        typedef std::vector<ObjectGuid>::const_iterator const_iterator;
+        typedef const_iterator iterator;
+
+        const_iterator begin() const { return m_guids.begin(); }
+        const_iterator end() const { return m_guids.end(); }
+        size_t size() const { return m_guids.size(); }
+        bool empty() const { return m_guids.empty(); }
+        void clear() { m_guids.clear(); }
+
+        const_iterator find(ObjectGuid const& guid) const
+        {
+            const_iterator itr = std::lower_bound(m_guids.begin(), m_guids.end(), guid);
+            return itr != m_guids.end() && *itr == guid ? itr : m_guids.end();
+        }
+        size_t count(ObjectGuid const& guid) const { return find(guid) != end() ? 1 : 0; }
+
+        bool insert(ObjectGuid const& guid)
+        {
+            std::vector<ObjectGuid>::iterator itr = std::lower_bound(m_guids.begin(), m_guids.end(), guid);
+            if (itr != m_guids.end() && *itr == guid)
+                return false;
+            m_guids.insert(itr, guid);
+            return true;
+        }
+        size_t erase(ObjectGuid const& guid)
+        {
+            std::vector<ObjectGuid>::iterator itr = std::lower_bound(m_guids.begin(), m_guids.end(), guid);
+            if (itr == m_guids.end() || *itr != guid)
+                return 0;
+            m_guids.erase(itr);
+            return 1;
+        }
+
+        // Removes the guids also present in 'sorted', which must be in ascending order
+        void EraseSorted(std::vector<ObjectGuid> const& sorted)
+        {
+            std::vector<ObjectGuid>::iterator out = m_guids.begin();
+            std::vector<ObjectGuid>::const_iterator other = sorted.begin();
+            for (std::vector<ObjectGuid>::iterator itr = m_guids.begin(); itr != m_guids.end(); ++itr)
+            {
+                while (other != sorted.end() && *other < *itr)
+                    ++other;
+                if (other == sorted.end() || *itr != *other)
+                    *out++ = *itr;
+            }
+            m_guids.erase(out, m_guids.end());
+        }
+
+    private:
+        std::vector<ObjectGuid> m_guids;
+};
+
 //minimum buffer size for packed guid is 9 bytes
 #define PACKED_GUID_MIN_BUFFER_SIZE 9
 
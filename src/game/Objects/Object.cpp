@@ -367,22 +367,83 @@ void WorldObject::DirectSendPublicValueUpdate(uint32 index)
     SendObjectMessageToSet(&packet, true);
 }
 
-void Object::BuildValuesUpdateBlockForPlayer(UpdateData *data, Player *target) const
+void Object::BuildValuesUpdateBlockForPlayer(UpdateData *data, Player *target, ValuesUpdateCache* cache) const
 {
+    UpdateMask updateMask;
+    updateMask.SetCount(m_valuesCount);
+
+    _SetUpdateBits(&updateMask, target);
+
+    ValuesUpdateVariant variant = cache ? GetValuesUpdateVariant(&updateMask, target) : VALUES_UPDATE_PER_TARGET;
+    if (variant != VALUES_UPDATE_PER_TARGET)
+    {
+        ByteBuffer& block = cache->blocks[variant];
+        if (block.empty())
+        {
+            block << uint8(UPDATETYPE_VALUES);
+            block << GetPackGUID();
+            BuildValuesUpdate(UPDATETYPE_VALUES, &block, &updateMask, target);
+            ++cache->built;
+        }
+        else
+            ++cache->shared;
+
+        data->AddUpdateBlock(block);
+        return;
+    }
+
     ByteBuffer buf(500);
 
     buf << uint8(UPDATETYPE_VALUES);
     buf << GetPackGUID();
 
-    UpdateMask updateMask;
-    updateMask.SetCount(m_valuesCount);
-
-    _SetUpdateBits(&updateMask, target);
     BuildValuesUpdate(UPDATETYPE_VALUES, &buf, &updateMask, target);
 
     data->AddUpdateBlock(buf);
 }
 
+// Must stay in sync with the target dependent cases of BuildValuesUpdate
+ValuesUpdateVariant Object::GetValuesUpdateVariant(UpdateMask *updateMask, Player *target) const
+{
+    // Own fields, or viewer seeing special flags
+    if (target == this || target->isGameMaster() || target->HasOption(PLAYER_VIDEO_MODE))
+        return VALUES_UPDATE_PER_TARGET;
+
+    // Quest activation is computed and remembered for each viewer
+    if (isType(TYPEMASK_GAMEOBJECT))
+        return VALUES_UPDATE_PER_TARGET;
+
+    if (isType(TYPEMASK_UNIT))
+    {
+        if (updateMask->GetBit(UNIT_DYNAMIC_FLAGS) && (GetTypeId() == TYPEID_UNIT || HasFlag(UNIT_DYNAMIC_FLAGS, UNIT_DYNFLAG_TRACK_UNIT)))
+            return VALUES_UPDATE_PER_TARGET;
+        if (updateMask->GetBit(UNIT_NPC_FLAGS) && GetTypeId() == TYPEID_UNIT &&
+            HasFlag(UNIT_NPC_FLAGS, UNIT_NPC_FLAG_TRAINER | UNIT_NPC_FLAG_STABLEMASTER | UNIT_NPC_FLAG_FLIGHTMASTER))
+            return VALUES_UPDATE_PER_TARGET;
+
+        Player* owner = ((Unit*)this)->GetCharmerOrOwnerPlayerOrPlayerItself();
+        if (!owner)
+            return VALUES_UPDATE_OTHER;
+        if (owner == target)
+            return VALUES_UPDATE_PER_TARGET;
+
+        bool raidDependent = (isType(TYPEMASK_PLAYER) && updateMask->GetBit(PLAYER_FLAGS) && HasFlag(PLAYER_FLAGS, PLAYER_FLAGS_FFA_PVP)) ||
+            (!sWorld.getConfig(CONFIG_BOOL_OBJECT_HEALTH_VALUE_SHOW) && (updateMask->GetBit(UNIT_FIELD_HEALTH) || updateMask->GetBit(UNIT_FIELD_MAXHEALTH)));
+        bool sameRaid = owner->IsInSameRaidWith(target);
+
+        // Raid members of the other faction may see the owner with their own faction
+        if (sameRaid && updateMask->GetBit(UNIT_FIELD_FACTIONTEMPLATE))
+            return VALUES_UPDATE_PER_TARGET;
+
+        return (raidDependent && sameRaid) ? VALUES_UPDATE_SAME_RAID : VALUES_UPDATE_OTHER;
+    }
+
+    if (GetTypeId() == TYPEID_CORPSE && updateMask->GetBit(CORPSE_FIELD_DYNAMIC_FLAGS))
+        return VALUES_UPDATE_PER_TARGET;
+
+    return VALUES_UPDATE_OTHER;
+}
+
 void Object::BuildOutOfRangeUpdateBlock(UpdateData * data) const
 {
     data->AddOutOfRangeGUID(GetObjectGuid());
@@ -1106,7 +1167,7 @@ bool Object::PrintIndexError(uint32 index, bool set) const
     return false;
 }
 
-void Object::BuildUpdateDataForPlayer(Player* pl, UpdateDataMapType& update_players)
+void Object::BuildUpdateDataForPlayer(Player* pl, UpdateDataMapType& update_players, ValuesUpdateCache* cache)
 {
     UpdateDataMapType::iterator iter = update_players.find(pl);
 
@@ -1117,7 +1178,7 @@ void Object::BuildUpdateDataForPlayer(Player* pl, UpdateDataMapType& update_play
         iter = p.first;
     }
 
-    BuildValuesUpdateBlockForPlayer(&iter->second, iter->first);
+    BuildValuesUpdateBlockForPlayer(&iter->second, iter->first, cache);
 }
 
 void Object::AddToClientUpdateList()
@@ -2364,6 +2425,7 @@ struct WorldObjectChangeAccumulator
 {
     UpdateDataMapType &i_updateDatas;
     WorldObject &i_object;
+    ValuesUpdateCache i_cache;
     WorldObjectChangeAccumulator(WorldObject &obj, UpdateDataMapType &d) : i_updateDatas(d), i_object(obj)
     {
         // send self fields changes in another way, otherwise
@@ -2378,7 +2440,7 @@ struct WorldObjectChangeAccumulator
         {
             Player* owner = iter->getSource()->GetOwner();
             if (owner != &i_object && owner->IsInVisibleList_Unsafe(&i_object))
-                i_object.BuildUpdateDataForPlayer(owner, i_updateDatas);
+                i_object.BuildUpdateDataForPlayer(owner, i_updateDatas, &i_cache);
         }
     }
 
@@ -2390,6 +2452,7 @@ void WorldObject::BuildUpdateData(UpdateDataMapType & update_players)
     WorldObjectChangeAccumulator notifier(*this, update_players);
     // Update with modifier for long range players
     Cell::VisitWorldObjects(this, notifier, GetMap()->GetVisibilityDistance() + GetVisibilityModifier());
+    GetMap()->AddValuesUpdateStats(notifier.i_cache.built, notifier.i_cache.shared);
 
     ClearUpdateMask(false);
 }
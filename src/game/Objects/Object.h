@@ -89,6 +89,25 @@ class Transport;
 
 typedef std::unordered_map<Player*, UpdateData> UpdateDataMapType;
 
+// Classes of viewers receiving the exact same values update block of an object
+enum ValuesUpdateVariant
+{
+    VALUES_UPDATE_PER_TARGET    = -1,                       // depends on the viewer, built for each one
+    VALUES_UPDATE_OTHER         = 0,
+    VALUES_UPDATE_SAME_RAID     = 1,                        // viewer in the raid of the owner
+    MAX_VALUES_UPDATE_VARIANTS  = 2
+};
+
+// Values update blocks of one object, built once per tick and copied to each viewer
+struct ValuesUpdateCache
+{
+    ValuesUpdateCache() : blocks{ ByteBuffer(0), ByteBuffer(0) }, built(0), shared(0) {}
+
+    ByteBuffer blocks[MAX_VALUES_UPDATE_VARIANTS];          // empty until built
+    uint32 built;
+    uint32 shared;
+};
+
 struct Position
 {
     Position() : x(0.0f), y(0.0f), z(0.0f), o(0.0f) {}
@@ -355,13 +374,13 @@ class MANGOS_DLL_SPEC Object
         void AddDelayedAction(ObjectDelayedAction e) { _delayedActions |= e; }
         void ExecuteDelayedActions();
 
-        void BuildValuesUpdateBlockForPlayer( UpdateData *data, Player *target ) const;
+        void BuildValuesUpdateBlockForPlayer( UpdateData *data, Player *target, ValuesUpdateCache* cache = nullptr ) const;
         void BuildOutOfRangeUpdateBlock( UpdateData *data ) const;
         void BuildMovementUpdateBlock( UpdateData * data, uint8 flags = 0 ) const;
 
         void BuildMovementUpdate(ByteBuffer * data, uint8 updateFlags) const;
         void BuildValuesUpdate(uint8 updatetype, ByteBuffer *data, UpdateMask *updateMask, Player *target ) const;
-        void BuildUpdateDataForPlayer(Player* pl, UpdateDataMapType& update_players);
+        void BuildUpdateDataForPlayer(Player* pl, UpdateDataMapType& update_players, ValuesUpdateCache* cache = nullptr);
 
         void SendOutOfRangeUpdateToPlayer(Player* player);
 
@@ -594,6 +613,7 @@ class MANGOS_DLL_SPEC Object
         void _Create (uint32 guidlow, uint32 entry, HighGuid guidhigh);
 
         virtual void _SetUpdateBits(UpdateMask *updateMask, Player *target) const;
+        ValuesUpdateVariant GetValuesUpdateVariant(UpdateMask *updateMask, Player *target) const;
         void _LoadIntoDataField(std::string const& data, uint32 startOffset, uint32 count);
 
         virtual void _SetCreateBits(UpdateMask *updateMask, Player *target) const;
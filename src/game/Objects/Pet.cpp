@@ -304,7 +304,7 @@ bool Pet::LoadPetFromDB(Player* owner, uint32 petentry, uint32 petnumber, bool c
     // PET_SAVE_NOT_IN_SLOT(100) = not stable slot (summoning))
     if (m_pTmpCache->slot != 0)
     {
-        CharacterDatabase.BeginTransaction();
+        CharacterDatabase.BeginTransaction(ownerid);
 
         static SqlStatementID id_1;
         static SqlStatementID id_2;
@@ -317,8 +317,7 @@ bool Pet::LoadPetFromDB(Player* owner, uint32 petentry, uint32 petnumber, bool c
 
         CharacterDatabase.CommitTransaction();
 
-        m_pTmpCache->slot = PET_SAVE_AS_CURRENT;
-        sCharacterDatabaseCache.CharacterPetSetOthersNotInSlot(m_pTmpCache);
+        sCharacterDatabaseCache.SetCharacterCurrentPet(ownerid, m_charmInfo->GetPetNumber());
     }
 
     // load action bar, if data broken will fill later by default spells.
@@ -471,12 +470,9 @@ void Pet::SavePetToDB(PetSaveMode mode)
         if (mode == PET_SAVE_AS_CURRENT && !isAlive())
             mode = PET_SAVE_NOT_IN_SLOT;
 
-        // On recup l'info dans le cache
+        // Filled with the saved data, then replaces the cached pet
         uint32 ownerLow = GetOwnerGuid().GetCounter();
-        m_pTmpCache = sCharacterDatabaseCache.GetCharacterPetCacheByOwnerAndId(ownerLow, m_charmInfo->GetPetNumber());
-        bool bInCache = (m_pTmpCache != nullptr);
-        if (!bInCache)
-            m_pTmpCache = new CharacterPetCache;
+        m_pTmpCache = std::make_shared<CharacterPetCache>();
 
         uint32 curhealth = GetHealth();
         uint32 curmana = GetPower(POWER_MANA);
@@ -486,8 +482,8 @@ void Pet::SavePetToDB(PetSaveMode mode)
               mode == PET_SAVE_FIRST_STABLE_SLOT || mode == PET_SAVE_LAST_STABLE_SLOT )
             RemoveAllAuras();
 
-        //save pet's data as one single transaction
-        CharacterDatabase.BeginTransaction();
+        //save pet's data as one single transaction, ordered with the owner's next login queries
+        CharacterDatabase.BeginTransaction(ownerLow);
         _SaveSpells();
         _SaveSpellCooldowns();
         _SaveAuras();
@@ -596,12 +592,7 @@ void Pet::SavePetToDB(PetSaveMode mode)
         savePet.Execute();
 
         CharacterDatabase.CommitTransaction();
-        if (!bInCache) // Nouveau dans le cache.
-        {
-            sCharacterDatabaseCache.InsertCharacterPet(m_pTmpCache);
-            m_pTmpCache = nullptr;
-        }
-        // On ne doit pas l'utiliser comme ca.
+        sCharacterDatabaseCache.InsertCharacterPet(m_pTmpCache);
         m_pTmpCache = nullptr;
     }
     else
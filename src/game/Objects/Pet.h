@@ -270,7 +270,7 @@ class MANGOS_DLL_SPEC Pet : public Creature
         int32   m_bonusdamage;
         uint64  m_auraUpdateMask;
         bool    m_loading;
-        CharacterPetCache* m_pTmpCache;
+        std::shared_ptr<CharacterPetCache> m_pTmpCache;     // own copy of the cached pet while loading or saving
         bool    m_unSummoned;                               // If this pet has already been unsummoned
 
     private:
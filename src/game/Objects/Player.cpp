@@ -85,6 +85,8 @@
 #include "world/world_event_wareffort.h"
 
 #define ZONE_UPDATE_INTERVAL (1*IN_MILLISECONDS)
+// Autosaves postponed in a row while the character database is overloaded, before saving anyway
+#define MAX_SAVE_POSTPONEMENTS 12
 
 #define PLAYER_SKILL_INDEX(x)       (PLAYER_SKILL_INFO_1_1 + ((x)*3))
 #define PLAYER_SKILL_VALUE_INDEX(x) (PLAYER_SKILL_INDEX(x)+1)
@@ -468,6 +470,7 @@ Player::Player(WorldSession *session) : Unit(),
     // randomize first save time in range [CONFIG_UINT32_INTERVAL_SAVE] around [CONFIG_UINT32_INTERVAL_SAVE]
     // this must help in case next save after mass player load after server startup
     m_nextSave = urand(m_nextSave / 2, m_nextSave * 3 / 2);
+    m_savePostponements = 0;
 
     clearResurrectRequestData();
 
@@ -580,6 +583,10 @@ Player::Player(WorldSession *session) : Unit(),
     i_AI = NULL;
     _playerOptions = 0x0;
     m_DbSaveDisabled = false;
+    m_savedRowsKnown = false;
+    m_savedRowsFailedTransactions = 0;
+    m_lastSaveStatements = 0;
+    m_lastSaveBytes = 0;
 
     m_lastFromClientCastedSpellID = 0;
 
@@ -1325,9 +1332,18 @@ void Player::Update(uint32 update_diff, uint32 p_time)
     {
         if (update_diff >= m_nextSave)
         {
-            // m_nextSave reseted in SaveToDB call
-            SaveToDB();
-            DETAIL_LOG("Player '%s' (GUID: %u) saved", GetName(), GetGUIDLow());
+            // the character database is behind, try again a bit later
+            if (sWorld.IsCharacterDatabaseOverloaded() && m_savePostponements < MAX_SAVE_POSTPONEMENTS)
+            {
+                m_nextSave = urand(5 * IN_MILLISECONDS, 10 * IN_MILLISECONDS);
+                ++m_savePostponements;
+            }
+            else
+            {
+                // m_nextSave reseted in SaveToDB call
+                SaveToDB();
+                DETAIL_LOG("Player '%s' (GUID: %u) saved", GetName(), GetGUIDLow());
+            }
         }
         else
             m_nextSave -= update_diff;
@@ -1866,7 +1882,7 @@ bool Player::SwitchInstance(uint32 newInstanceId)
     ASSERT(newmap);
     SetMap(newmap);
 
-    for (ObjectGuidSet::const_iterator it = m_visibleGUIDs.begin(); it != m_visibleGUIDs.end(); ++it)
+    for (ObjectGuidSortedSet::const_iterator it = m_visibleGUIDs.begin(); it != m_visibleGUIDs.end(); ++it)
     {
         WorldPacket data(SMSG_DESTROY_OBJECT, 8);
         data << *it;
@@ -3840,15 +3856,23 @@ void Player::_LoadSpellCooldowns(QueryResult *result)
 
 void Player::_SaveSpellCooldowns()
 {
+    static SqlStatementID deleteSpellCooldowns ;
     static SqlStatementID deleteSpellCooldown ;
-    static SqlStatementID insertSpellCooldown ;
+    static SqlStatementID replaceSpellCooldown ;
 
-    SqlStatement stmt = CharacterDatabase.CreateStatement(deleteSpellCooldown, "DELETE FROM character_spell_cooldown WHERE guid = ?");
-    stmt.PExecute(GetGUIDLow());
+    if (!m_savedRowsKnown)
+    {
+        SqlStatement stmt = CharacterDatabase.CreateStatement(deleteSpellCooldowns, "DELETE FROM character_spell_cooldown WHERE guid = ?");
+        stmt.PExecute(GetGUIDLow());
+        m_savedCooldowns.clear();
+    }
 
     time_t curTime = time(NULL);
     time_t infTime = curTime + infinityCooldownDelayCheck;
 
+    SqlStatement stmtReplace = CharacterDatabase.CreateStatement(replaceSpellCooldown, "REPLACE INTO character_spell_cooldown (guid, spell, item, time, cattime) VALUES( ?, ?, ?, ?, ?)");
+    SavedCooldownsMap saved;
+
     // remove outdated and save active
     for (SpellCooldowns::iterator itr = m_spellCooldowns.begin(); itr != m_spellCooldowns.end();)
     {
@@ -3856,13 +3880,32 @@ void Player::_SaveSpellCooldowns()
             m_spellCooldowns.erase(itr++);
         else if (itr->second.end <= infTime)                // not save locked cooldowns, it will be reset or set at reload
         {
-            stmt = CharacterDatabase.CreateStatement(insertSpellCooldown, "INSERT INTO character_spell_cooldown (guid, spell, item, time, cattime) VALUES( ?, ?, ?, ?, ?)");
-            stmt.PExecute(GetGUIDLow(), itr->first, itr->second.itemid, uint64(itr->second.end), uint64(itr->second.categoryEnd));
+            SavedCooldownsMap::iterator prev = m_savedCooldowns.find(itr->first);
+            if (prev == m_savedCooldowns.end() || prev->second.end != itr->second.end ||
+                prev->second.categoryEnd != itr->second.categoryEnd || prev->second.itemid != itr->second.itemid)
+            {
+                stmtReplace.addUInt32(GetGUIDLow());
+                stmtReplace.addUInt32(itr->first);
+                stmtReplace.addUInt16(itr->second.itemid);
+                stmtReplace.addUInt64(uint64(itr->second.end));
+                stmtReplace.addUInt64(uint64(itr->second.categoryEnd));
+                stmtReplace.ExecuteBatched();
+            }
+            if (prev != m_savedCooldowns.end())
+                m_savedCooldowns.erase(prev);
+            saved[itr->first] = itr->second;
             ++itr;
         }
         else
             ++itr;
     }
+
+    // what is left was saved previously and is gone now
+    SqlStatement stmtDelete = CharacterDatabase.CreateStatement(deleteSpellCooldown, "DELETE FROM character_spell_cooldown WHERE guid = ? AND spell = ?");
+    for (SavedCooldownsMap::const_iterator itr = m_savedCooldowns.begin(); itr != m_savedCooldowns.end(); ++itr)
+        stmtDelete.PExecute(GetGUIDLow(), itr->first);
+
+    m_savedCooldowns.swap(saved);
 }
 
 void Player::updateResetTalentsMultiplier()
@@ -16009,6 +16052,7 @@ void Player::SaveToDB(bool online, bool force)
     // we should assure this: ASSERT((m_nextSave != sWorld.getConfig(CONFIG_UINT32_INTERVAL_SAVE)));
     // delay auto save at any saves (manual, in code, or autosave)
     m_nextSave = sWorld.getConfig(CONFIG_UINT32_INTERVAL_SAVE);
+    m_savePostponements = 0;
 
     // Pas de sauvegarde des bots
     if (GetSession()->GetBot())
@@ -16032,7 +16076,7 @@ void Player::SaveToDB(bool online, bool force)
 
     static SqlStatementID insChar;
 
-    SqlStatement uberInsert = CharacterDatabase.CreateStatement(insChar, "REPLACE INTO characters (guid,account,name,race,class,gender,level,xp,money,playerBytes,playerBytes2,playerFlags,"
+    SqlStatement uberInsert = CharacterDatabase.CreateStatement(insChar, "INSERT INTO characters (guid,account,name,race,class,gender,level,xp,money,playerBytes,playerBytes2,playerFlags,"
                               "map, position_x, position_y, position_z, orientation, "
                               "taximask, online, cinematic, "
                               "totaltime, leveltime, rest_bonus, logout_time, is_logout_resting, resettalents_multiplier, resettalents_time, "
@@ -16051,7 +16095,18 @@ void Player::SaveToDB(bool online, bool force)
                               "?, ?, ?, ?, ?, ?, ?, "
                               "?, ?, ?, ?, ?, ?, "
                               "?, ?, ?, ?, ?, ?, "
-                              "?, ?, ?) ");
+                              "?, ?, ?) "
+                              "ON DUPLICATE KEY UPDATE "
+                              "account=VALUES(account), name=VALUES(name), race=VALUES(race), class=VALUES(class), gender=VALUES(gender), level=VALUES(level), xp=VALUES(xp), money=VALUES(money), playerBytes=VALUES(playerBytes), playerBytes2=VALUES(playerBytes2), playerFlags=VALUES(playerFlags),"
+                              "map=VALUES(map), position_x=VALUES(position_x), position_y=VALUES(position_y), position_z=VALUES(position_z), orientation=VALUES(orientation),"
+                              "taximask=VALUES(taximask), online=VALUES(online), cinematic=VALUES(cinematic),"
+                              "totaltime=VALUES(totaltime), leveltime=VALUES(leveltime), rest_bonus=VALUES(rest_bonus), logout_time=VALUES(logout_time), is_logout_resting=VALUES(is_logout_resting), resettalents_multiplier=VALUES(resettalents_multiplier), resettalents_time=VALUES(resettalents_time),"
+                              "trans_x=VALUES(trans_x), trans_y=VALUES(trans_y), trans_z=VALUES(trans_z), trans_o=VALUES(trans_o), transguid=VALUES(transguid), extra_flags=VALUES(extra_flags), stable_slots=VALUES(stable_slots), at_login=VALUES(at_login), zone=VALUES(zone),"
+                              "death_expire_time=VALUES(death_expire_time), taxi_path=VALUES(taxi_path),"
+                              "honorRankPoints=VALUES(honorRankPoints), honorHighestRank=VALUES(honorHighestRank), honorStanding=VALUES(honorStanding), honorLastWeekHK=VALUES(honorLastWeekHK), honorLastWeekCP=VALUES(honorLastWeekCP), honorStoredHK=VALUES(honorStoredHK), honorStoredDK=VALUES(honorStoredDK),"
+                              "watchedFaction=VALUES(watchedFaction), drunk=VALUES(drunk), health=VALUES(health), power1=VALUES(power1), power2=VALUES(power2), power3=VALUES(power3),"
+                              "power4=VALUES(power4), power5=VALUES(power5), exploredZones=VALUES(exploredZones), equipmentCache=VALUES(equipmentCache), ammoId=VALUES(ammoId), actionBars=VALUES(actionBars),"
+                              "area=VALUES(area), world_phase_mask=VALUES(world_phase_mask), customFlags=VALUES(customFlags)");
 
     uberInsert.addUInt32(GetGUIDLow());
     uberInsert.addUInt32(GetSession()->GetAccountId());
@@ -16175,6 +16230,15 @@ void Player::SaveToDB(bool online, bool force)
     uberInsert.addUInt32(customFlags);
     uberInsert.Execute();
 
+    // The rows of a failed save may be missing, possibly the previous one of this character.
+    // Commits are asynchronous, a failure is only seen by the next saves.
+    uint32 failedTransactions = CharacterDatabase.GetFailedTransactionsCount();
+    if (failedTransactions != m_savedRowsFailedTransactions)
+    {
+        m_savedRowsKnown = false;
+        m_savedRowsFailedTransactions = failedTransactions;
+    }
+
     _SaveBGData();
     _SaveInventory();
     _SaveQuestStatus();
@@ -16189,6 +16253,11 @@ void Player::SaveToDB(bool online, bool force)
     sObjectMgr.SetPlayerWorldMask(GetGUIDLow(), GetWorldMask());
     GetSession()->SaveTutorialsData();                      // changed only while character in game
 
+    m_savedRowsKnown = true;
+    m_lastSaveStatements = CharacterDatabase.GetTransactionStatementsCount();
+    m_lastSaveBytes = CharacterDatabase.GetTransactionBytes();
+    sWorld.GetPlayerSaveStats()->Record(m_lastSaveStatements, m_lastSaveBytes);
+
     CharacterDatabase.CommitTransaction();
 
     // check if stats should only be saved on logout
@@ -16237,20 +16306,23 @@ void Player::SaveGoldToDB()
 void Player::_SaveAuras()
 {
     static SqlStatementID deleteAuras ;
-    static SqlStatementID insertAuras ;
+    static SqlStatementID deleteAura ;
+    static SqlStatementID replaceAuras ;
 
-    SqlStatement stmt = CharacterDatabase.CreateStatement(deleteAuras, "DELETE FROM character_aura WHERE guid = ?");
-    stmt.PExecute(GetGUIDLow());
+    if (!m_savedRowsKnown)
+    {
+        SqlStatement stmt = CharacterDatabase.CreateStatement(deleteAuras, "DELETE FROM character_aura WHERE guid = ?");
+        stmt.PExecute(GetGUIDLow());
+        m_savedAuras.clear();
+    }
 
     SpellAuraHolderMap const& auraHolders = GetSpellAuraHolderMap();
 
-    if (auraHolders.empty())
-        return;
-
-    stmt = CharacterDatabase.CreateStatement(insertAuras, "INSERT INTO character_aura (guid, caster_guid, item_guid, spell, stackcount, remaincharges, "
+    SqlStatement stmt = CharacterDatabase.CreateStatement(replaceAuras, "REPLACE INTO character_aura (guid, caster_guid, item_guid, spell, stackcount, remaincharges, "
             "basepoints0, basepoints1, basepoints2, periodictime0, periodictime1, periodictime2, maxduration, remaintime, effIndexMask) "
             "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
 
+    SavedAurasMap saved;
     AuraSaveStruct s;
     for (SpellAuraHolderMap::const_iterator itr = auraHolders.begin(); itr != auraHolders.end(); ++itr)
     {
@@ -16259,6 +16331,20 @@ void Player::_SaveAuras()
         if (!SaveAura(holder, s))
             continue;
 
+        SavedAuraKey key(s.caster_guid.GetRawValue(), std::make_pair(s.item_lowguid, s.spellid));
+        if (saved.find(key) != saved.end())
+            continue;                                       // same primary key, the row would be overwritten anyway
+        saved[key] = s;
+
+        SavedAurasMap::iterator prev = m_savedAuras.find(key);
+        if (prev != m_savedAuras.end())
+        {
+            bool unchanged = prev->second.IsSameRow(s);
+            m_savedAuras.erase(prev);
+            if (unchanged)
+                continue;
+        }
+
         stmt.addUInt32(GetGUIDLow());
         stmt.addUInt64(s.caster_guid.GetRawValue());
         stmt.addUInt32(s.item_lowguid);
@@ -16275,8 +16361,15 @@ void Player::_SaveAuras()
         stmt.addInt32(s.maxduration);
         stmt.addInt32(s.remaintime);
         stmt.addUInt32(s.effIndexMask);
-        stmt.Execute();
+        stmt.ExecuteBatched();
     }
+
+    // what is left was saved previously and is gone now
+    stmt = CharacterDatabase.CreateStatement(deleteAura, "DELETE FROM character_aura WHERE guid = ? AND caster_guid = ? AND item_guid = ? AND spell = ?");
+    for (SavedAurasMap::const_iterator itr = m_savedAuras.begin(); itr != m_savedAuras.end(); ++itr)
+        stmt.PExecute(GetGUIDLow(), itr->first.first, itr->first.second.first, itr->first.second.second);
+
+    m_savedAuras.swap(saved);
 }
 
 bool Player::SaveAura(SpellAuraHolder* holder, AuraSaveStruct& saveStruct)
@@ -16562,19 +16655,52 @@ void Player::_SaveSpells()
 {
     static SqlStatementID delSpells ;
     static SqlStatementID insSpells ;
+    static SqlStatementID replaceSpells ;
 
     SqlStatement stmtDel = CharacterDatabase.CreateStatement(delSpells, "DELETE FROM character_spell WHERE guid = ? and spell = ?");
     SqlStatement stmtIns = CharacterDatabase.CreateStatement(insSpells, "INSERT INTO character_spell (guid,spell,active,disabled) VALUES (?, ?, ?, ?)");
+    SqlStatement stmtReplace = CharacterDatabase.CreateStatement(replaceSpells, "REPLACE INTO character_spell (guid,spell,active,disabled) VALUES (?, ?, ?, ?)");
 
-    for (PlayerSpellMap::iterator itr = m_spells.begin(), next = m_spells.begin(); itr != m_spells.end();)
+    // each spell has one row at most, deletions and writes are grouped so that writes are batched
+    std::vector<uint32> deleted;
+    std::vector<PlayerSpellMap::const_iterator> replaced;
+    std::vector<PlayerSpellMap::const_iterator> inserted;
+    for (PlayerSpellMap::const_iterator itr = m_spells.begin(); itr != m_spells.end(); ++itr)
     {
-        if (itr->second.state == PLAYERSPELL_REMOVED || itr->second.state == PLAYERSPELL_CHANGED)
-            stmtDel.PExecute(GetGUIDLow(), itr->first);
-
         // add only changed/new not dependent spells
-        if (!itr->second.dependent && (itr->second.state == PLAYERSPELL_NEW || itr->second.state == PLAYERSPELL_CHANGED))
-            stmtIns.PExecute(GetGUIDLow(), itr->first, uint8(itr->second.active ? 1 : 0), uint8(itr->second.disabled ? 1 : 0));
+        bool store = !itr->second.dependent && (itr->second.state == PLAYERSPELL_NEW || itr->second.state == PLAYERSPELL_CHANGED);
 
+        if (itr->second.state == PLAYERSPELL_CHANGED && store)
+            replaced.push_back(itr);
+        else if (itr->second.state == PLAYERSPELL_REMOVED || itr->second.state == PLAYERSPELL_CHANGED)
+            deleted.push_back(itr->first);
+        else if (store)
+            inserted.push_back(itr);
+    }
+
+    for (size_t i = 0; i < deleted.size(); ++i)
+        stmtDel.PExecute(GetGUIDLow(), deleted[i]);
+
+    for (size_t i = 0; i < replaced.size(); ++i)
+    {
+        stmtReplace.addUInt32(GetGUIDLow());
+        stmtReplace.addUInt32(replaced[i]->first);
+        stmtReplace.addUInt8(uint8(replaced[i]->second.active ? 1 : 0));
+        stmtReplace.addUInt8(uint8(replaced[i]->second.disabled ? 1 : 0));
+        stmtReplace.ExecuteBatched();
+    }
+
+    for (size_t i = 0; i < inserted.size(); ++i)
+    {
+        stmtIns.addUInt32(GetGUIDLow());
+        stmtIns.addUInt32(inserted[i]->first);
+        stmtIns.addUInt8(uint8(inserted[i]->second.active ? 1 : 0));
+        stmtIns.addUInt8(uint8(inserted[i]->second.disabled ? 1 : 0));
+        stmtIns.ExecuteBatched();
+    }
+
+    for (PlayerSpellMap::iterator itr = m_spells.begin(); itr != m_spells.end();)
+    {
         if (itr->second.state == PLAYERSPELL_REMOVED)
             m_spells.erase(itr++);
         else
@@ -18192,13 +18318,13 @@ void Player::UpdateVisibilityOf(WorldObject const* viewPoint, WorldObject* targe
 }
 
 template<class T>
-inline void UpdateVisibilityOf_helper(ObjectGuidSet& s64, T* target)
+inline void UpdateVisibilityOf_helper(ObjectGuidSortedSet& s64, T* target)
 {
     s64.insert(target->GetObjectGuid());
 }
 
 template<>
-inline void UpdateVisibilityOf_helper(ObjectGuidSet& s64, GameObject* target)
+inline void UpdateVisibilityOf_helper(ObjectGuidSortedSet& s64, GameObject* target)
 {
     // Naxxramas necropolis. Always visible.
     if (target->GetEntry() == 181223)
@@ -18233,7 +18359,7 @@ void RemoveBroadcastListener(Player* target, Player* me)
 }
 
 template<class T>
-void Player::UpdateVisibilityOf(WorldObject const* viewPoint, T* target, UpdateData& data, std::set<WorldObject*>& visibleNow)
+void Player::UpdateVisibilityOf(WorldObject const* viewPoint, T* target, UpdateData& data, std::vector<WorldObject*>& visibleNow)
 {
     bool inVisibleList = IsInVisibleList(target);
     if (inVisibleList)
@@ -18255,7 +18381,7 @@ void Player::UpdateVisibilityOf(WorldObject const* viewPoint, T* target, UpdateD
     {
         if (target->FindMap() && target->isWithinVisibilityDistanceOf(this, viewPoint, inVisibleList) && target->isVisibleForInState(this, viewPoint, false))
         {
-            visibleNow.insert(target);
+            visibleNow.push_back(target);
             target->BuildCreateUpdateBlockForPlayer(&data, this);
             m_visibleGUIDs_lock.acquire_write();
             UpdateVisibilityOf_helper(m_visibleGUIDs, target);
@@ -18267,12 +18393,12 @@ void Player::UpdateVisibilityOf(WorldObject const* viewPoint, T* target, UpdateD
     }
 }
 
-template void Player::UpdateVisibilityOf(WorldObject const* viewPoint, Player*        target, UpdateData& data, std::set<WorldObject*>& visibleNow);
-template void Player::UpdateVisibilityOf(WorldObject const* viewPoint, Creature*      target, UpdateData& data, std::set<WorldObject*>& visibleNow);
-template void Player::UpdateVisibilityOf(WorldObject const* viewPoint, Corpse*        target, UpdateData& data, std::set<WorldObject*>& visibleNow);
-template void Player::UpdateVisibilityOf(WorldObject const* viewPoint, GameObject*    target, UpdateData& data, std::set<WorldObject*>& visibleNow);
-template void Player::UpdateVisibilityOf(WorldObject const* viewPoint, DynamicObject* target, UpdateData& data, std::set<WorldObject*>& visibleNow);
-template void Player::UpdateVisibilityOf(WorldObject const* viewPoint, WorldObject*   target, UpdateData& data, std::set<WorldObject*>& visibleNow);
+template void Player::UpdateVisibilityOf(WorldObject const* viewPoint, Player*        target, UpdateData& data, std::vector<WorldObject*>& visibleNow);
+template void Player::UpdateVisibilityOf(WorldObject const* viewPoint, Creature*      target, UpdateData& data, std::vector<WorldObject*>& visibleNow);
+template void Player::UpdateVisibilityOf(WorldObject const* viewPoint, Corpse*        target, UpdateData& data, std::vector<WorldObject*>& visibleNow);
+template void Player::UpdateVisibilityOf(WorldObject const* viewPoint, GameObject*    target, UpdateData& data, std::vector<WorldObject*>& visibleNow);
+template void Player::UpdateVisibilityOf(WorldObject const* viewPoint, DynamicObject* target, UpdateData& data, std::vector<WorldObject*>& visibleNow);
+template void Player::UpdateVisibilityOf(WorldObject const* viewPoint, WorldObject*   target, UpdateData& data, std::vector<WorldObject*>& visibleNow);
 
 void Player::SetLongSight(const Aura* aura)
 {
@@ -18928,7 +19054,7 @@ void Player::UpdateForQuestWorldObjects()
     uint32 count = 0;
     UpdateData upd;
     m_visibleGUIDs_lock.acquire_read();
-    for (ObjectGuidSet::const_iterator itr = m_visibleGUIDs.begin(); itr != m_visibleGUIDs.end(); ++itr)
+    for (ObjectGuidSortedSet::const_iterator itr = m_visibleGUIDs.begin(); itr != m_visibleGUIDs.end(); ++itr)
     {
         if (itr->IsGameObject())
         {
@@ -20874,7 +21000,7 @@ void Player::SendDestroyGroupMembers(bool includingSelf)
 void Player::RefreshBitsForVisibleUnits(UpdateMask* mask, uint32 objectTypeMask)
 {
     UpdateData data;
-    for (ObjectGuidSet::const_iterator itr = m_visibleGUIDs.begin(); itr != m_visibleGUIDs.end(); ++itr)
+    for (ObjectGuidSortedSet::const_iterator itr = m_visibleGUIDs.begin(); itr != m_visibleGUIDs.end(); ++itr)
         if (Object* obj = GetObjectByTypeMask(*itr, TypeMask(objectTypeMask)))
         {
             ByteBuffer buff(50);
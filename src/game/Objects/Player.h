@@ -613,6 +613,10 @@ enum PlayerLoginQueryIndex
     PLAYER_LOGIN_QUERY_LOADMAILS,
     PLAYER_LOGIN_QUERY_LOADMAILEDITEMS,
     PLAYER_LOGIN_QUERY_BATTLEGROUND_DATA,
+    PLAYER_LOGIN_QUERY_LOADPETS,
+    PLAYER_LOGIN_QUERY_LOADPETSPELLS,
+    PLAYER_LOGIN_QUERY_LOADPETCOOLDOWNS,
+    PLAYER_LOGIN_QUERY_LOADPETAURAS,
 
     MAX_PLAYER_LOGIN_QUERY
 };
@@ -860,6 +864,20 @@ struct AuraSaveStruct
     int32 maxduration;
     int32 remaintime;
     uint32 effIndexMask;
+
+    bool IsSameRow(AuraSaveStruct const& other) const
+    {
+        if (caster_guid != other.caster_guid || item_lowguid != other.item_lowguid || spellid != other.spellid ||
+            stackcount != other.stackcount || remaincharges != other.remaincharges || maxduration != other.maxduration ||
+            remaintime != other.remaintime || effIndexMask != other.effIndexMask)
+            return false;
+
+        for (int i = 0; i < MAX_EFFECT_INDEX; ++i)
+            if (damage[i] != other.damage[i] || periodicTime[i] != other.periodicTime[i])
+                return false;
+
+        return true;
+    }
 };
 
 struct ScheduledTeleportData
@@ -2019,6 +2037,8 @@ class MANGOS_DLL_SPEC Player final: public Unit
 
         uint32 GetSaveTimer() const { return m_nextSave; }
         void   SetSaveTimer(uint32 timer) { m_nextSave = timer; }
+        uint32 GetLastSaveStatementsCount() const { return m_lastSaveStatements; }
+        uint32 GetLastSaveBytes() const { return m_lastSaveBytes; }
 
         // Recall position
         uint32 m_recallMap;
@@ -2037,7 +2057,7 @@ class MANGOS_DLL_SPEC Player final: public Unit
         // Stealth detection system
         void HandleStealthedUnitsDetection();
         // currently visible objects at player client
-        ObjectGuidSet m_visibleGUIDs;
+        ObjectGuidSortedSet m_visibleGUIDs;
         mutable ACE_Thread_Mutex m_visibleGUIDs_lock;
         std::map<ObjectGuid, bool> m_visibleGobjQuestActivated;
         mutable ACE_Thread_Mutex m_visibleGobjsQuestAct_lock;
@@ -2051,7 +2071,7 @@ class MANGOS_DLL_SPEC Player final: public Unit
         void UpdateVisibilityOf(WorldObject const* viewPoint, WorldObject* target);
 
         template<class T>
-            void UpdateVisibilityOf(WorldObject const* viewPoint,T* target, UpdateData& data, std::set<WorldObject*>& visibleNow);
+            void UpdateVisibilityOf(WorldObject const* viewPoint,T* target, UpdateData& data, std::vector<WorldObject*>& visibleNow);
 
         Camera& GetCamera() { return m_camera; }
 
@@ -2319,8 +2339,23 @@ class MANGOS_DLL_SPEC Player final: public Unit
 
         Team m_team;
         uint32 m_nextSave;
+        uint32 m_savePostponements;
+        uint32 m_lastSaveStatements;
+        uint32 m_lastSaveBytes;
         uint32 m_atLoginFlags;
 
+        // Rows written by the previous save for the tables that have no per-row state.
+        // Only the differences are saved, unless the content of the tables is unknown
+        // (first save since login, or a character transaction failed since the last
+        // save) in which case they are fully rewritten.
+        typedef std::pair<uint64, std::pair<uint32, uint32> > SavedAuraKey;  // caster guid, item guid, spell
+        typedef std::map<SavedAuraKey, AuraSaveStruct> SavedAurasMap;
+        typedef std::map<uint32, SpellCooldown> SavedCooldownsMap;
+        SavedAurasMap m_savedAuras;
+        SavedCooldownsMap m_savedCooldowns;
+        bool m_savedRowsKnown;
+        uint32 m_savedRowsFailedTransactions;               // failed transactions count at the last save
+
         Item* m_items[PLAYER_SLOTS_COUNT];
         uint32 m_currentBuybackSlot;
 
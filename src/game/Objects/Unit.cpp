@@ -10674,7 +10674,7 @@ void Unit::ProcessRelocationVisibilityUpdates()
     if (!IsInWorld())
         return;
 
-    GetViewPoint().Call_UpdateVisibilityForOwner(); // HEAVY LOAD
+    GetViewPoint().Call_UpdateVisibilityForOwnerAfterRelocation(); // HEAVY LOAD
     UpdateObjectVisibility();
 }
 
@@ -31,79 +31,113 @@
 
 #define MAX_UNCOMPRESSED_PACKET_SIZE 0x8000 // 32ko
 
-UpdateData::UpdateData()
-{
-}
+// Block count and transport flag, written when the packet is started and patched at build
+#define UPDATE_PACKET_HEADER_SIZE (sizeof(uint32) + sizeof(uint8))
 
-UpdateData::~UpdateData()
+UpdateData::UpdateData() : m_lastPacketBlocks(0)
 {
-    Clear();
 }
 
-void UpdateData::AddOutOfRangeGUID(ObjectGuidSet& guids)
+void UpdateData::AddOutOfRangeGUID(ObjectGuidSortedSet const& guids)
 {
-    m_outOfRangeGUIDs.insert(guids.begin(), guids.end());
+    m_outOfRangeGUIDs.insert(m_outOfRangeGUIDs.end(), guids.begin(), guids.end());
 }
 
 void UpdateData::AddOutOfRangeGUID(ObjectGuid const &guid)
 {
-    m_outOfRangeGUIDs.insert(guid);
+    m_outOfRangeGUIDs.push_back(guid);
 }
 
 void UpdateData::AddUpdateBlock(const ByteBuffer &block)
 {
-    if (!m_datas.size())
-        m_datas.push_back(UpdatePacket());
-    std::list<UpdatePacket>::iterator it = m_datas.end();
-    --it;
-    if (it->data.wpos() > MAX_UNCOMPRESSED_PACKET_SIZE)
+    size_t const lastStart = m_packetStarts.empty() ? 0 : m_packetStarts.back();
+    if (m_buffer.empty() || m_buffer.wpos() - lastStart - UPDATE_PACKET_HEADER_SIZE > MAX_UNCOMPRESSED_PACKET_SIZE)
     {
-        m_datas.push_back(UpdatePacket());
-        it = m_datas.end();
-        --it;
+        if (m_buffer.empty())
+            m_buffer.Initialize(0, 4096);
+        else
+            m_packetStarts.push_back(m_buffer.wpos());
+
+        m_buffer << uint32(0);
+        m_buffer << uint8(0);
+        m_lastPacketBlocks = 0;
     }
-    it->data.append(block);
-    ++it->blockCount;
+
+    m_buffer.append(block);
+    m_buffer.put<uint32>(m_packetStarts.empty() ? 0 : m_packetStarts.back(), ++m_lastPacketBlocks);
 }
 
-void PacketCompressor::Compress(void* dst, uint32 *dst_size, void* src, int src_size)
+namespace
 {
-    z_stream c_stream;
-
-    c_stream.zalloc = (alloc_func)0;
-    c_stream.zfree = (free_func)0;
-    c_stream.opaque = (voidpf)0;
-
-    // default Z_BEST_SPEED (1)
-    int z_res = deflateInit(&c_stream, sWorld.getConfig(CONFIG_UINT32_COMPRESSION));
-    if (z_res != Z_OK)
+    // deflateInit allocates about 256KB, do it once per thread
+    struct ThreadCompressStream
     {
-        sLog.outError("Can't compress update packet (zlib: deflateInit) Error code: %i (%s)", z_res, zError(z_res));
-        *dst_size = 0;
-        return;
-    }
+        ThreadCompressStream() : level(-1)
+        {
+            stream.zalloc = (alloc_func)0;
+            stream.zfree = (free_func)0;
+            stream.opaque = (voidpf)0;
+        }
+
+        ~ThreadCompressStream()
+        {
+            if (level >= 0)
+                deflateEnd(&stream);
+        }
+
+        z_stream* Get(int wantedLevel)
+        {
+            if (level == wantedLevel)
+            {
+                int z_res = deflateReset(&stream);
+                if (z_res == Z_OK)
+                    return &stream;
+                sLog.outError("Can't compress update packet (zlib: deflateReset) Error code: %i (%s)", z_res, zError(z_res));
+            }
+
+            if (level >= 0)
+                deflateEnd(&stream);
+            level = -1;
+
+            int z_res = deflateInit(&stream, wantedLevel);
+            if (z_res != Z_OK)
+            {
+                sLog.outError("Can't compress update packet (zlib: deflateInit) Error code: %i (%s)", z_res, zError(z_res));
+                return nullptr;
+            }
+            level = wantedLevel;
+            return &stream;
+        }
+
+        z_stream stream;
+        int level;
+    };
+
+    thread_local ThreadCompressStream s_compressStream;
+}
 
-    c_stream.next_out = (Bytef*)dst;
-    c_stream.avail_out = *dst_size;
-    c_stream.next_in = (Bytef*)src;
-    c_stream.avail_in = (uInt)src_size;
+void PacketCompressor::Compress(void* dst, uint32 *dst_size, void* src, int src_size)
+{
+    // default Z_BEST_SPEED (1)
+    Compress(dst, dst_size, src, src_size, sWorld.getConfig(CONFIG_UINT32_COMPRESSION));
+}
 
-    z_res = deflate(&c_stream, Z_NO_FLUSH);
-    if (z_res != Z_OK)
+void PacketCompressor::Compress(void* dst, uint32 *dst_size, void* src, int src_size, int level)
+{
+    z_stream* c_stream = s_compressStream.Get(level);
+    if (!c_stream)
     {
-        sLog.outError("Can't compress update packet (zlib: deflate) Error code: %i (%s)", z_res, zError(z_res));
         *dst_size = 0;
         return;
     }
 
-    if (c_stream.avail_in != 0)
-    {
-        sLog.outError("Can't compress update packet (zlib: deflate not greedy)");
-        *dst_size = 0;
-        return;
-    }
+    c_stream->next_out = (Bytef*)dst;
+    c_stream->avail_out = *dst_size;
+    c_stream->next_in = (Bytef*)src;
+    c_stream->avail_in = (uInt)src_size;
 
-    z_res = deflate(&c_stream, Z_FINISH);
+    // The whole packet is available, a single call is enough
+    int z_res = deflate(c_stream, Z_FINISH);
     if (z_res != Z_STREAM_END)
     {
         sLog.outError("Can't compress update packet (zlib: deflate should report Z_STREAM_END instead %i (%s)", z_res, zError(z_res));
@@ -111,31 +145,32 @@ void PacketCompressor::Compress(void* dst, uint32 *dst_size, void* src, int src_
         return;
     }
 
-    z_res = deflateEnd(&c_stream);
-    if (z_res != Z_OK)
-    {
-        sLog.outError("Can't compress update packet (zlib: deflateEnd) Error code: %i (%s)", z_res, zError(z_res));
-        *dst_size = 0;
-        return;
-    }
+    *dst_size = c_stream->total_out;
+}
 
-    *dst_size = c_stream.total_out;
+void UpdateData::GetPacketBounds(size_t index, size_t& begin, size_t& end) const
+{
+    begin = index ? m_packetStarts[index - 1] : 0;
+    end = index < m_packetStarts.size() ? m_packetStarts[index] : m_buffer.wpos();
 }
 
 bool UpdateData::BuildPacket(WorldPacket *packet, bool hasTransport)
 {
-    if (!m_datas.size())
-        return BuildPacket(packet, NULL, hasTransport);
-    return BuildPacket(packet, &(m_datas.front()), hasTransport);
+    return BuildPacket(packet, 0, hasTransport);
 }
 
-bool UpdateData::BuildPacket(WorldPacket *packet, UpdatePacket const* updPacket, bool hasTransport)
+void UpdateData::BuildPayload(ByteBuffer& buf, size_t index, bool hasTransport)
 {
-    MANGOS_ASSERT(packet->empty());                         // shouldn't happen
+    std::sort(m_outOfRangeGUIDs.begin(), m_outOfRangeGUIDs.end());
+    m_outOfRangeGUIDs.erase(std::unique(m_outOfRangeGUIDs.begin(), m_outOfRangeGUIDs.end()), m_outOfRangeGUIDs.end());
+
+    size_t begin = 0, end = 0;
+    if (!m_buffer.empty())
+        GetPacketBounds(index, begin, end);
+    uint32 blockCount = end > begin ? m_buffer.read<uint32>(begin) : 0;
 
-    ByteBuffer buf(4 + 1 + (m_outOfRangeGUIDs.empty() ? 0 : 1 + 4 + 9 * m_outOfRangeGUIDs.size()) + (updPacket ? updPacket->data.wpos() : 0));
+    buf.reserve(4 + 1 + (m_outOfRangeGUIDs.empty() ? 0 : 1 + 4 + 9 * m_outOfRangeGUIDs.size()) + (end - begin));
 
-    uint32 blockCount = updPacket ? updPacket->blockCount : 0;
     buf << (uint32)(!m_outOfRangeGUIDs.empty() ? blockCount + 1 : blockCount);
     buf << (uint8)(hasTransport ? 1 : 0);
 
@@ -144,16 +179,38 @@ bool UpdateData::BuildPacket(WorldPacket *packet, UpdatePacket const* updPacket,
         buf << (uint8) UPDATETYPE_OUT_OF_RANGE_OBJECTS;
         buf << (uint32) m_outOfRangeGUIDs.size();
 
-        for (ObjectGuidSet::const_iterator i = m_outOfRangeGUIDs.begin(); i != m_outOfRangeGUIDs.end(); ++i)
+        for (std::vector<ObjectGuid>::const_iterator i = m_outOfRangeGUIDs.begin(); i != m_outOfRangeGUIDs.end(); ++i)
             buf << i->WriteAsPacked();
     }
 
-    if (updPacket)
-        buf.append(updPacket->data);
+    if (end > begin + UPDATE_PACKET_HEADER_SIZE)
+        buf.append(m_buffer.contents() + begin + UPDATE_PACKET_HEADER_SIZE, end - begin - UPDATE_PACKET_HEADER_SIZE);
+}
 
-    size_t pSize = buf.wpos();                              // use real used data size
+bool UpdateData::BuildPacket(WorldPacket *packet, size_t index, bool hasTransport)
+{
+    MANGOS_ASSERT(packet->empty());                         // shouldn't happen
 
-    if (pSize > 100)                                       // compress large packets
+    uint8 const* payload;
+    size_t pSize;
+    ByteBuffer buf(0);
+    if (m_outOfRangeGUIDs.empty() && !m_buffer.empty())
+    {
+        // The packet is ready in our buffer, only the transport flag is missing
+        size_t begin, end;
+        GetPacketBounds(index, begin, end);
+        m_buffer.put<uint8>(begin + sizeof(uint32), hasTransport ? 1 : 0);
+        payload = m_buffer.contents() + begin;
+        pSize = end - begin;
+    }
+    else
+    {
+        BuildPayload(buf, index, hasTransport);
+        payload = buf.contents();
+        pSize = buf.wpos();                                 // use real used data size
+    }
+
+    if (pSize > sWorld.getConfig(CONFIG_UINT32_COMPRESSION_THRESHOLD)) // compress large packets
     {
         if (pSize >= 900000)
             sLog.outInfo("[CRASH-CLIENT] Too large packet: %u", pSize);
@@ -162,35 +219,38 @@ bool UpdateData::BuildPacket(WorldPacket *packet, UpdatePacket const* updPacket,
         packet->resize(destsize + sizeof(uint32));
 
         packet->put<uint32>(0, pSize);
-        PacketCompressor::Compress(const_cast<uint8*>(packet->contents()) + sizeof(uint32), &destsize, (void*)buf.contents(), pSize);
+        PacketCompressor::Compress(const_cast<uint8*>(packet->contents()) + sizeof(uint32), &destsize, (void*)payload, pSize);
         if (destsize == 0)
             return false;
 
-        packet->resize(destsize + sizeof(uint32));
-        packet->SetOpcode(SMSG_COMPRESSED_UPDATE_OBJECT);
-    }
-    else                                                    // send small packets without compression
-    {
-        packet->append(buf);
-        packet->SetOpcode(SMSG_UPDATE_OBJECT);
+        if (destsize + sizeof(uint32) < pSize)
+        {
+            packet->resize(destsize + sizeof(uint32));
+            packet->SetOpcode(SMSG_COMPRESSED_UPDATE_OBJECT);
+            return true;
+        }
+        packet->clear();                                    // incompressible, send it as is
     }
 
+    // send small packets without compression
+    packet->append(payload, pSize);
+    packet->SetOpcode(SMSG_UPDATE_OBJECT);
     return true;
 }
 
 void UpdateData::Send(WorldSession* session, bool hasTransport)
 {
     WorldPacket data;
-    if (!m_datas.size() && !m_outOfRangeGUIDs.empty())
+    if (m_buffer.empty() && !m_outOfRangeGUIDs.empty())
     {
-        BuildPacket(&data, NULL, hasTransport);
+        BuildPacket(&data, 0, hasTransport);
         session->SendPacket(&data);
         m_outOfRangeGUIDs.clear();
         return;
     }
-    for (std::list<UpdatePacket>::iterator it = m_datas.begin(); it != m_datas.end(); ++it)
+    for (size_t i = 0; i < GetPacketsCount(); ++i)
     {
-        BuildPacket(&data, &(*it), hasTransport);
+        BuildPacket(&data, i, hasTransport);
         session->SendPacket(&data);
         data.clear();
         m_outOfRangeGUIDs.clear();
@@ -199,7 +259,9 @@ void UpdateData::Send(WorldSession* session, bool hasTransport)
 
 void UpdateData::Clear()
 {
-    m_datas.clear();
+    m_buffer.clear();
+    m_packetStarts.clear();
+    m_lastPacketBlocks = 0;
     m_outOfRangeGUIDs.clear();
 }
 
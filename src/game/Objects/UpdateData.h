@@ -23,9 +23,10 @@
 #define __UPDATEDATA_H
 
 #include "ByteBuffer.h"
+#include "WorldPacket.h"
 #include "ObjectGuid.h"
+#include <vector>
 
-class WorldPacket;
 class WorldSession;
 class WorldObject;
 
@@ -52,40 +53,46 @@ enum ObjectUpdateFlags
     UPDATEFLAG_HAS_POSITION = 0x0040
 };
 
-class UpdatePacket
-{
-    public:
-        UpdatePacket() : blockCount(0) {}
-        ByteBuffer data;
-        uint32 blockCount;
-};
-
+// Each thread keeps its own zlib stream, reset between packets
 class PacketCompressor
 {
     public:
         static void Compress(void* dst, uint32 *dst_size, void* src, int src_size);
+        static void Compress(void* dst, uint32 *dst_size, void* src, int src_size, int level);
 };
 
+/**
+ * Update blocks for one player, split in packets of at most ~32KB.
+ * All packets are written one after the other in a single buffer taken from
+ * the per-thread PacketBufferPool, each one starting with room for its header,
+ * so that building a packet only patches the header and compresses in place.
+ */
 class UpdateData
 {
     public:
         UpdateData();
-        ~UpdateData();
 
-        void AddOutOfRangeGUID(ObjectGuidSet& guids);
+        void AddOutOfRangeGUID(ObjectGuidSortedSet const& guids);
         void AddOutOfRangeGUID(ObjectGuid const &guid);
         void AddUpdateBlock(const ByteBuffer &block);
         void Send(WorldSession* session, bool hasTransport = false);
         bool BuildPacket(WorldPacket *packet, bool hasTransport = false);
-        bool BuildPacket(WorldPacket *packet, UpdatePacket const* updPacket, bool hasTransport = false);
-        bool HasData() { return m_datas.size() || !m_outOfRangeGUIDs.empty(); }
+        bool BuildPacket(WorldPacket *packet, size_t index, bool hasTransport = false);
+        // Packet content before compression
+        void BuildPayload(ByteBuffer& buf, size_t index, bool hasTransport = false);
+        bool HasData() const { return !m_buffer.empty() || !m_outOfRangeGUIDs.empty(); }
+        size_t GetPacketsCount() const { return m_buffer.empty() ? 0 : m_packetStarts.size() + 1; }
         void Clear();
 
-        ObjectGuidSet const& GetOutOfRangeGUIDs() const { return m_outOfRangeGUIDs; }
+        std::vector<ObjectGuid> const& GetOutOfRangeGUIDs() const { return m_outOfRangeGUIDs; }
 
     protected:
-        ObjectGuidSet m_outOfRangeGUIDs;
-        std::list<UpdatePacket> m_datas;
+        void GetPacketBounds(size_t index, size_t& begin, size_t& end) const;
+
+        std::vector<ObjectGuid> m_outOfRangeGUIDs;          // may contain duplicates until sent
+        WorldPacket m_buffer;                               // pooled storage, [header|blocks] per packet
+        std::vector<size_t> m_packetStarts;                 // offset of the packets after the first one
+        uint32 m_lastPacketBlocks;
 };
 
 class MovementData
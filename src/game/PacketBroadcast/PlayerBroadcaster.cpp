@@ -48,7 +48,7 @@ void PlayerBroadcaster::ClearListeners()
     m_listeners.clear();
 }
 
-void PlayerBroadcaster::SendPacket(const WorldPacket& packet)
+void PlayerBroadcaster::SendPacket(const SharedWorldPacket& packet)
 {
     if (m_socket)
         m_socket->SendPacket(packet);
@@ -85,7 +85,7 @@ void PlayerBroadcaster::ProcessQueue(uint32& num_packets)
 void PlayerBroadcaster::QueuePacket(WorldPacket packet, bool self, ObjectGuid except)
 {
     BroadcastData data;
-    data.packet = std::move(packet);
+    data.packet = std::make_shared<WorldPacket>(std::move(packet));
     data.sendToSelf = self;
     data.except = except;
 
@@ -97,7 +97,7 @@ void PlayerBroadcaster::QueuePacket(WorldPacket packet, bool self, ObjectGuid ex
     if (m_queue.size() >= MAX_QUEUE_SIZE)
     {
         BroadcastData& last_in_queue = m_queue[m_queue.size() - 1];
-        if (CanSkipPacket(last_in_queue.packet.GetOpcode()) && CanSkipPacket(packet.GetOpcode()))
+        if (CanSkipPacket(last_in_queue.packet->GetOpcode()) && CanSkipPacket(data.packet->GetOpcode()))
         {
             m_queue[m_queue.size() - 1] = std::move(data);
             guard.unlock();
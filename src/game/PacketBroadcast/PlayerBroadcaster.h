@@ -18,7 +18,7 @@ class PlayerBroadcaster final
 {
     struct BroadcastData
     {
-        WorldPacket packet;
+        SharedWorldPacket packet;                           // built once, referenced by every listener socket
         bool sendToSelf;
         ObjectGuid except;
     };
@@ -34,7 +34,7 @@ class PlayerBroadcaster final
     std::mutex m_queue_lock;
 
     void ProcessQueue(uint32& num_packets);
-    void SendPacket(const WorldPacket& packet);
+    void SendPacket(const SharedWorldPacket& packet);
 
     static inline bool CanSkipPacket(uint32 opcode)
     {
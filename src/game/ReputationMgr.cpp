@@ -438,18 +438,19 @@ void ReputationMgr::LoadFromDB(QueryResult *result)
 
 void ReputationMgr::SaveToDB()
 {
-    static SqlStatementID delRep ;
-    static SqlStatementID insRep ;
+    static SqlStatementID replaceRep ;
 
-    SqlStatement stmtDel = CharacterDatabase.CreateStatement(delRep, "DELETE FROM character_reputation WHERE guid = ? AND faction=?");
-    SqlStatement stmtIns = CharacterDatabase.CreateStatement(insRep, "INSERT INTO character_reputation (guid,faction,standing,flags) VALUES (?, ?, ?, ?)");
+    SqlStatement stmt = CharacterDatabase.CreateStatement(replaceRep, "REPLACE INTO character_reputation (guid,faction,standing,flags) VALUES (?, ?, ?, ?)");
 
     for (FactionStateList::iterator itr = m_factions.begin(); itr != m_factions.end(); ++itr)
     {
         if (itr->second.needSave)
         {
-            stmtDel.PExecute(m_player->GetGUIDLow(), itr->second.ID);
-            stmtIns.PExecute(m_player->GetGUIDLow(), itr->second.ID, itr->second.Standing, itr->second.Flags);
+            stmt.addUInt32(m_player->GetGUIDLow());
+            stmt.addUInt32(itr->second.ID);
+            stmt.addInt32(itr->second.Standing);
+            stmt.addUInt32(itr->second.Flags);
+            stmt.ExecuteBatched();
             itr->second.needSave = false;
         }
     }
@@ -645,9 +645,11 @@ void Spell::FillTargetMap()
             }
         }
 
+        // Area spells check the line of sight of all their targets at once, after the cheaper checks
+        bool losAtOnce = tmpUnitMap.size() > 1 && CanCheckTargetsLoSAtOnce(SpellEffectIndex(i));
         for (UnitList::iterator itr = tmpUnitMap.begin(); itr != tmpUnitMap.end();)
         {
-            if (!CheckTarget(*itr, SpellEffectIndex(i)))
+            if (!CheckTarget(*itr, SpellEffectIndex(i), !losAtOnce))
             {
                 itr = tmpUnitMap.erase(itr);
                 continue;
@@ -655,6 +657,8 @@ void Spell::FillTargetMap()
             else
                 ++itr;
         }
+        if (losAtOnce)
+            RemoveTargetsOutOfLoS(tmpUnitMap);
 
         for (UnitList::const_iterator iunit = tmpUnitMap.begin(); iunit != tmpUnitMap.end(); ++iunit)
             AddUnitTarget((*iunit), SpellEffectIndex(i));
@@ -7661,7 +7665,7 @@ CurrentSpellTypes Spell::GetCurrentContainer() const
         return (CURRENT_GENERIC_SPELL);
 }
 
-bool Spell::CheckTarget(Unit* target, SpellEffectIndex eff)
+bool Spell::CheckTarget(Unit* target, SpellEffectIndex eff, bool checkLoS)
 {
     if (target != m_caster && IsPositiveSpell(m_spellInfo))
     {
@@ -7741,7 +7745,7 @@ bool Spell::CheckTarget(Unit* target, SpellEffectIndex eff)
             break;
         default:                                            // normal case
             // Get GO cast coordinates if original caster -> GO
-            if (target != m_caster)
+            if (checkLoS && target != m_caster)
                 if (WorldObject *caster = GetCastingObject())
                     if (!(m_spellInfo->AttributesEx2 & SPELL_ATTR_EX2_IGNORE_LOS) && !target->IsWithinLOSInMap(caster))
                         return false;
@@ -7755,6 +7759,61 @@ bool Spell::CheckTarget(Unit* target, SpellEffectIndex eff)
     return true;
 }
 
+// True when the line of sight check of CheckTarget is the normal one, that RemoveTargetsOutOfLoS can do for all the targets
+bool Spell::CanCheckTargetsLoSAtOnce(SpellEffectIndex eff) const
+{
+    if (m_spellInfo->AttributesEx2 & SPELL_ATTR_EX2_IGNORE_LOS)
+        return false;
+
+    switch (m_spellInfo->Effect[eff])
+    {
+        case SPELL_EFFECT_SUMMON_PLAYER:
+        case SPELL_EFFECT_DUMMY:
+        case SPELL_EFFECT_RESURRECT:
+        case SPELL_EFFECT_RESURRECT_NEW:
+            return false;
+        default:
+            break;
+    }
+
+    WorldObject* caster = GetCastingObject();
+    return caster && caster->IsInWorld();
+}
+
+// Same result as target->IsWithinLOSInMap(caster) for each target, but the map models are traversed only once
+void Spell::RemoveTargetsOutOfLoS(UnitList& targetUnitMap)
+{
+    WorldObject* caster = GetCastingObject();
+    if (!caster)
+        return;
+
+    std::vector<G3D::Vector3> positions;
+    positions.reserve(targetUnitMap.size());
+    for (Unit* target : targetUnitMap)
+    {
+        if (target == m_caster || !target->IsInMap(caster) || target->IsWithinDist(caster, 0.0f))
+            continue;
+        positions.push_back(G3D::Vector3(target->GetPositionX(), target->GetPositionY(), target->GetPositionZ() + target->GetCollisionHeight()));
+    }
+
+    std::vector<bool> inLoS;
+    if (!positions.empty())
+    {
+        float height = caster->IsUnit() ? caster->ToUnit()->GetCollisionHeight() : 2.f;
+        caster->GetMap()->isInLineOfSight(caster->GetPositionX(), caster->GetPositionY(), caster->GetPositionZ() + height, positions, inLoS);
+    }
+
+    size_t index = 0;
+    for (UnitList::iterator itr = targetUnitMap.begin(); itr != targetUnitMap.end();)
+    {
+        Unit* target = *itr;
+        if (target == m_caster || (target->IsInMap(caster) && (target->IsWithinDist(caster, 0.0f) || inLoS[index++])))
+            ++itr;
+        else
+            itr = targetUnitMap.erase(itr);
+    }
+}
+
 bool Spell::IsNeedSendToClient() const
 {
     return !IsChannelingVisual() && (m_spellInfo->SpellVisual != 0 || m_channeled ||
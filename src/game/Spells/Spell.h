@@ -381,7 +381,9 @@ class Spell
 
         template<typename T> WorldObject* FindCorpseUsing();
 
-        bool CheckTarget( Unit* target, SpellEffectIndex eff );
+        bool CheckTarget( Unit* target, SpellEffectIndex eff, bool checkLoS = true );
+        bool CanCheckTargetsLoSAtOnce(SpellEffectIndex eff) const;
+        void RemoveTargetsOutOfLoS(UnitList& targetUnitMap);
         bool CanAutoCast(Unit* target);
 
         static void MANGOS_DLL_SPEC SendCastResult(Player* caster, SpellEntry const* spellInfo, SpellCastResult result);
@@ -43,6 +43,7 @@
 #include "Chat.h"
 #include "DBCStores.h"
 #include "MassMailMgr.h"
+#include "LoaderGraph.h"
 #include "LootMgr.h"
 #include "ItemEnchantmentMgr.h"
 #include "MapManager.h"
@@ -55,6 +56,7 @@
 #include "GameEventMgr.h"
 #include "PoolManager.h"
 #include "Database/DatabaseImpl.h"
+#include "Database/SQLStorage.h"
 #include "GridNotifiersImpl.h"
 #include "CellImpl.h"
 #include "MapPersistentStateMgr.h"
@@ -73,6 +75,7 @@
 #include "CharacterDatabaseCache.h"
 #include "CreatureGroups.h"
 #include "MoveMap.h"
+#include "PathFinder.h"
 #include "SpellModMgr.h"
 #include "NodesMgr.h"
 #include "Anticheat.h"
@@ -110,6 +113,46 @@ World& GetSWorld()
     return sWorld;
 }
 
+void PlayerSaveStats::Record(uint32 statementsCount, uint32 bytesCount)
+{
+    saves.fetch_add(1, std::memory_order_relaxed);
+    statements.fetch_add(statementsCount, std::memory_order_relaxed);
+    bytes.fetch_add(bytesCount, std::memory_order_relaxed);
+
+    uint32 current = maxStatements.load(std::memory_order_relaxed);
+    while (current < statementsCount && !maxStatements.compare_exchange_weak(current, statementsCount, std::memory_order_relaxed))
+        ;
+    current = maxBytes.load(std::memory_order_relaxed);
+    while (current < bytesCount && !maxBytes.compare_exchange_weak(current, bytesCount, std::memory_order_relaxed))
+        ;
+}
+
+void PlayerSaveStats::Reset()
+{
+    saves = 0;
+    statements = 0;
+    bytes = 0;
+    maxStatements = 0;
+    maxBytes = 0;
+}
+
+void PlayerLoginStats::Record(SqlQueryHolder const* holder)
+{
+    waitUs.Add(holder->GetWaitTime());
+    execUs.Add(holder->GetExecutionTime());
+    if (queryUs.size() < holder->GetSize())
+        queryUs.resize(holder->GetSize());
+    for (size_t i = 0; i < holder->GetSize(); ++i)
+        queryUs[i].Add(holder->GetQueryTime(i));
+}
+
+void PlayerLoginStats::Reset()
+{
+    waitUs.Reset();
+    execUs.Reset();
+    queryUs.clear();
+}
+
 /// World constructor
 World::World()
 {
@@ -144,6 +187,7 @@ World::World()
 
     m_timeRate = 1.0f;
     m_charDbWorkerThread    = nullptr;
+    m_charDbOverloaded = false;
 }
 
 /// World destructor
@@ -515,6 +559,7 @@ void World::LoadConfigSettings(bool reload)
     setConfig(CONFIG_UINT32_CHARACTER_SCREEN_MAX_IDLE_TIME, "CharacterScreenMaxIdleTime", 0);
     setConfig(CONFIG_UINT32_ASYNC_QUERIES_TICK_TIMEOUT, "AsyncQueriesTickTimeout", 0);
     setConfigMinMax(CONFIG_UINT32_COMPRESSION, "Compression", 1, 1, 9);
+    setConfig(CONFIG_UINT32_COMPRESSION_THRESHOLD, "Compression.Threshold", 100);
     setConfig(CONFIG_BOOL_ADDON_CHANNEL, "AddonChannel", true);
     setConfig(CONFIG_BOOL_CLEAN_CHARACTER_DB, "CleanCharacterDB", true);
     setConfig(CONFIG_BOOL_GRID_UNLOAD, "GridUnload", true);
@@ -841,12 +886,17 @@ void World::LoadConfigSettings(bool reload)
         sLog.outString("Using DataDir %s", m_dataPath.c_str());
     }
 
+    SQLStorageSnapshot::SetDirectory(sConfig.GetStringDefault("SQLStorage.SnapshotDir", ""));
+    sCharacterDatabaseCache.SetMaxOfflineOwners(sConfig.GetIntDefault("CharacterDatabaseCache.MaxOfflineOwners", 1000));
+
     setConfig(CONFIG_BOOL_VMAP_INDOOR_CHECK, "vmap.enableIndoorCheck", true);
     bool enableLOS = sConfig.GetBoolDefault("vmap.enableLOS", false);
     bool enableHeight = sConfig.GetBoolDefault("vmap.enableHeight", false);
     bool disableModelUnload = sConfig.GetBoolDefault("Collision.Models.Unload", false);
     std::string ignoreSpellIds = sConfig.GetStringDefault("vmap.ignoreSpellIds", "");
     setConfig(CONFIG_BOOL_PET_LOS, "vmap.petLoS", true);
+    setConfig(CONFIG_UINT32_LOS_CACHE_LIFETIME, "vmap.LoSCache.Lifetime", 500);
+    setConfig(CONFIG_UINT32_LOS_CACHE_MAX_ENTRIES, "vmap.LoSCache.MaxEntries", 16384);
 
     if (!enableHeight)
         sLog.outError("VMAP height use disabled! Creatures movements and other things will be in broken state.");
@@ -859,6 +909,9 @@ void World::LoadConfigSettings(bool reload)
     sLog.outString("WORLD: VMap data directory is: %svmaps", m_dataPath.c_str());
     setConfig(CONFIG_BOOL_MMAP_ENABLED, "mmap.enabled", true);
     sLog.outString("WORLD: mmap pathfinding %sabled", getConfig(CONFIG_BOOL_MMAP_ENABLED) ? "en" : "dis");
+    MMAP::MMapFactory::createOrGetMMapManager()->SetQueryPoolSize(sConfig.GetIntDefault("mmap.QueryPool.MaxQueries", 16),
+        sConfig.GetIntDefault("mmap.QueryPool.Preallocated", 2));
+    sPathCorridorCache.SetCapacity(sConfig.GetIntDefault("mmap.PathCache.MaxEntries", 4096));
     setConfig(CONFIG_BOOL_IS_MAPSERVER, "IsMapServer", false);
 
     setConfig(CONFIG_UINT32_EMPTY_MAPS_UPDATE_TIME, "MapUpdate.Empty.UpdateTime", 0);
@@ -866,6 +919,7 @@ void World::LoadConfigSettings(bool reload)
     setConfigMinMax(CONFIG_UINT32_MAP_OBJECTSUPDATE_TIMEOUT, "MapUpdate.ObjectsUpdate.Timeout", 100, 10, 2000);
     setConfigMinMax(CONFIG_UINT32_MAP_VISIBILITYUPDATE_THREADS, "MapUpdate.VisibilityUpdate.MaxThreads", 4, 1, 20);
     setConfigMinMax(CONFIG_UINT32_MAP_VISIBILITYUPDATE_TIMEOUT, "MapUpdate.VisibilityUpdate.Timeout", 100, 10, 2000);
+    setConfig(CONFIG_UINT32_VISIBILITY_FULL_UPDATE_DELAY, "Visibility.FullUpdateDelay", 2000);
     setConfigMinMax(CONFIG_UINT32_MAPUPDATE_INSTANCED_UPDATE_THREADS, "MapUpdate.Instanced.UpdateThreads", 2, 0, 20);
     setConfigMinMax(CONFIG_UINT32_MTCELLS_THREADS, "MapUpdate.Continents.MTCells.Threads", 0, 0, 20);
     setConfigMinMax(CONFIG_UINT32_MTCELLS_SAFEDISTANCE, "MapUpdate.Continents.MTCells.SafeDistance", 1066, 0, 34112);
@@ -881,8 +935,11 @@ void World::LoadConfigSettings(bool reload)
     setConfig(CONFIG_UINT32_MAPUPDATE_MIN_VISIBILITY_DISTANCE, "MapUpdate.MinVisibilityDistance", 0);
     setConfig(CONFIG_BOOL_CONTINENTS_INSTANCIATE, "Continents.Instanciate", false);
     setConfig(CONFIG_UINT32_CONTINENTS_MOTIONUPDATE_THREADS, "Continents.MotionUpdate.Threads", 0);
+    setConfigMinMax(CONFIG_UINT32_PATH_REQUESTS_THREADS, "MapUpdate.PathRequests.Threads", 0, 0, ThreadPool::MAX_THREADS);
+    setConfigMinMax(CONFIG_UINT32_MAPUPDATE_POOL_THREADS, "MapUpdate.ThreadPool.Threads", 0, 0, ThreadPool::MAX_THREADS);
     setConfig(CONFIG_BOOL_TERRAIN_PRELOAD_CONTINENTS, "Terrain.Preload.Continents", 1);
     setConfig(CONFIG_BOOL_TERRAIN_PRELOAD_INSTANCES, "Terrain.Preload.Instances", 1);
+    setConfig(CONFIG_BOOL_PARALLEL_LOADING, "Startup.ParallelLoading", true);
 
     setConfig(CONFIG_BOOL_ENABLE_MOVEMENT_INTERP, "Movement.Interpolation", true);
     setConfigMinMax(CONFIG_UINT32_MAX_POINTS_PER_MVT_PACKET, "Movement.MaxPointsPerPacket", 80, 5, 10000);
@@ -1403,54 +1460,94 @@ void World::SetInitialWorldSettings()
         sObjectMgr.LoadCorpses();
     }
 
-    sLog.outString("Loading Loot Tables...");
-    sLog.outString();
-    LoadLootTables();
-    sLog.outString(">>> Loot Tables loaded");
-    sLog.outString();
-
-    sLog.outString("Loading Skill Fishing base level requirements...");
-    sObjectMgr.LoadFishingBaseSkillLevel();
-
-    sLog.outString("Loading Npc Text Id...");
-    sObjectMgr.LoadNpcGossips();                            // must be after load Creature and LoadNPCText
-
-    sLog.outString("Loading Gossip scripts...");
-    sScriptMgr.LoadGossipScripts();                         // must be before gossip menu options
-
-    sLog.outString("Loading Gossip menus...");
-    sObjectMgr.LoadGossipMenu();
-
-    sLog.outString("Loading Gossip menu options...");
-    sObjectMgr.LoadGossipMenuItems();
-
-    sLog.outString("Loading Vendors...");
-    sObjectMgr.LoadVendorTemplates();                       // must be after load ItemTemplate
-    sObjectMgr.LoadVendors();                               // must be after load CreatureTemplate, VendorTemplate, and ItemTemplate
-
-    sLog.outString("Loading Trainers...");
-    sObjectMgr.LoadTrainerTemplates();                      // must be after load CreatureTemplate
-    sObjectMgr.LoadTrainers();                              // must be after load CreatureTemplate, TrainerTemplate
-
-    sLog.outString("Loading Waypoint scripts...");          // before loading from creature_movement
-    sScriptMgr.LoadCreatureMovementScripts();
-
-    sLog.outString("Loading Waypoints...");
-    sLog.outString();
-    sWaypointMgr.Load();
-
-    ///- Loading localization data
-    sLog.outString("Loading Localization strings...");
-    sObjectMgr.LoadBroadcastTextLocales();
-    sObjectMgr.LoadCreatureLocales();                       // must be after CreatureInfo loading
-    sObjectMgr.LoadGameObjectLocales();                     // must be after GameobjectInfo loading
-    sObjectMgr.LoadItemLocales();                           // must be after ItemPrototypes loading
-    sObjectMgr.LoadQuestLocales();                          // must be after QuestTemplates loading
-    sObjectMgr.LoadPageTextLocales();                       // must be after PageText loading
-    sObjectMgr.LoadGossipMenuItemsLocales();                // must be after gossip menu items loading
-    sObjectMgr.LoadPointOfInterestLocales();                // must be after POI loading
-    sObjectMgr.LoadAreaLocales();
-    sLog.outString(">>> Localization strings loaded");
+    uint32 poolThreads = getConfig(CONFIG_UINT32_MAPUPDATE_POOL_THREADS);
+    if (!poolThreads)
+        poolThreads = std::max(2u, std::thread::hardware_concurrency());
+    m_threadPool.reset(new ThreadPool(poolThreads,
+                                      []() { WorldDatabase.ThreadStart(); },
+                                      []() { WorldDatabase.ThreadEnd(); }));
+    sLog.outString("Started %u map update threads", poolThreads);
+
+    ///- Independent tables, only reading the templates loaded above
+    LoaderGraph loaders;
+    loaders.Add("loot", []()
+    {
+        sLog.outString("Loading Loot Tables...");
+        LoadLootTables();
+        sLog.outString(">>> Loot Tables loaded");
+    });
+    loaders.Add("fishing", []()
+    {
+        sLog.outString("Loading Skill Fishing base level requirements...");
+        sObjectMgr.LoadFishingBaseSkillLevel();
+    });
+    loaders.Add("npc_gossip", []()
+    {
+        sLog.outString("Loading Npc Text Id...");
+        sObjectMgr.LoadNpcGossips();                        // must be after load Creature and LoadNPCText
+    });
+    loaders.Add("gossip_scripts", []()
+    {
+        sLog.outString("Loading Gossip scripts...");
+        sScriptMgr.LoadGossipScripts();                     // must be before gossip menu options
+    });
+    loaders.Add("gossip_menu", []()
+    {
+        sLog.outString("Loading Gossip menus...");
+        sObjectMgr.LoadGossipMenu();
+    });
+    loaders.Add("gossip_menu_option", []()
+    {
+        sLog.outString("Loading Gossip menu options...");
+        sObjectMgr.LoadGossipMenuItems();
+    }, { "gossip_scripts", "gossip_menu" });
+    loaders.Add("vendors", []()
+    {
+        sLog.outString("Loading Vendors...");
+        sObjectMgr.LoadVendorTemplates();                   // must be after load ItemTemplate
+        sObjectMgr.LoadVendors();                           // must be after load CreatureTemplate, VendorTemplate, and ItemTemplate
+    });
+    loaders.Add("trainers", []()
+    {
+        sLog.outString("Loading Trainers...");
+        sObjectMgr.LoadTrainerTemplates();                  // must be after load CreatureTemplate
+        sObjectMgr.LoadTrainers();                          // must be after load CreatureTemplate, TrainerTemplate
+    });
+    // script loading may fix quest flags, keep it away from the other script table
+    loaders.Add("creature_movement_scripts", []()
+    {
+        sLog.outString("Loading Waypoint scripts...");      // before loading from creature_movement
+        sScriptMgr.LoadCreatureMovementScripts();
+    }, { "gossip_scripts" });
+    loaders.Add("waypoints", []()
+    {
+        sLog.outString("Loading Waypoints...");
+        sWaypointMgr.Load();
+    }, { "creature_movement_scripts" });
+    ///- Loading localization data, one after the other as they share the locale indexes
+    loaders.Add("locales", []()
+    {
+        sLog.outString("Loading Localization strings...");
+        sObjectMgr.LoadBroadcastTextLocales();
+        sObjectMgr.LoadCreatureLocales();                   // must be after CreatureInfo loading
+        sObjectMgr.LoadGameObjectLocales();                 // must be after GameobjectInfo loading
+        sObjectMgr.LoadItemLocales();                       // must be after ItemPrototypes loading
+        sObjectMgr.LoadQuestLocales();                      // must be after QuestTemplates loading
+        sObjectMgr.LoadPageTextLocales();                   // must be after PageText loading
+        sObjectMgr.LoadGossipMenuItemsLocales();            // must be after gossip menu items loading
+        sObjectMgr.LoadPointOfInterestLocales();            // must be after POI loading
+        sObjectMgr.LoadAreaLocales();
+        sLog.outString(">>> Localization strings loaded");
+    }, { "gossip_menu_option" });
+
+    bool parallelLoading = getConfig(CONFIG_BOOL_PARALLEL_LOADING);
+    // Progress bars of loaders running at the same time would be mixed up
+    if (parallelLoading)
+        BarGoLink::SetOutputState(false);
+    loaders.Run(parallelLoading ? GetThreadPool() : nullptr);
+    if (parallelLoading)
+        BarGoLink::SetOutputState(sConfig.GetBoolDefault("ShowProgressBars", true));
+    loaders.LogTimeline();
     sLog.outString();
 
     ///- Load dynamic data tables from the database
@@ -1608,7 +1705,7 @@ void World::SetInitialWorldSettings()
         sLog.outString("Caching player phases (obsolete)");
         sObjectMgr.LoadPlayerPhaseFromDb();
 
-        sLog.outString("Caching player pets ...");
+        sLog.outString("Loading used pet numbers ...");
         sCharacterDatabaseCache.LoadAll();
 
         sLog.outString("Loading PlayerBot ..."); // Requires Players cache
@@ -1703,22 +1800,15 @@ void World::DetectDBCLang()
     sLog.outString();
 }
 
-class WorldAsyncTasksExecutor : public ACE_Based::Runnable
+static void ExecuteWorldAsyncTasks()
 {
-public:
-    WorldAsyncTasksExecutor() {}
-    void run()
+    AsyncTask* task;
+    while (sWorld.GetNextAsyncTask(task))
     {
-        WorldDatabase.ThreadStart();
-        AsyncTask* task;
-        while (sWorld.GetNextAsyncTask(task))
-        {
-            task->run();
-            delete task;
-        }
-        WorldDatabase.ThreadEnd();
+        task->run();
+        delete task;
     }
-};
+}
 
 /// Update the World !
 void World::Update(uint32 diff)
@@ -1735,6 +1825,17 @@ void World::Update(uint32 diff)
     ///- Update the game time and check for shutdown time
     _UpdateGameTime();
 
+    ///- Deferrable character writes (autosaves) are postponed while the character database is behind
+    bool charDbOverloaded = CharacterDatabase.IsAsyncQueueOverloaded();
+    if (charDbOverloaded != m_charDbOverloaded)
+    {
+        if (charDbOverloaded)
+            sLog.outError("Character database is overloaded (%u operations queued), player autosaves are postponed.", uint32(CharacterDatabase.GetAsyncQueueSize()));
+        else
+            sLog.outString("Character database caught up, player autosaves resumed.");
+        m_charDbOverloaded = charDbOverloaded;
+    }
+
     ///-Update mass mailer tasks if any
     sMassMailMgr.Update();
 
@@ -1768,10 +1869,10 @@ void World::Update(uint32 diff)
 
     ///- Update objects (maps, transport, creatures,...)
     uint32 updateMapSystemTime = WorldTimer::getMSTime();
-    std::vector<ACE_Based::Thread*> asyncTaskThreads;
+    TaskGroup asyncTasks(GetThreadPool(), GetTaskPhaseStats(TASK_PHASE_WORLD_ASYNC_TASKS));
     int threadsCount = getConfig(CONFIG_UINT32_ASYNC_TASKS_THREADS_COUNT);
     for (int i = 0; i < threadsCount; ++i)
-        asyncTaskThreads.push_back(new ACE_Based::Thread(new WorldAsyncTasksExecutor()));
+        asyncTasks.run(&ExecuteWorldAsyncTasks);
 
     sMapMgr.Update(diff);
     sBattleGroundMgr.Update(diff);
@@ -1792,11 +1893,7 @@ void World::Update(uint32 diff)
     }
 
     uint32 asyncWaitBegin = WorldTimer::getMSTime();
-    for (int i = 0; i < threadsCount; ++i)
-    {
-        asyncTaskThreads[i]->wait();
-        delete asyncTaskThreads[i];
-    }
+    asyncTasks.wait();
 
     updateMapSystemTime = WorldTimer::getMSTimeDiffToNow(updateMapSystemTime);
     if (getConfig(CONFIG_UINT32_PERFLOG_SLOW_MAPSYSTEM_UPDATE) && updateMapSystemTime > getConfig(CONFIG_UINT32_PERFLOG_SLOW_MAPSYSTEM_UPDATE))
@@ -35,6 +35,8 @@
 #include "ObjectGuid.h"
 #include "MapNodes/AbstractPlayer.h"
 #include "WorldPacket.h"
+#include "ThreadPool.h"
+#include "Database/SqlDelayQueue.h"
 
 #include <map>
 #include <set>
@@ -47,6 +49,7 @@ class Object;
 class WorldSession;
 class Player;
 class SqlResultQueue;
+class SqlQueryHolder;
 class QueryResult;
 class World;
 class MovementBroadcaster;
@@ -92,6 +95,7 @@ enum WorldTimers
 enum eConfigUInt32Values
 {
     CONFIG_UINT32_COMPRESSION = 0,
+    CONFIG_UINT32_COMPRESSION_THRESHOLD,
     CONFIG_UINT32_LOGIN_QUEUE_GRACE_PERIOD_SECS,
     CONFIG_UINT32_CHARACTER_SCREEN_MAX_IDLE_TIME,
     CONFIG_UINT32_PLAYER_HARD_LIMIT,
@@ -143,6 +147,8 @@ enum eConfigUInt32Values
     CONFIG_UINT32_MAPUPDATE_UPDATE_CELLS_DIFF,
     CONFIG_UINT32_LOG_MONEY_TRADES_TRESHOLD,
     CONFIG_UINT32_RELOCATION_VMAP_CHECK_TIMER,
+    CONFIG_UINT32_LOS_CACHE_LIFETIME,
+    CONFIG_UINT32_LOS_CACHE_MAX_ENTRIES,
     CONFIG_UINT32_MAPUPDATE_TICK_LOWER_VISIBILITY_DISTANCE,
     CONFIG_UINT32_MAPUPDATE_TICK_INCREASE_VISIBILITY_DISTANCE,
     CONFIG_UINT32_MAPUPDATE_MIN_VISIBILITY_DISTANCE,
@@ -151,6 +157,8 @@ enum eConfigUInt32Values
     CONFIG_UINT32_PBCAST_DIFF_LOWER_VISIBILITY_DISTANCE,
     CONFIG_UINT32_MAPUPDATE_MIN_GRID_ACTIVATION_DISTANCE,
     CONFIG_UINT32_CONTINENTS_MOTIONUPDATE_THREADS,
+    CONFIG_UINT32_PATH_REQUESTS_THREADS,
+    CONFIG_UINT32_MAPUPDATE_POOL_THREADS,
     CONFIG_UINT32_PERFLOG_SLOW_WORLD_UPDATE,
     CONFIG_UINT32_PERFLOG_SLOW_MAP_UPDATE,
     CONFIG_UINT32_PERFLOG_SLOW_MAPSYSTEM_UPDATE,
@@ -172,6 +180,7 @@ enum eConfigUInt32Values
     CONFIG_UINT32_MAP_OBJECTSUPDATE_TIMEOUT,
     CONFIG_UINT32_MAP_VISIBILITYUPDATE_THREADS,
     CONFIG_UINT32_MAP_VISIBILITYUPDATE_TIMEOUT,
+    CONFIG_UINT32_VISIBILITY_FULL_UPDATE_DELAY,
     CONFIG_UINT32_INTERVAL_SAVE,
     CONFIG_UINT32_INTERVAL_GRIDCLEAN,
     CONFIG_UINT32_INTERVAL_MAPUPDATE,
@@ -408,6 +417,7 @@ enum eConfigBoolValues
     CONFIG_BOOL_SMARTLOG_SCRIPTINFO,
     CONFIG_BOOL_TERRAIN_PRELOAD_CONTINENTS,
     CONFIG_BOOL_TERRAIN_PRELOAD_INSTANCES,
+    CONFIG_BOOL_PARALLEL_LOADING,
     CONFIG_BOOL_CLEANUP_TERRAIN,
     CONFIG_BOOL_OUTDOORPVP_EP_ENABLE,
     CONFIG_BOOL_OUTDOORPVP_SI_ENABLE,
@@ -527,6 +537,46 @@ enum RealmZone
     REALM_ZONE_CN9           = 29                           // basic-Latin at create, any at login
 };
 
+// Kinds of work submitted to the world thread pool, timings are kept for each of them
+enum TaskPoolPhase
+{
+    TASK_PHASE_WORLD_ASYNC_TASKS,
+    TASK_PHASE_INSTANCES_UPDATE,
+    TASK_PHASE_CONTINENTS_UPDATE,
+    TASK_PHASE_CELLS_UPDATE,
+    TASK_PHASE_MOTION_UPDATE,
+    TASK_PHASE_PATH_REQUESTS,
+    TASK_PHASE_OBJECTS_UPDATE,
+    TASK_PHASE_VISIBILITY_UPDATE,
+    TASK_PHASE_COUNT
+};
+
+// Accumulated size of the character saves, in statements sent and in bytes of query text / parameters
+struct PlayerSaveStats
+{
+    PlayerSaveStats() { Reset(); }
+
+    void Record(uint32 statements, uint32 bytes);
+    void Reset();
+
+    std::atomic<uint64> saves;
+    std::atomic<uint64> statements;
+    std::atomic<uint64> bytes;
+    std::atomic<uint32> maxStatements;
+    std::atomic<uint32> maxBytes;
+};
+
+// Timings of the character login queries, updated and read from the world thread only
+struct PlayerLoginStats
+{
+    void Record(SqlQueryHolder const* holder);
+    void Reset();
+
+    SqlDelayQueue::Histogram waitUs;                        // queued before the first query started
+    SqlDelayQueue::Histogram execUs;                        // all the queries, as seen by the client
+    std::vector<SqlDelayQueue::Histogram> queryUs;          // per PlayerLoginQueryIndex
+};
+
 class AsyncTask
 {
 public:
@@ -756,6 +806,11 @@ class World
 
         // Nostalrius
         MovementBroadcaster* GetBroadcaster() { return m_broadcaster.get(); }
+        ThreadPool* GetThreadPool() { return m_threadPool.get(); }
+        TaskPhaseStats* GetTaskPhaseStats(TaskPoolPhase phase) { return &m_taskPhaseStats[phase]; }
+        PlayerSaveStats* GetPlayerSaveStats() { return &m_playerSaveStats; }
+        PlayerLoginStats* GetPlayerLoginStats() { return &m_playerLoginStats; }
+        bool IsCharacterDatabaseOverloaded() const { return m_charDbOverloaded; }
         float GetTimeRate() const { return m_timeRate; }
         void SetTimeRate(float rate) { m_timeRate = rate; }
         float m_timeRate;
@@ -900,6 +955,14 @@ class World
 
         // Packet broadcaster
         std::unique_ptr<MovementBroadcaster> m_broadcaster;
+
+        // Workers shared by all map update steps
+        std::unique_ptr<ThreadPool> m_threadPool;
+        TaskPhaseStats m_taskPhaseStats[TASK_PHASE_COUNT];
+
+        PlayerSaveStats m_playerSaveStats;
+        PlayerLoginStats m_playerLoginStats;
+        bool m_charDbOverloaded;
 };
 
 extern uint32 realmID;
@@ -52,6 +52,7 @@
 #include "NodeSession.h"
 #include "NodesOpcodes.h"
 #include "MasterPlayer.h"
+#include "CharacterDatabaseCache.h"
 
 // select opcodes appropriate for processing in Map::Update context for current session state
 static bool MapSessionFilterHelper(WorldSession* session, OpcodeHandler const& opHandle)
@@ -762,6 +763,7 @@ void WorldSession::LogoutPlayer(bool Save)
 
         ///- Update cached data at logout
         sObjectMgr.UpdatePlayerCache(_player);
+        sCharacterDatabaseCache.OnOwnerLogout(_player->GetGUIDLow());
 
         ///- Remove the player from the world
         // the player may not be in the world when logging out
@@ -27,6 +27,7 @@
 #define __WORLDSESSION_H
 
 #include "Common.h"
+#include "MPSCQueue.h"
 #include "SharedDefines.h"
 #include "ObjectGuid.h"
 #include "AuctionHouseMgr.h"
@@ -938,7 +939,8 @@ class MANGOS_DLL_SPEC WorldSession
         uint32 m_latency;
         uint32 m_Tutorials[ACCOUNT_TUTORIALS_COUNT];
         TutorialDataState m_tutorialState;
-        ACE_Based::LockedQueue<WorldPacket*, ACE_Thread_Mutex> _recvQueue[PACKET_PROCESS_MAX_TYPE];
+        // Filled by the network threads, drained by the updaters, the map being joined and the destructor
+        ACE_Based::MPSCQueue<WorldPacket*, 256> _recvQueue[PACKET_PROCESS_MAX_TYPE];
         bool _receivedPacketType[PACKET_PROCESS_MAX_TYPE];
 
         WardenInterface* m_warden;
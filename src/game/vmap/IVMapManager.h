@@ -20,8 +20,14 @@
 #define _IVMAPMANAGER_H
 
 #include<string>
+#include <vector>
 #include <Platform/Define.h>
 
+namespace G3D
+{
+    class Vector3;
+}
+
 //===========================================================
 
 /**
@@ -63,6 +69,11 @@ namespace VMAP
             virtual void unloadMap(unsigned int pMapId) = 0;
 
             virtual bool isInLineOfSight(unsigned int pMapId, float x1, float y1, float z1, float x2, float y2, float z2) = 0;
+            // Line of sight from one position to each of the targets, all in world coordinates
+            virtual void isInLineOfSight(unsigned int pMapId, float x, float y, float z, std::vector<G3D::Vector3> const& targets, std::vector<bool>& results) = 0;
+            // Records the next line of sight queries to a file, to replay them with vmaps_losbench
+            virtual bool startLoSRecording(const char* filename, uint32 maxQueries) = 0;
+            virtual void stopLoSRecording() = 0;
             virtual float getHeight(unsigned int pMapId, float x, float y, float z, float maxSearchDist) = 0;
             /**
             test if we hit an object. return true if we hit one. rx,ry,rz will hold the hit position or the dest position, if no intersection was found
@@ -25,6 +25,12 @@
 #include <sstream>
 #include <iomanip>
 #include <limits>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VMAP_LOS_SSE2
+#endif
 
 using G3D::Vector3;
 
@@ -224,6 +230,140 @@ bool StaticMapTree::isInLineOfSight(const Vector3& pos1, const Vector3& pos2) co
     return true;
 }
 //=========================================================
+
+class MapBoxCallback
+{
+public:
+    MapBoxCallback(ModelInstance* val, std::vector<uint32>& entries): prims(val), candidates(entries) {}
+    void operator()(uint32 entry)
+    {
+        // Nostalrius: pas de LoS pour certains models (arbres, ...)
+        if (prims[entry].flags & MOD_NO_BREAK_LOS)
+            return;
+        candidates.push_back(entry);
+    }
+protected:
+    ModelInstance* prims;
+    std::vector<uint32>& candidates;
+};
+
+/**
+Checks the line of sight from one position to several others.
+The models are gathered once with the bounding box of all the rays, then the rays
+are clipped against each model bounds four at a time, and only the rays crossing
+them are tested against the model geometry.
+*/
+
+void StaticMapTree::isInLineOfSight(const Vector3& source, std::vector<Vector3> const& targets, std::vector<bool>& results) const
+{
+    results.assign(targets.size(), true);
+    if (targets.empty())
+        return;
+
+    G3D::AABox area(source, source);
+    for (Vector3 const& target : targets)
+        area.merge(target);
+
+    std::vector<uint32> candidates;
+    MapBoxCallback boxCallback(iTreeValues, candidates);
+    iTree.intersectBox(area, boxCallback);
+    if (candidates.empty())
+        return;
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    // Rays padded to a multiple of four, padding rays are already out of the test
+    uint32 const count = targets.size();
+    uint32 const padded = (count + 3) & ~3u;
+    std::vector<float> invDir[3];
+    std::vector<float> maxDist(padded, -1.0f);
+    std::vector<G3D::Ray> rays(count);
+    std::vector<bool> pending(padded, false);
+    for (int axis = 0; axis < 3; ++axis)
+        invDir[axis].assign(padded, 1.0f);
+
+    uint32 remaining = 0;
+    for (uint32 i = 0; i < count; ++i)
+    {
+        Vector3 dir = targets[i] - source;
+        float dist = dir.magnitude();
+        // valid map coords should *never ever* produce float overflow, but this would produce NaNs too:
+        MANGOS_ASSERT(dist < std::numeric_limits<float>::max());
+        // prevent NaN values which can cause BIH intersection to enter infinite loop
+        if (dist < 1e-10f)
+            continue;
+        dir /= dist;
+        rays[i] = G3D::Ray::fromOriginAndDirection(source, dir);
+        maxDist[i] = dist;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            // Keep the slab test free of NaNs for rays parallel to an axis
+            float d = dir[axis];
+            if (fabs(d) < 1e-20f)
+                d = d < 0.0f ? -1e-20f : 1e-20f;
+            invDir[axis][i] = 1.0f / d;
+        }
+        pending[i] = true;
+        ++remaining;
+    }
+
+    for (uint32 entry : candidates)
+    {
+        if (!remaining)
+            break;
+
+        G3D::AABox const& bounds = iTreeValues[entry].getBounds();
+        for (uint32 base = 0; base < padded; base += 4)
+        {
+            uint32 mask = 0;
+#ifdef VMAP_LOS_SSE2
+            __m128 tNear = _mm_setzero_ps();
+            __m128 tFar = _mm_loadu_ps(&maxDist[base]);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                __m128 origin = _mm_set1_ps(source[axis]);
+                __m128 inv = _mm_loadu_ps(&invDir[axis][base]);
+                __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bounds.low()[axis]), origin), inv);
+                __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bounds.high()[axis]), origin), inv);
+                tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+                tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+            }
+            mask = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+#else
+            for (uint32 lane = 0; lane < 4; ++lane)
+            {
+                uint32 i = base + lane;
+                float tNear = 0.0f;
+                float tFar = maxDist[i];
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    float t1 = (bounds.low()[axis] - source[axis]) * invDir[axis][i];
+                    float t2 = (bounds.high()[axis] - source[axis]) * invDir[axis][i];
+                    tNear = std::max(tNear, std::min(t1, t2));
+                    tFar = std::min(tFar, std::max(t1, t2));
+                }
+                if (tNear <= tFar)
+                    mask |= 1 << lane;
+            }
+#endif
+            for (uint32 lane = 0; mask; ++lane, mask >>= 1)
+            {
+                uint32 i = base + lane;
+                if (!(mask & 1) || !pending[i])
+                    continue;
+
+                float distance = maxDist[i];
+                if (iTreeValues[entry].intersectRay(rays[i], distance, true))
+                {
+                    results[i] = false;
+                    pending[i] = false;
+                    --remaining;
+                }
+            }
+        }
+    }
+}
+//=========================================================
 /**
 When moving from pos1 to pos2 check if we hit an object. Return true and the position if we hit one
 Return the hit pos or the original dest pos
@@ -21,6 +21,7 @@
 
 #include "Platform/Define.h"
 #include <unordered_map>
+#include <vector>
 #include "BIH.h"
 
 namespace VMAP
@@ -69,6 +70,7 @@ namespace VMAP
             ~StaticMapTree();
 
             bool isInLineOfSight(const G3D::Vector3& pos1, const G3D::Vector3& pos2) const;
+            void isInLineOfSight(const G3D::Vector3& source, std::vector<G3D::Vector3> const& targets, std::vector<bool>& results) const;
             ModelInstance* FindCollisionModel(const G3D::Vector3& pos1, const G3D::Vector3& pos2);
             bool getObjectHitPos(const G3D::Vector3& pos1, const G3D::Vector3& pos2, G3D::Vector3& pResultHitPos, float pModifyDist) const;
             float getHeight(const G3D::Vector3& pPos, float maxSearchDist) const;
@@ -33,7 +33,7 @@ namespace VMAP
 
 //=========================================================
 
-VMapManager2::VMapManager2()
+VMapManager2::VMapManager2() : m_losRecordLeft(0), m_losRecordFile(nullptr)
 {
 }
 
@@ -41,6 +41,7 @@ VMapManager2::VMapManager2()
 
 VMapManager2::~VMapManager2(void)
 {
+    stopLoSRecording();
     for (InstanceTreeMap::iterator i = iInstanceMapTrees.begin(); i != iInstanceMapTrees.end(); ++i)
         delete i->second;
     for (ModelFileMap::iterator i = iLoadedModelFiles.begin(); i != iLoadedModelFiles.end(); ++i)
@@ -138,6 +139,11 @@ void VMapManager2::unloadMap(unsigned int  pMapId, int x, int y)
 bool VMapManager2::isInLineOfSight(unsigned int pMapId, float x1, float y1, float z1, float x2, float y2, float z2)
 {
     if (!isLineOfSightCalcEnabled()) return true;
+    if (m_losRecordLeft)
+    {
+        Vector3 target(x2, y2, z2);
+        recordLoSQuery(pMapId, x1, y1, z1, &target, 1);
+    }
     bool result = true;
     InstanceTreeMap::iterator instanceTree = iInstanceMapTrees.find(pMapId);
     if (instanceTree != iInstanceMapTrees.end())
@@ -149,6 +155,73 @@ bool VMapManager2::isInLineOfSight(unsigned int pMapId, float x1, float y1, floa
     }
     return result;
 }
+
+void VMapManager2::isInLineOfSight(unsigned int pMapId, float x, float y, float z, std::vector<Vector3> const& targets, std::vector<bool>& results)
+{
+    results.assign(targets.size(), true);
+    if (!isLineOfSightCalcEnabled() || targets.empty())
+        return;
+    if (m_losRecordLeft)
+        recordLoSQuery(pMapId, x, y, z, targets.data(), targets.size());
+
+    InstanceTreeMap::iterator instanceTree = iInstanceMapTrees.find(pMapId);
+    if (instanceTree == iInstanceMapTrees.end())
+        return;
+
+    Vector3 source = convertPositionToInternalRep(x, y, z);
+    std::vector<Vector3> internalTargets;
+    internalTargets.reserve(targets.size());
+    for (Vector3 const& target : targets)
+        internalTargets.push_back(convertPositionToInternalRep(target.x, target.y, target.z));
+    instanceTree->second->isInLineOfSight(source, internalTargets, results);
+}
+
+//=========================================================
+/**
+Query file format, repeated: uint32 mapId, uint32 count, float source[3], float targets[count][3].
+Positions are in world coordinates.
+*/
+
+bool VMapManager2::startLoSRecording(const char* filename, uint32 maxQueries)
+{
+    std::lock_guard<std::mutex> guard(m_losRecordLock);
+    if (m_losRecordFile)
+        fclose(m_losRecordFile);
+    m_losRecordFile = fopen(filename, "wb");
+    m_losRecordLeft = m_losRecordFile ? maxQueries : 0;
+    return m_losRecordFile != nullptr;
+}
+
+void VMapManager2::stopLoSRecording()
+{
+    std::lock_guard<std::mutex> guard(m_losRecordLock);
+    m_losRecordLeft = 0;
+    if (m_losRecordFile)
+        fclose(m_losRecordFile);
+    m_losRecordFile = nullptr;
+}
+
+void VMapManager2::recordLoSQuery(unsigned int pMapId, float x, float y, float z, Vector3 const* targets, uint32 count)
+{
+    std::lock_guard<std::mutex> guard(m_losRecordLock);
+    if (!m_losRecordFile || !m_losRecordLeft)
+        return;
+
+    uint32 mapId = pMapId;
+    float source[3] = { x, y, z };
+    fwrite(&mapId, sizeof(uint32), 1, m_losRecordFile);
+    fwrite(&count, sizeof(uint32), 1, m_losRecordFile);
+    fwrite(source, sizeof(float), 3, m_losRecordFile);
+    for (uint32 i = 0; i < count; ++i)
+        fwrite(&targets[i].x, sizeof(float), 3, m_losRecordFile);
+
+    if (!--m_losRecordLeft)
+    {
+        fclose(m_losRecordFile);
+        m_losRecordFile = nullptr;
+    }
+}
+
 ModelInstance* VMapManager2::FindCollisionModel(unsigned int mapId, float x0, float y0, float z0, float x1, float y1, float z1)
 {
     if (!isLineOfSightCalcEnabled()) return NULL;
@@ -25,6 +25,8 @@
 #include <G3D/Vector3.h>
 #include <ace/RW_Thread_Mutex.h>
 #include <ace/Atomic_Op.h>
+#include <atomic>
+#include <mutex>
 
 //===========================================================
 
@@ -76,6 +78,12 @@ namespace VMAP
             /* void _unloadMap(uint32 pMapId, uint32 x, uint32 y); */
 
             ACE_RW_Mutex    m_modelsLock;
+
+            void recordLoSQuery(unsigned int pMapId, float x, float y, float z, G3D::Vector3 const* targets, uint32 count);
+
+            std::atomic<uint32> m_losRecordLeft;                // queries still to record, 0 when not recording
+            std::mutex m_losRecordLock;
+            FILE* m_losRecordFile;
         public:
             // public for debug
             G3D::Vector3 convertPositionToInternalRep(float x, float y, float z) const;
@@ -90,6 +98,9 @@ namespace VMAP
             void unloadMap(unsigned int pMapId) override;
 
             bool isInLineOfSight(unsigned int pMapId, float x1, float y1, float z1, float x2, float y2, float z2) override;
+            void isInLineOfSight(unsigned int pMapId, float x, float y, float z, std::vector<G3D::Vector3> const& targets, std::vector<bool>& results) override;
+            bool startLoSRecording(const char* filename, uint32 maxQueries) override;
+            void stopLoSRecording() override;
             ModelInstance* FindCollisionModel(unsigned int mapId, float x0, float y0, float z0, float x1, float y1, float z1);
             /**
             fill the hit pos and return true, if an object was hit
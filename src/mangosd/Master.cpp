@@ -583,6 +583,7 @@ bool StartDB(std::string name, DatabaseType& database, const char **migrations)
         sLog.outError("Cannot connect to world database %s", name.c_str());
         return false;
     }
+    database.SetAsyncQueueSoftLimit(sConfig.GetIntDefault((name + "Database.QueueSoftLimit").c_str(), 0));
 
     if (!database.CheckRequiredMigrations(migrations))
         return false;
@@ -24,71 +24,66 @@
 #include <string.h>
 
 #include "DBCFileLoader.h"
+#include "ace/Mem_Map.h"
+#include "ace/OS_NS_unistd.h"
+
+#define DBC_HEADER_SIZE 20                                  // magic, records, fields, record size, strings size
 
 DBCFileLoader::DBCFileLoader()
 {
     data = NULL;
     fieldsOffset = NULL;
+    mappedFile = NULL;
 }
 
 bool DBCFileLoader::Load(const char *filename, const char *fmt)
 {
+    Unload();
 
-    uint32 header;
-    if(data)
-    {
-        delete [] data;
-        data=NULL;
-    }
-
-    FILE * f=fopen(filename,"rb");
-    if(!f)return false;
-
-    if(fread(&header,4,1,f)!=1)                             // Number of records
-    {
-        fclose(f);
+    if(ACE_OS::access(filename, R_OK) == -1)
         return false;
-    }
 
-    EndianConvert(header);
-    if(header!=0x43424457)
+    // Private writable mapping: pages stay shared with the file cache until something writes in them
+    mappedFile = new ACE_Mem_Map();
+    if(mappedFile->map(filename, static_cast<size_t>(-1), O_RDONLY, ACE_DEFAULT_FILE_PERMS, PROT_READ | PROT_WRITE, ACE_MAP_PRIVATE) == -1)
     {
-        fclose(f);
-        return false;                                       //'WDBC'
-    }
-
-    if(fread(&recordCount,4,1,f)!=1)                        // Number of records
-    {
-        fclose(f);
+        delete mappedFile;
+        mappedFile = NULL;
         return false;
     }
+    // Only the mapping is kept, the descriptor is not needed anymore
+    mappedFile->close_handle();
 
-    EndianConvert(recordCount);
-
-    if(fread(&fieldCount,4,1,f)!=1)                         // Number of fields
+    size_t fileSize = mappedFile->size();
+    unsigned char* file = static_cast<unsigned char*>(mappedFile->addr());
+    if(fileSize < DBC_HEADER_SIZE)
     {
-        fclose(f);
+        Unload();
         return false;
     }
 
-    EndianConvert(fieldCount);
+    uint32 header[DBC_HEADER_SIZE / 4];
+    memcpy(header, file, DBC_HEADER_SIZE);
+    for(uint32 i = 0; i < DBC_HEADER_SIZE / 4; ++i)
+        EndianConvert(header[i]);
 
-    if(fread(&recordSize,4,1,f)!=1)                         // Size of a record
+    if(header[0]!=0x43424457)                               //'WDBC'
     {
-        fclose(f);
+        Unload();
         return false;
     }
 
-    EndianConvert(recordSize);
+    recordCount = header[1];                                // Number of records
+    fieldCount = header[2];                                 // Number of fields
+    recordSize = header[3];                                 // Size of a record
+    stringSize = header[4];                                 // String size
 
-    if(fread(&stringSize,4,1,f)!=1)                         // String size
+    if(uint64(recordSize)*recordCount+stringSize > fileSize - DBC_HEADER_SIZE)
     {
-        fclose(f);
+        Unload();
         return false;
     }
 
-    EndianConvert(stringSize);
-
     fieldsOffset = new uint32[fieldCount];
     fieldsOffset[0] = 0;
     for(uint32 i = 1; i < fieldCount; i++)
@@ -100,25 +95,35 @@ bool DBCFileLoader::Load(const char *filename, const char *fmt)
             fieldsOffset[i] += 4;
     }
 
-    data = new unsigned char[recordSize*recordCount+stringSize];
+    data = file + DBC_HEADER_SIZE;
     stringTable = data + recordSize*recordCount;
-
-    if(fread(data,recordSize*recordCount+stringSize,1,f)!=1)
-    {
-        fclose(f);
-        return false;
-    }
-
-    fclose(f);
     return true;
 }
 
+void DBCFileLoader::Unload()
+{
+    delete [] fieldsOffset;
+    fieldsOffset = NULL;
+    CloseMappedFile(mappedFile);
+    mappedFile = NULL;
+    data = NULL;
+}
+
 DBCFileLoader::~DBCFileLoader()
 {
-    if(data)
-        delete [] data;
-    if(fieldsOffset)
-        delete [] fieldsOffset;
+    Unload();
+}
+
+ACE_Mem_Map* DBCFileLoader::ReleaseMappedFile()
+{
+    ACE_Mem_Map* released = mappedFile;
+    mappedFile = NULL;
+    return released;
+}
+
+void DBCFileLoader::CloseMappedFile(ACE_Mem_Map* mappedFile)
+{
+    delete mappedFile;
 }
 
 DBCFileLoader::Record DBCFileLoader::getRecord(size_t id)
@@ -265,13 +270,10 @@ char* DBCFileLoader::AutoProduceData(const char* format, uint32& records, char**
     return dataTable;
 }
 
-char* DBCFileLoader::AutoProduceStrings(const char* format, char* dataTable)
+bool DBCFileLoader::AutoProduceStrings(const char* format, char* dataTable)
 {
-    if(strlen(format)!=fieldCount)
-        return NULL;
-
-    char* stringPool= new char[stringSize];
-    memcpy(stringPool,stringTable,stringSize);
+    if(strlen(format)!=fieldCount || !dataTable)
+        return false;
 
     uint32 offset=0;
 
@@ -297,8 +299,7 @@ char* DBCFileLoader::AutoProduceStrings(const char* format, char* dataTable)
                     char** slot = (char**)(&dataTable[offset]);
                     if(!*slot || !**slot)
                     {
-                        const char * st = getRecord(y).getString(x);
-                        *slot=stringPool+(st-(const char*)stringTable);
+                        *slot=const_cast<char*>(getRecord(y).getString(x));
                     }
                     offset += sizeof(char*);
                     break;
@@ -317,5 +318,5 @@ char* DBCFileLoader::AutoProduceStrings(const char* format, char* dataTable)
         }
     }
 
-    return stringPool;
+    return true;
 }
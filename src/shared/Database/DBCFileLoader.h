@@ -25,6 +25,8 @@
 #include "Utilities/ByteConverter.h"
 #include <cassert>
 
+class ACE_Mem_Map;
+
 enum FieldFormat
 {
     FT_NA = 'x',                                            // ignore/ default, 4 byte size, in Source String means field is ignored, in Dest String means field is filled with default value
@@ -47,6 +49,7 @@ class DBCFileLoader
         DBCFileLoader();
         ~DBCFileLoader();
 
+        // The file is mapped in memory, not read: records and strings are paged in when accessed
         bool Load(const char *filename, const char *fmt);
 
         class Record
@@ -98,9 +101,17 @@ class DBCFileLoader
         uint32 GetOffset(size_t id) const { return (fieldsOffset != NULL && id < fieldCount) ? fieldsOffset[id] : 0; }
         bool IsLoaded() {return (data!=NULL);}
         char* AutoProduceData(const char* fmt, uint32& count, char**& indexTable);
-        char* AutoProduceStrings(const char* fmt, char* dataTable);
+        // Strings are pointed in the mapped file, it must be kept with ReleaseMappedFile as long as they are used
+        bool AutoProduceStrings(const char* fmt, char* dataTable);
         static uint32 GetFormatRecordSize(const char * format, int32 * index_pos = NULL);
+
+        // Gives the ownership of the mapped file to the caller, to be freed with CloseMappedFile
+        ACE_Mem_Map* ReleaseMappedFile();
+        static void CloseMappedFile(ACE_Mem_Map* mappedFile);
     private:
+        void Unload();
+
+        ACE_Mem_Map* mappedFile;
 
         uint32 recordSize;
         uint32 recordCount;
@@ -27,7 +27,7 @@
 template<class T>
 class DBCStorage
 {
-    typedef std::list<char*> StringPoolList;
+    typedef std::list<ACE_Mem_Map*> MappedFileList;
     public:
         explicit DBCStorage(const char *f) : nCount(0), fieldCount(0), fmt(f), indexTable(NULL), m_dataTable(NULL) { }
         ~DBCStorage() { Clear(); }
@@ -51,11 +51,14 @@ class DBCStorage
             // load raw non-string data
             m_dataTable = (T*)dbc.AutoProduceData(fmt,nCount,(char**&)indexTable);
 
-            // load strings from dbc data
-            m_stringPoolList.push_back(dbc.AutoProduceStrings(fmt,(char*)m_dataTable));
-
             // error in dbc file at loading if NULL
-            return indexTable!=NULL;
+            if(!indexTable)
+                return false;
+
+            // strings point into the file, it stays mapped until Clear()
+            dbc.AutoProduceStrings(fmt,(char*)m_dataTable);
+            m_mappedFiles.push_back(dbc.ReleaseMappedFile());
+            return true;
         }
 
         bool LoadStringsFrom(char const* fn)
@@ -69,8 +72,9 @@ class DBCStorage
             if(!dbc.Load(fn, fmt))
                 return false;
 
-            // load strings from another locale dbc data
-            m_stringPoolList.push_back(dbc.AutoProduceStrings(fmt,(char*)m_dataTable));
+            // load strings from another locale dbc data, the file stays mapped until Clear()
+            if(dbc.AutoProduceStrings(fmt,(char*)m_dataTable))
+                m_mappedFiles.push_back(dbc.ReleaseMappedFile());
 
             return true;
         }
@@ -85,10 +89,10 @@ class DBCStorage
             delete[] ((char*)m_dataTable);
             m_dataTable = NULL;
 
-            while(!m_stringPoolList.empty())
+            while(!m_mappedFiles.empty())
             {
-                delete[] m_stringPoolList.front();
-                m_stringPoolList.pop_front();
+                DBCFileLoader::CloseMappedFile(m_mappedFiles.front());
+                m_mappedFiles.pop_front();
             }
             nCount = 0;
         }
@@ -101,7 +105,7 @@ class DBCStorage
         char const* fmt;
         T** indexTable;
         T* m_dataTable;
-        StringPoolList m_stringPoolList;
+        MappedFileList m_mappedFiles;
 };
 
 #endif
@@ -138,6 +138,7 @@ bool SqlConnection::ExecuteStmt(int nIndex, const SqlStmtParameters& id )
 Database::~Database()
 {
     StopServer();
+    delete m_delayQueue;
 }
 
 bool Database::Initialize(const char * infoString, int nConns /*= 1*/, int nWorkers)
@@ -186,7 +187,6 @@ bool Database::Initialize(const char * infoString, int nConns /*= 1*/, int nWork
     m_numAsyncWorkers = nWorkers;
     m_threadsBodies   = new SqlDelayThread*[m_numAsyncWorkers];
     m_delayThreads    = new ACE_Based::Thread*[m_numAsyncWorkers];
-    m_serialDelayQueue = new SqlQueue*[m_numAsyncWorkers];
     for (int i = 0; i < nWorkers; ++i)
         if (!InitDelayThread(i, infoString))
             return false;
@@ -231,8 +231,6 @@ bool Database::InitDelayThread(int i, std::string const& infoString)
     m_threadsBodies[i]->incReference();
     m_delayThreads[i] = new ACE_Based::Thread(m_threadsBodies[i]);
 
-    m_serialDelayQueue[i] = new SqlQueue();
-
     return true;
 }
 
@@ -250,11 +248,8 @@ void Database::HaltDelayThread()
     }
     delete[] m_threadsBodies;
     delete[] m_delayThreads;
-    if (m_serialDelayQueue)
-        delete[] m_serialDelayQueue;
     m_delayThreads = NULL;
     m_threadsBodies = NULL;
-    m_serialDelayQueue = NULL;
     m_numAsyncWorkers = 0;
 }
 
@@ -405,7 +400,7 @@ bool Database::Execute(const char *sql)
     if(pTrans)
     {
         //add SQL request to trans queue
-        pTrans->DelayExecute(new SqlPlainRequest(sql));
+        pTrans->DelayExecute(new SqlPlainRequest(sql), strlen(sql));
     }
     else
     {
@@ -486,6 +481,22 @@ uint32 Database::GetTransactionSerialId()
     return 0;
 }
 
+size_t Database::GetTransactionStatementsCount()
+{
+    if (SqlTransaction *trans = m_TransStorage->get())
+        return trans->GetStatementsCount();
+
+    return 0;
+}
+
+size_t Database::GetTransactionBytes()
+{
+    if (SqlTransaction *trans = m_TransStorage->get())
+        return trans->GetBytes();
+
+    return 0;
+}
+
 bool Database::CommitTransaction()
 {
     if (!m_pAsyncConn)
@@ -542,35 +553,7 @@ bool Database::RollbackTransaction()
 
 void Database::AddToSerialDelayQueue(SqlOperation *op)
 {
-    if (op->GetSerialId() == 0 || m_numAsyncWorkers == 0)
-    {
-        AddToDelayQueue(op);
-        return;
-    }
-
-    // This is a very naive way of doing this. No load balancing.
-    // TODO: Load balance, must maintain mapping of serial ID so queries are
-    // executed sequentially, however
-    int worker = op->GetSerialId() % m_numAsyncWorkers;
-    m_serialDelayQueue[worker]->add(op);
-}
-
-bool Database::NextSerialDelayedOperation(int workerId, SqlOperation*& op)
-{
-    if (workerId >= m_numAsyncWorkers)
-        return false;
-
-    return m_serialDelayQueue[workerId]->next(op);
-}
-
-bool Database::HasAsyncQuery()
-{
-    bool hasQuery = !m_delayQueue->empty_unsafe();
-
-    for (int i = 0; i < m_numAsyncWorkers && m_serialDelayQueue && !hasQuery; ++i)
-        hasQuery = !m_serialDelayQueue[i]->empty_unsafe();
-
-    return hasQuery;
+    m_delayQueue->Add(op, op->GetSerialId());
 }
 
 bool Database::CheckRequiredMigrations(const char **migrations)
@@ -640,7 +623,7 @@ bool Database::ExecuteStmt(const SqlStatementID& id, SqlStmtParameters * params)
     if(pTrans)
     {
         //add SQL request to trans queue
-        pTrans->DelayExecute(new SqlPreparedRequest(id.ID(), params));
+        pTrans->DelayExecute(new SqlPreparedRequest(id.ID(), params), params->dataSize());
     }
     else
     {
@@ -655,6 +638,20 @@ bool Database::ExecuteStmt(const SqlStatementID& id, SqlStmtParameters * params)
     return true;
 }
 
+bool Database::ExecuteStmtBatched(const SqlStatementID& id, SqlStmtParameters * params)
+{
+    if (!m_pAsyncConn)
+        return false;
+
+    //rows are only merged inside of transactions
+    SqlTransaction * pTrans = m_TransStorage->get();
+    if (!pTrans)
+        return ExecuteStmt(id, params);
+
+    pTrans->DelayExecuteBatched(id.ID(), params, params->dataSize());
+    return true;
+}
+
 bool Database::DirectExecuteStmt( const SqlStatementID& id, SqlStmtParameters * params )
 {
     MANGOS_ASSERT(params);
@@ -709,6 +706,54 @@ std::string Database::GetStmtString(const int stmtId) const
     return std::string();
 }
 
+int Database::GetBatchedStmtIndex(const int stmtId, uint32 rows)
+{
+    LOCK_GUARD _guard(m_stmtGuard);
+
+    BatchedStmtRegistry::const_iterator batched = m_batchedStmtRegistry.find(std::make_pair(stmtId, rows));
+    if (batched != m_batchedStmtRegistry.end())
+        return batched->second;
+
+    std::string fmt;
+    for (PreparedStmtRegistry::const_iterator iter = m_stmtRegistry.begin(); iter != m_stmtRegistry.end(); ++iter)
+    {
+        if (iter->second == stmtId)
+        {
+            fmt = iter->first;
+            break;
+        }
+    }
+
+    //only "INSERT/REPLACE ... VALUES (?, ...)" with nothing after the values list can be merged
+    int nId = -1;
+    std::string upper(fmt);
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    size_t valuesPos = upper.rfind("VALUES");
+    size_t open = upper.find('(', valuesPos);
+    size_t close = upper.find_last_not_of(" \t\r\n");
+    if ((upper.compare(0, 6, "INSERT") == 0 || upper.compare(0, 7, "REPLACE") == 0) &&
+        valuesPos != std::string::npos && open != std::string::npos && close != std::string::npos && upper[close] == ')' &&
+        upper.find_first_not_of("?, \t", open + 1) == close)
+    {
+        std::string tuple = fmt.substr(open, close - open + 1);
+        std::string batchedFmt = fmt.substr(0, open) + tuple;
+        for (uint32 i = 1; i < rows; ++i)
+            batchedFmt += ", " + tuple;
+
+        PreparedStmtRegistry::const_iterator iter = m_stmtRegistry.find(batchedFmt);
+        if (iter == m_stmtRegistry.end())
+        {
+            nId = ++m_iStmtIndex;
+            m_stmtRegistry[batchedFmt] = nId;
+        }
+        else
+            nId = iter->second;
+    }
+
+    m_batchedStmtRegistry[std::make_pair(stmtId, rows)] = nId;
+    return nId;
+}
+
 //HELPER CLASSES AND FUNCTIONS
 Database::TransHelper::~TransHelper()
 {
@@ -24,7 +24,9 @@
 
 #include "Threading.h"
 #include <unordered_map>
+#include <map>
 #include "Database/SqlDelayThread.h"
+#include "Database/SqlDelayQueue.h"
 #include <ace/Recursive_Thread_Mutex.h>
 #include "Policies/ThreadingModel.h"
 #include <ace/TSS_T.h>
@@ -226,6 +228,9 @@ class MANGOS_DLL_SPEC Database
         bool BeginTransaction(uint32 serialId = 0);
         bool InTransaction();
         uint32 GetTransactionSerialId();
+        //statements queued in the transaction of the current thread, and their size
+        size_t GetTransactionStatementsCount();
+        size_t GetTransactionBytes();
         bool CommitTransaction();
         bool RollbackTransaction();
         //for sync transaction execution
@@ -237,6 +242,9 @@ class MANGOS_DLL_SPEC Database
         SqlStatement CreateStatement(SqlStatementID& index, const char * fmt);
         //get prepared statement format string
         std::string GetStmtString(const int stmtId) const;
+        //get the index of the statement inserting 'rows' rows at once for an INSERT/REPLACE ... VALUES (...) statement
+        //returns -1 if the statement has another form
+        int GetBatchedStmtIndex(int stmtId, uint32 rows);
 
         operator bool () const { return m_pQueryConnections.size() && m_pAsyncConn != 0; }
 
@@ -261,24 +269,35 @@ class MANGOS_DLL_SPEC Database
         //you should call it explicitly after your server successfully started up
         //NO ASYNC TRANSACTIONS DURING SERVER STARTUP - ONLY DURING RUNTIME!!!
         void AllowAsyncTransactions() { m_bAllowAsyncTransactions = true; }
-        inline void AddToDelayQueue(SqlOperation* op) { m_delayQueue->add(op); }
-        inline bool NextDelayedOperation(SqlOperation*& op) { return m_delayQueue->next(op); }
-
-        inline void AddToSerialDelayQueue(int workerId, SqlOperation *op) { m_serialDelayQueue[workerId]->add(op); }
-        bool NextSerialDelayedOperation(int workerId, SqlOperation*& op);
-
-        bool HasAsyncQuery();
-
+        inline void AddToDelayQueue(SqlOperation* op) { m_delayQueue->Add(op, 0); }
+        //operations with the same serial ID are executed in order, one at a time
         void AddToSerialDelayQueue(SqlOperation *op);
+        //executes the next queued operation on the given connection, called by the async workers
+        bool ExecuteDelayedOperation(SqlConnection* conn, uint32 waitMs) { return m_delayQueue->ExecuteNext(conn, waitMs); }
+        uint32 GetAsyncWorkersCount() const { return m_numAsyncWorkers; }
+
+        bool HasAsyncQuery() { return !m_delayQueue->Empty(); }
+
+        //async queue backlog, producers are expected to postpone deferrable work while it is overloaded
+        size_t GetAsyncQueueSize() const { return m_delayQueue->GetSize(); }
+        void SetAsyncQueueSoftLimit(size_t limit) { m_delayQueue->SetSoftLimit(limit); }
+        size_t GetAsyncQueueSoftLimit() const { return m_delayQueue->GetSoftLimit(); }
+        bool IsAsyncQueueOverloaded() const { return m_delayQueue->IsOverloaded(); }
+        // Transactions rolled back since startup, their changes are lost
+        uint32 GetFailedTransactionsCount() const { return m_nFailedTransactions.value(); }
+        void OnTransactionFailed() { ++m_nFailedTransactions; }
+        void GetAsyncQueueStats(SqlDelayQueue::Stats& stats) const { m_delayQueue->GetStats(stats); }
+        void ResetAsyncQueueStats() { m_delayQueue->ResetStats(); }
 
         // Frees data, cancels scheduled queries, closes connection
         void StopServer();
     protected:
         Database() : m_pAsyncConn(NULL), m_pResultQueue(NULL), m_threadsBodies(NULL), m_delayThreads(NULL), m_numAsyncWorkers(0),
-            m_serialDelayQueue(NULL), m_delayQueue(new SqlQueue()), m_logSQL(false), m_pingIntervallms(0), m_nQueryConnPoolSize(1),
+            m_delayQueue(new SqlDelayQueue()), m_logSQL(false), m_pingIntervallms(0), m_nQueryConnPoolSize(1),
             m_bAllowAsyncTransactions(false), m_iStmtIndex(-1)
         {
             m_nQueryCounter = -1;
+            m_nFailedTransactions = 0;
         }
 
         //factory method to create SqlConnection objects
@@ -320,18 +339,19 @@ class MANGOS_DLL_SPEC Database
         //PREPARED STATEMENT API
         //query function for prepared statements
         bool ExecuteStmt(const SqlStatementID& id, SqlStmtParameters * params);
+        bool ExecuteStmtBatched(const SqlStatementID& id, SqlStmtParameters * params);
         bool DirectExecuteStmt(const SqlStatementID& id, SqlStmtParameters * params);
 
         //connection helper counters
         int m_nQueryConnPoolSize;                               //current size of query connection pool
         ACE_Atomic_Op<ACE_Thread_Mutex, int> m_nQueryCounter;  //counter for connection selection
+        ACE_Atomic_Op<ACE_Thread_Mutex, uint32> m_nFailedTransactions;
 
         //lets use pool of connections for sync queries
         typedef std::vector< SqlConnection * > SqlConnectionContainer;
         SqlConnectionContainer m_pQueryConnections;
 
-        SqlQueue* m_delayQueue;
-        SqlQueue** m_serialDelayQueue; // simple mapping for worker ID -> serialized queue (only executed in set worker thread)
+        SqlDelayQueue* m_delayQueue;                        ///< async operations, shared by all workers
 
         SqlConnection * m_pAsyncConn;
 
@@ -351,6 +371,9 @@ class MANGOS_DLL_SPEC Database
         typedef std::unordered_map<std::string, int> PreparedStmtRegistry;
         PreparedStmtRegistry m_stmtRegistry;                 ///<
 
+        typedef std::map<std::pair<int, uint32>, int> BatchedStmtRegistry;
+        BatchedStmtRegistry m_batchedStmtRegistry;           ///< (statement, rows) -> multi-row statement
+
         int m_iStmtIndex;
 
     private:
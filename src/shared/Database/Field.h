@@ -37,8 +37,8 @@ class Field
             DB_TYPE_BOOL    = 0x04
         };
 
-        Field() : mValue(NULL), mType(DB_TYPE_UNKNOWN) {}
-        Field(const char* value, enum DataTypes type) : mValue(value), mType(type) {}
+        Field() : mValue(NULL), mType(DB_TYPE_UNKNOWN), mInteger(0) {}
+        Field(const char* value, enum DataTypes type) : mType(type) { SetValue(value); }
 
         ~Field() {}
 
@@ -51,14 +51,17 @@ class Field
             return mValue ? mValue : "";                    // std::string s = 0 have undefine result in C++
         }
         float GetFloat() const { return mValue ? static_cast<float>(atof(mValue)) : 0.0f; }
-        bool GetBool() const { return mValue ? atoi(mValue) > 0 : false; }
-        int32 GetInt32() const { return mValue ? static_cast<int32>(atol(mValue)) : int32(0); }
-        uint8 GetUInt8() const { return mValue ? static_cast<uint8>(atol(mValue)) : uint8(0); }
-        uint16 GetUInt16() const { return mValue ? static_cast<uint16>(atol(mValue)) : uint16(0); }
-        int16 GetInt16() const { return mValue ? static_cast<int16>(atol(mValue)) : int16(0); }
-        uint32 GetUInt32() const { return mValue ? static_cast<uint32>(atol(mValue)) : uint32(0); }
+        bool GetBool() const { return mType == DB_TYPE_INTEGER ? mInteger > 0 : (mValue ? atoi(mValue) > 0 : false); }
+        int32 GetInt32() const { return static_cast<int32>(GetInteger()); }
+        uint8 GetUInt8() const { return static_cast<uint8>(GetInteger()); }
+        uint16 GetUInt16() const { return static_cast<uint16>(GetInteger()); }
+        int16 GetInt16() const { return static_cast<int16>(GetInteger()); }
+        uint32 GetUInt32() const { return static_cast<uint32>(GetInteger()); }
         uint64 GetUInt64() const
         {
+            if (mType == DB_TYPE_INTEGER)
+                return uint64(mInteger);
+
             uint64 value = 0;
             if(!mValue || sscanf(mValue,UI64FMTD,&value) == -1)
                 return 0;
@@ -69,13 +72,38 @@ class Field
         void SetType(enum DataTypes type) { mType = type; }
         //no need for memory allocations to store resultset field strings
         //all we need is to cache pointers returned by different DBMS APIs
-        void SetValue(const char* value) { mValue = value; };
+        //integer columns are decoded once here, the getters then only cast
+        void SetValue(const char* value)
+        {
+            mValue = value;
+            mInteger = (mType == DB_TYPE_INTEGER && value) ? ParseInteger(value) : 0;
+        }
 
     private:
         Field(Field const&);
         Field& operator=(Field const&);
 
+        int64 GetInteger() const
+        {
+            if (mType == DB_TYPE_INTEGER)
+                return mInteger;
+            return mValue ? int64(atol(mValue)) : 0;
+        }
+
+        // Values come from the database in plain decimal, without the locale and whitespace handling of atol
+        static int64 ParseInteger(const char* str)
+        {
+            bool negative = *str == '-';
+            if (negative || *str == '+')
+                ++str;
+            uint64 value = 0;
+            for (; uint8(*str - '0') < 10; ++str)
+                value = value * 10 + uint8(*str - '0');
+            return int64(negative ? 0 - value : value);
+        }
+
         const char* mValue;
         enum DataTypes mType;
+        int64 mInteger;
 };
 #endif
@@ -17,6 +17,12 @@
  */
 
 #include "SQLStorage.h"
+#include "Log.h"
+#include "ace/Mem_Map.h"
+#include "ace/OS_NS_stdio.h"
+#include "ace/OS_NS_unistd.h"
+#include <chrono>
+#include <fstream>
 
 // -----------------------------------  SQLStorageBase  ---------------------------------------- //
 
@@ -120,18 +126,133 @@ void SQLStorageBase::Free()
     m_recordCount = 0;
 }
 
+// -----------------------------------  SQLStorageIndex  --------------------------------------- //
+
+void SQLStorageIndex::Init(uint32 maxEntry, bool sparse)
+{
+    Clear();
+    m_maxEntry = maxEntry;
+
+    if (sparse)
+    {
+        m_pagesCount = (maxEntry + INDEX_PAGE_MASK) >> INDEX_PAGE_BITS;
+        m_pages = new char** [m_pagesCount];
+        memset(m_pages, 0, m_pagesCount * sizeof(char**));
+    }
+    else
+    {
+        m_dense = new char* [maxEntry];
+        memset(m_dense, 0, maxEntry * sizeof(char*));
+    }
+}
+
+void SQLStorageIndex::Clear()
+{
+    delete[] m_dense;
+    m_dense = nullptr;
+
+    for (uint32 i = 0; i < m_pagesCount; ++i)
+        delete[] m_pages[i];
+    delete[] m_pages;
+    m_pages = nullptr;
+    m_pagesCount = 0;
+    m_usedPages = 0;
+    m_maxEntry = 0;
+}
+
+void SQLStorageIndex::Set(uint32 id, char* record)
+{
+    if (id >= m_maxEntry)
+        return;
+
+    if (m_dense)
+    {
+        m_dense[id] = record;
+        return;
+    }
+
+    char**& page = m_pages[id >> INDEX_PAGE_BITS];
+    if (!page)
+    {
+        if (!record)
+            return;
+        page = new char* [INDEX_PAGE_SIZE];
+        memset(page, 0, INDEX_PAGE_SIZE * sizeof(char*));
+        ++m_usedPages;
+    }
+    page[id & INDEX_PAGE_MASK] = record;
+}
+
+size_t SQLStorageIndex::GetMemoryUsage() const
+{
+    if (m_dense)
+        return size_t(m_maxEntry) * sizeof(char*);
+    return size_t(m_pagesCount) * sizeof(char**) + size_t(m_usedPages) * INDEX_PAGE_SIZE * sizeof(char*);
+}
+
 // -----------------------------------  SQLStorage  -------------------------------------------- //
 
 void SQLStorage::EraseEntry(uint32 id)
 {
-    m_Index[id] = nullptr;
+    m_index.Set(id, nullptr);
 }
 
 void SQLStorage::Free()
 {
     SQLStorageBase::Free();
-    delete[] m_Index;
-    m_Index = nullptr;
+    m_index.Clear();
+}
+
+static double TimeIndexLookups(SQLStorageIndex const& index, std::vector<uint32> const& ids)
+{
+    uintptr_t sum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32 id : ids)
+        sum += reinterpret_cast<uintptr_t>(index.Get(id));
+    uint64 elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    // Keeps the lookups from being optimized away
+    static volatile uintptr_t sink;
+    sink = sum;
+    return ids.empty() ? 0.0 : double(elapsedNs) / ids.size();
+}
+
+void SQLStorage::BenchmarkIndex(uint32 lookups, IndexBenchmark& result) const
+{
+    std::vector<std::pair<uint32, char*> > records;
+    records.reserve(GetRecordCount());
+    for (uint32 id = 0; id < GetMaxEntry(); ++id)
+        if (char* record = m_index.Get(id))
+            records.push_back(std::make_pair(id, record));
+
+    // Same pseudo random sequence for both layouts
+    std::vector<uint32> ids;
+    if (!records.empty())
+    {
+        ids.reserve(lookups);
+        uint32 seed = 0x9E3779B9;
+        for (uint32 i = 0; i < lookups; ++i)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            ids.push_back(records[seed % records.size()].first);
+        }
+    }
+
+    SQLStorageIndex dense, sparse;
+    dense.Init(GetMaxEntry(), false);
+    sparse.Init(GetMaxEntry(), true);
+    for (std::pair<uint32, char*> const& record : records)
+    {
+        dense.Set(record.first, record.second);
+        sparse.Set(record.first, record.second);
+    }
+
+    result.denseNs = TimeIndexLookups(dense, ids);
+    result.sparseNs = TimeIndexLookups(sparse, ids);
+    result.denseBytes = dense.GetMemoryUsage();
+    result.sparseBytes = sparse.GetMemoryUsage();
 }
 
 void SQLStorage::Load(bool error_at_empty /*= true*/)
@@ -149,13 +270,11 @@ void SQLStorage::LoadProgressive(uint32 wow_patch, std::string column_name /*= "
 SQLStorage::SQLStorage(const char* fmt, const char* _entry_field, const char* sqlname)
 {
     Initialize(sqlname, _entry_field, fmt, fmt);
-    m_Index = nullptr;
 }
 
 SQLStorage::SQLStorage(const char* src_fmt, const char* dst_fmt, const char* _entry_field, const char* sqlname)
 {
     Initialize(sqlname, _entry_field, src_fmt, dst_fmt);
-    m_Index = nullptr;
 }
 
 void SQLStorage::prepareToLoad(uint32 maxRecordId, uint32 recordCount, uint32 recordSize)
@@ -163,9 +282,8 @@ void SQLStorage::prepareToLoad(uint32 maxRecordId, uint32 recordCount, uint32 re
     // Clear (possible) old data and old index array
     Free();
 
-    // Set index array
-    m_Index = new char* [maxRecordId];
-    memset(m_Index, 0, maxRecordId * sizeof(char*));
+    // Set index array, a flat one unless the entries are very sparse
+    m_index.Init(maxRecordId, SQLStorageIndex::ShouldBeSparse(maxRecordId, recordCount));
 
     SQLStorageBase::prepareToLoad(maxRecordId, recordCount, recordSize);
 }
@@ -244,3 +362,165 @@ SQLMultiStorage::SQLMultiStorage(const char* src_fmt, const char* dst_fmt, const
 {
     Initialize(sqlname, _entry_field, src_fmt, dst_fmt);
 }
+
+// -----------------------------------  SQLStorageSnapshot  ------------------------------------ //
+
+#define SNAPSHOT_MAGIC      0x53514C53                      // 'SQLS'
+#define SNAPSHOT_VERSION    1
+#define SNAPSHOT_NULL       0xFFFFFFFF                      // length of a NULL string
+
+std::string SQLStorageSnapshot::m_directory;
+
+void SQLStorageSnapshot::SetDirectory(std::string const& directory)
+{
+    m_directory = directory;
+    if (!m_directory.empty() && m_directory[m_directory.size() - 1] != '/' && m_directory[m_directory.size() - 1] != '\\')
+        m_directory += '/';
+}
+
+std::string SQLStorageSnapshot::BuildKey(char const* tableName, std::string const& filter, char const* srcFormat)
+{
+    // The checksum changes with any modification of the rows
+    QueryResult* result = WorldDatabase.PQuery("CHECKSUM TABLE %s", tableName);
+    if (!result)
+        return "";
+
+    Field* fields = result->Fetch();
+    std::string key;
+    if (!fields[1].IsNULL())
+        key = std::string(fields[1].GetString()) + "|" + filter + "|" + srcFormat;
+    delete result;
+    return key;
+}
+
+bool SQLStorageSnapshot::Open(char const* tableName, std::string const& key)
+{
+    Close();
+
+    std::string path = GetPath(tableName);
+    if (ACE_OS::access(path.c_str(), R_OK) == -1)
+        return false;
+
+    m_mappedFile = new ACE_Mem_Map();
+    if (m_mappedFile->map(path.c_str(), static_cast<size_t>(-1), O_RDONLY, ACE_DEFAULT_FILE_PERMS, PROT_READ, ACE_MAP_PRIVATE) == -1)
+    {
+        sLog.outError("Unable to map snapshot '%s' in memory.", path.c_str());
+        Close();
+        return false;
+    }
+
+    m_readPos = static_cast<char const*>(m_mappedFile->addr());
+    m_readEnd = m_readPos + m_mappedFile->size();
+    m_corrupted = false;
+
+    if (Read<uint32>() != SNAPSHOT_MAGIC || Read<uint32>() != SNAPSHOT_VERSION)
+    {
+        Close();
+        return false;
+    }
+
+    // Outdated snapshots are silently replaced
+    uint32 keySize = Read<uint32>();
+    if (m_corrupted || keySize != key.size() || keySize > size_t(m_readEnd - m_readPos) || key.compare(0, keySize, m_readPos, keySize) != 0)
+    {
+        Close();
+        return false;
+    }
+    m_readPos += keySize;
+
+    m_maxRecordId = Read<uint32>();
+    m_recordCount = Read<uint32>();
+    if (m_corrupted)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void SQLStorageSnapshot::Close()
+{
+    delete m_mappedFile;
+    m_mappedFile = nullptr;
+    m_readPos = nullptr;
+    m_readEnd = nullptr;
+}
+
+char const* SQLStorageSnapshot::ReadString()
+{
+    uint32 length = Read<uint32>();
+    if (m_corrupted || length == SNAPSHOT_NULL)
+        return nullptr;
+
+    // Strings are stored with their terminating NUL, so they can be used in place
+    if (length >= size_t(m_readEnd - m_readPos) || m_readPos[length] != '\0')
+    {
+        m_corrupted = true;
+        return nullptr;
+    }
+
+    char const* value = m_readPos;
+    m_readPos += length + 1;
+    return value;
+}
+
+char const* SQLStorageSnapshot::Record(char const* value)
+{
+    if (!m_recording)
+        return value;
+
+    if (!value)
+    {
+        Record<uint32>(SNAPSHOT_NULL);
+        return value;
+    }
+
+    uint32 length = strlen(value);
+    Record<uint32>(length);
+    m_buffer.insert(m_buffer.end(), value, value + length + 1);
+    return value;
+}
+
+bool SQLStorageSnapshot::Save(char const* tableName, std::string const& key, uint32 maxRecordId, uint32 recordCount)
+{
+    if (!m_recording)
+        return false;
+    m_recording = false;
+
+    // Written aside then renamed, a crash never leaves a truncated snapshot behind
+    std::string path = GetPath(tableName);
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            sLog.outError("Unable to write snapshot '%s'.", tmpPath.c_str());
+            return false;
+        }
+
+        uint32 header[3] = { SNAPSHOT_MAGIC, SNAPSHOT_VERSION, uint32(key.size()) };
+        uint32 counts[2] = { maxRecordId, recordCount };
+        file.write(reinterpret_cast<char const*>(header), sizeof(header));
+        file.write(key.data(), key.size());
+        file.write(reinterpret_cast<char const*>(counts), sizeof(counts));
+        if (!m_buffer.empty())
+            file.write(&m_buffer[0], m_buffer.size());
+        if (!file)
+        {
+            sLog.outError("Unable to write snapshot '%s'.", tmpPath.c_str());
+            file.close();
+            ACE_OS::unlink(tmpPath.c_str());
+            return false;
+        }
+    }
+
+    std::vector<char>().swap(m_buffer);
+    ACE_OS::unlink(path.c_str());
+    if (ACE_OS::rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        sLog.outError("Unable to write snapshot '%s'.", path.c_str());
+        ACE_OS::unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -100,6 +100,52 @@ class SQLStorageBase
         char* m_data;
 };
 
+/**
+ * Entry to record lookup of a SQLStorage. Tables with dense entries use a flat array
+ * indexed by entry. Sparse ones use a two-level table: a top array of pages of 256
+ * entries, where only the pages holding records are allocated.
+ */
+class SQLStorageIndex
+{
+    public:
+        SQLStorageIndex() : m_maxEntry(0), m_dense(nullptr), m_pages(nullptr), m_pagesCount(0), m_usedPages(0) {}
+        ~SQLStorageIndex() { Clear(); }
+
+        // Sparse when even one page per record takes less memory than the flat array
+        static bool ShouldBeSparse(uint32 maxEntry, uint32 recordCount) { return uint64(recordCount) * INDEX_PAGE_SIZE < maxEntry; }
+
+        void Init(uint32 maxEntry, bool sparse);
+        void Clear();
+        void Set(uint32 id, char* record);
+
+        char* Get(uint32 id) const
+        {
+            if (id >= m_maxEntry)
+                return nullptr;
+            if (m_dense)
+                return m_dense[id];
+            char** page = m_pages[id >> INDEX_PAGE_BITS];
+            return page ? page[id & INDEX_PAGE_MASK] : nullptr;
+        }
+
+        bool IsSparse() const { return m_pages != nullptr; }
+        size_t GetMemoryUsage() const;
+
+    private:
+        SQLStorageIndex(SQLStorageIndex const&);
+        SQLStorageIndex& operator=(SQLStorageIndex const&);
+
+        static uint32 const INDEX_PAGE_BITS = 8;
+        static uint32 const INDEX_PAGE_SIZE = 1 << INDEX_PAGE_BITS;
+        static uint32 const INDEX_PAGE_MASK = INDEX_PAGE_SIZE - 1;
+
+        uint32 m_maxEntry;
+        char** m_dense;
+        char*** m_pages;
+        uint32 m_pagesCount;
+        uint32 m_usedPages;
+};
+
 class SQLStorage : public SQLStorageBase
 {
         template<class DerivedLoader, class StorageClass> friend class SQLStorageLoaderBase;
@@ -114,9 +160,7 @@ class SQLStorage : public SQLStorageBase
         template<class T>
         T const* LookupEntry(uint32 id) const
         {
-            if (id >= GetMaxEntry())
-                return nullptr;
-            return reinterpret_cast<T const*>(m_Index[id]);
+            return reinterpret_cast<T const*>(m_index.Get(id));
         }
 
         void Load(bool error_at_empty = true);
@@ -124,18 +168,32 @@ class SQLStorage : public SQLStorageBase
 
         void EraseEntry(uint32 id);
 
+        bool HasSparseIndex() const { return m_index.IsSparse(); }
+        size_t GetIndexMemoryUsage() const { return m_index.GetMemoryUsage(); }
+
+        struct IndexBenchmark
+        {
+            double denseNs;                                 // per lookup
+            double sparseNs;
+            size_t denseBytes;
+            size_t sparseBytes;
+        };
+
+        // Times random lookups of the existing entries with both index layouts
+        void BenchmarkIndex(uint32 lookups, IndexBenchmark& result) const;
+
     protected:
         void prepareToLoad(uint32 maxRecordId, uint32 recordCount, uint32 recordSize) override;
         void JustCreatedRecord(uint32 recordId, char* record) override
         {
-            m_Index[recordId] = record;
+            m_index.Set(recordId, record);
         }
 
         void Free() override;
 
     private:
         // Lookup access
-        char** m_Index;
+        SQLStorageIndex m_index;
 };
 
 class SQLHashStorage : public SQLStorageBase
@@ -247,6 +305,79 @@ class SQLMultiStorage : public SQLStorageBase
         RecordMultiMap m_indexMultiMap;
 };
 
+class ACE_Mem_Map;
+
+/**
+ * On-disk copy of the source values of a storage, written after loading it from
+ * the database and read back instead of the database while the source table and
+ * the query are unchanged. The values go through the loader conversions as usual,
+ * only the SQL is skipped.
+ */
+class SQLStorageSnapshot
+{
+    public:
+        SQLStorageSnapshot() : m_mappedFile(nullptr), m_readPos(nullptr), m_readEnd(nullptr), m_corrupted(false),
+            m_recording(false), m_maxRecordId(0), m_recordCount(0) {}
+        ~SQLStorageSnapshot() { Close(); }
+
+        // Snapshots are disabled while no directory is set
+        static void SetDirectory(std::string const& directory);
+        static bool IsEnabled() { return !m_directory.empty(); }
+
+        // Identifies the content of the table and how it is read, empty if it cannot be computed
+        static std::string BuildKey(char const* tableName, std::string const& filter, char const* srcFormat);
+
+        // Reading
+        bool Open(char const* tableName, std::string const& key);
+        void Close();
+        uint32 GetMaxRecordId() const { return m_maxRecordId; }
+        uint32 GetRecordCount() const { return m_recordCount; }
+        bool IsCorrupted() const { return m_corrupted; }
+
+        template<class T>
+        T Read()
+        {
+            T value = T();
+            if (sizeof(T) > size_t(m_readEnd - m_readPos))
+                m_corrupted = true;
+            else
+            {
+                memcpy(&value, m_readPos, sizeof(T));
+                m_readPos += sizeof(T);
+            }
+            return value;
+        }
+        char const* ReadString();
+
+        // Writing, values are given back so that they can be recorded while they are stored
+        void StartRecording() { m_recording = true; m_buffer.clear(); }
+        template<class T>
+        T Record(T value)
+        {
+            if (m_recording)
+                m_buffer.insert(m_buffer.end(), reinterpret_cast<char const*>(&value), reinterpret_cast<char const*>(&value) + sizeof(T));
+            return value;
+        }
+        char const* Record(char const* value);
+        bool Save(char const* tableName, std::string const& key, uint32 maxRecordId, uint32 recordCount);
+
+    private:
+        static std::string GetPath(char const* tableName) { return m_directory + tableName + ".snapshot"; }
+
+        static std::string m_directory;
+
+        ACE_Mem_Map* m_mappedFile;
+        char const* m_readPos;
+        char const* m_readEnd;
+        bool m_corrupted;
+
+        bool m_recording;
+        std::vector<char> m_buffer;
+
+        uint32 m_maxRecordId;
+        uint32 m_recordCount;
+};
+
 template <class DerivedLoader, class StorageClass>
 class SQLStorageLoaderBase
 {
@@ -274,6 +405,9 @@ class SQLStorageLoaderBase
         void convert_str_to_str(uint32 field_pos, char* src, char*& dst);
 
     private:
+        uint32 GetRecordSize(StorageClass const& store) const;
+        bool LoadSnapshot(StorageClass& store, SQLStorageSnapshot& snapshot);
+
         template<class V>
         void storeValue(V value, StorageClass& store, char* record, uint32 field_pos, uint32& offset);
         void storeValue(char const* value, StorageClass& store, char* record, uint32 field_pos, uint32& offset);
@@ -186,9 +186,125 @@ void SQLStorageLoaderBase<DerivedLoader, StorageClass>::storeValue(char const* v
     }
 }
 
+template<class DerivedLoader, class StorageClass>
+uint32 SQLStorageLoaderBase<DerivedLoader, StorageClass>::GetRecordSize(StorageClass const& store) const
+{
+    uint32 recordsize = 0;
+    for (uint32 x = 0; x < store.GetDstFieldCount(); ++x)
+    {
+        switch (store.GetDstFormat(x))
+        {
+            case FT_LOGIC:
+                recordsize += sizeof(bool);   break;
+            case FT_BYTE:
+                recordsize += sizeof(char);   break;
+            case FT_INT:
+                recordsize += sizeof(uint32); break;
+            case FT_FLOAT:
+                recordsize += sizeof(float);  break;
+            case FT_STRING:
+                recordsize += sizeof(char*);  break;
+            case FT_NA:
+                recordsize += sizeof(uint32); break;
+            case FT_NA_BYTE:
+                recordsize += sizeof(char);   break;
+            case FT_NA_FLOAT:
+                recordsize += sizeof(float);  break;
+            case FT_NA_POINTER:
+                recordsize += sizeof(char*);  break;
+            case FT_64BITINT:
+                recordsize += sizeof(uint64);  break;
+            case FT_IND:
+            case FT_SORT:
+                assert(false && "SQL storage not have sort field types");
+                break;
+            default:
+                assert(false && "unknown format character");
+                break;
+        }
+    }
+
+    return recordsize;
+}
+
+template<class DerivedLoader, class StorageClass>
+bool SQLStorageLoaderBase<DerivedLoader, StorageClass>::LoadSnapshot(StorageClass& store, SQLStorageSnapshot& snapshot)
+{
+    uint32 maxRecordId = snapshot.GetMaxRecordId();
+    uint32 recordCount = snapshot.GetRecordCount();
+    store.prepareToLoad(maxRecordId, recordCount, GetRecordSize(store));
+
+    BarGoLink bar(recordCount);
+    for (uint32 i = 0; i < recordCount; ++i)
+    {
+        bar.step();
+
+        uint32 entry = snapshot.Read<uint32>();
+        if (snapshot.IsCorrupted() || entry >= maxRecordId)
+            break;
+
+        char* record = store.createRecord(entry);
+        uint32 offset = 0;
+
+        // same walk as when loading from the database, only the values are read back from the snapshot
+        for (uint32 x = 0, y = 0; x < store.GetDstFieldCount();)
+        {
+            switch (store.GetDstFormat(x))
+            {
+                case FT_NA:         storeValue((uint32)0, store, record, x, offset);         ++x; continue;
+                case FT_NA_BYTE:    storeValue((char)0, store, record, x, offset);           ++x; continue;
+                case FT_NA_FLOAT:   storeValue((float)0.0f, store, record, x, offset);       ++x; continue;
+                case FT_NA_POINTER: storeValue((char const*)nullptr, store, record, x, offset); ++x; continue;
+                default:
+                    break;
+            }
+
+            switch (store.GetSrcFormat(y))
+            {
+                case FT_LOGIC:  storeValue(snapshot.Read<bool>(), store, record, x, offset);   ++x; break;
+                case FT_BYTE:   storeValue(snapshot.Read<char>(), store, record, x, offset);   ++x; break;
+                case FT_INT:    storeValue(snapshot.Read<uint32>(), store, record, x, offset); ++x; break;
+                case FT_FLOAT:  storeValue(snapshot.Read<float>(), store, record, x, offset);  ++x; break;
+                case FT_STRING: storeValue(snapshot.ReadString(), store, record, x, offset);   ++x; break;
+                case FT_64BITINT: storeValue(snapshot.Read<uint64>(), store, record, x, offset); ++x; break;
+                case FT_NA:
+                case FT_NA_BYTE:
+                case FT_NA_FLOAT:
+                    break;
+                default:
+                    assert(false && "unknown format character");
+            }
+            ++y;
+        }
+    }
+
+    if (snapshot.IsCorrupted() || store.GetRecordCount() != recordCount)
+    {
+        sLog.outError("Snapshot of %s is corrupted, loading it from the database.", store.GetTableName());
+        // The records read so far own their strings
+        store.Free();
+        return false;
+    }
+
+    sLog.outString("%s loaded from snapshot", store.GetTableName());
+    return true;
+}
+
 template<class DerivedLoader, class StorageClass>
 void SQLStorageLoaderBase<DerivedLoader, StorageClass>::Load(StorageClass& store, bool error_at_empty /*= true*/)
 {
+    SQLStorageSnapshot snapshot;
+    std::string snapshotKey;
+    if (SQLStorageSnapshot::IsEnabled())
+    {
+        snapshotKey = SQLStorageSnapshot::BuildKey(store.GetTableName(), "", store.GetSrcFormat());
+        if (!snapshotKey.empty() && snapshot.Open(store.GetTableName(), snapshotKey) && LoadSnapshot(store, snapshot))
+            return;
+        snapshot.Close();
+        if (!snapshotKey.empty())
+            snapshot.StartRecording();
+    }
+
     Field* fields = nullptr;
     QueryResult* result  = WorldDatabase.PQuery("SELECT MAX(%s) FROM %s", store.EntryFieldName(), store.GetTableName());
     if (!result)
@@ -200,7 +316,6 @@ void SQLStorageLoaderBase<DerivedLoader, StorageClass>::Load(StorageClass& store
 
     uint32 maxRecordId = (*result)[0].GetUInt32() + 1;
     uint32 recordCount = 0;
-    uint32 recordsize = 0;
     delete result;
 
     result = WorldDatabase.PQuery("SELECT COUNT(*) FROM %s", store.GetTableName());
@@ -233,41 +348,8 @@ void SQLStorageLoaderBase<DerivedLoader, StorageClass>::Load(StorageClass& store
         exit(1);                                            // Stop server at loading broken or non-compatible table.
     }
 
-    // get struct size
     uint32 offset = 0;
-    for (uint32 x = 0; x < store.GetDstFieldCount(); ++x)
-    {
-        switch (store.GetDstFormat(x))
-        {
-            case FT_LOGIC:
-                recordsize += sizeof(bool);   break;
-            case FT_BYTE:
-                recordsize += sizeof(char);   break;
-            case FT_INT:
-                recordsize += sizeof(uint32); break;
-            case FT_FLOAT:
-                recordsize += sizeof(float);  break;
-            case FT_STRING:
-                recordsize += sizeof(char*);  break;
-            case FT_NA:
-                recordsize += sizeof(uint32); break;
-            case FT_NA_BYTE:
-                recordsize += sizeof(char);   break;
-            case FT_NA_FLOAT:
-                recordsize += sizeof(float);  break;
-            case FT_NA_POINTER:
-                recordsize += sizeof(char*);  break;
-            case FT_64BITINT:
-                recordsize += sizeof(uint64);  break;
-            case FT_IND:
-            case FT_SORT:
-                assert(false && "SQL storage not have sort field types");
-                break;
-            default:
-                assert(false && "unknown format character");
-                break;
-        }
-    }
+    uint32 recordsize = GetRecordSize(store);
 
     // Prepare data storage and lookup storage
     store.prepareToLoad(maxRecordId, recordCount, recordsize);
@@ -278,7 +360,7 @@ void SQLStorageLoaderBase<DerivedLoader, StorageClass>::Load(StorageClass& store
         fields = result->Fetch();
         bar.step();
 
-        char* record = store.createRecord(fields[0].GetUInt32());
+        char* record = store.createRecord(snapshot.Record(fields[0].GetUInt32()));
         offset = 0;
 
         // dependend on dest-size
@@ -304,12 +386,12 @@ void SQLStorageLoaderBase<DerivedLoader, StorageClass>::Load(StorageClass& store
 
             switch (store.GetSrcFormat(y))
             {
-                case FT_LOGIC:  storeValue((bool)(fields[y].GetUInt32() > 0), store, record, x, offset);  ++x; break;
-                case FT_BYTE:   storeValue((char)fields[y].GetUInt8(), store, record, x, offset);         ++x; break;
-                case FT_INT:    storeValue((uint32)fields[y].GetUInt32(), store, record, x, offset);      ++x; break;
-                case FT_FLOAT:  storeValue((float)fields[y].GetFloat(), store, record, x, offset);        ++x; break;
-                case FT_STRING: storeValue((char const*)fields[y].GetString(), store, record, x, offset); ++x; break;
-                case FT_64BITINT: storeValue(fields[y].GetUInt64(), store, record, x, offset);            ++x; break;
+                case FT_LOGIC:  storeValue(snapshot.Record((bool)(fields[y].GetUInt32() > 0)), store, record, x, offset);  ++x; break;
+                case FT_BYTE:   storeValue(snapshot.Record((char)fields[y].GetUInt8()), store, record, x, offset);         ++x; break;
+                case FT_INT:    storeValue(snapshot.Record((uint32)fields[y].GetUInt32()), store, record, x, offset);      ++x; break;
+                case FT_FLOAT:  storeValue(snapshot.Record((float)fields[y].GetFloat()), store, record, x, offset);        ++x; break;
+                case FT_STRING: storeValue(snapshot.Record((char const*)fields[y].GetString()), store, record, x, offset); ++x; break;
+                case FT_64BITINT: storeValue(snapshot.Record(fields[y].GetUInt64()), store, record, x, offset);            ++x; break;
                 case FT_NA:
                 case FT_NA_BYTE:
                 case FT_NA_FLOAT:
@@ -329,12 +411,27 @@ void SQLStorageLoaderBase<DerivedLoader, StorageClass>::Load(StorageClass& store
     while (result->NextRow());
 
     delete result;
+
+    if (!snapshotKey.empty())
+        snapshot.Save(store.GetTableName(), snapshotKey, maxRecordId, store.GetRecordCount());
 }
 
 template<class DerivedLoader, class StorageClass>
 void SQLStorageLoaderBase<DerivedLoader, StorageClass>::LoadProgressive(StorageClass& store, uint32 wow_patch, std::string column_name /* = "patch" */, bool error_at_empty /*= true*/)
 {
     // To be used on tables that need to support patch progression. Second column must be the `patch` column.
+    SQLStorageSnapshot snapshot;
+    std::string snapshotKey;
+    if (SQLStorageSnapshot::IsEnabled())
+    {
+        snapshotKey = SQLStorageSnapshot::BuildKey(store.GetTableName(), column_name + " <= " + std::to_string(wow_patch), store.GetSrcFormat());
+        if (!snapshotKey.empty() && snapshot.Open(store.GetTableName(), snapshotKey) && LoadSnapshot(store, snapshot))
+            return;
+        snapshot.Close();
+        if (!snapshotKey.empty())
+            snapshot.StartRecording();
+    }
+
     Field* fields = nullptr;
     QueryResult* result = WorldDatabase.PQuery("SELECT MAX(%s) FROM %s t1 WHERE %s=(SELECT max(%s) FROM %s t2 WHERE t1.%s=t2.%s && %s <= %u)", store.EntryFieldName(), store.GetTableName(), column_name.c_str(), column_name.c_str(), store.GetTableName(), store.EntryFieldName(), store.EntryFieldName(), column_name.c_str(), wow_patch);
     if (!result)
@@ -346,7 +443,6 @@ void SQLStorageLoaderBase<DerivedLoader, StorageClass>::LoadProgressive(StorageC
 
     uint32 maxRecordId = (*result)[0].GetUInt32() + 1;
     uint32 recordCount = 0;
-    uint32 recordsize = 0;
     delete result;
 
     result = WorldDatabase.PQuery("SELECT COUNT(*) FROM %s t1 WHERE %s=(SELECT max(%s) FROM %s t2 WHERE t1.%s=t2.%s && %s <= %u)", store.GetTableName(), column_name.c_str(), column_name.c_str(), store.GetTableName(), store.EntryFieldName(), store.EntryFieldName(), column_name.c_str(), wow_patch);
@@ -379,41 +475,8 @@ void SQLStorageLoaderBase<DerivedLoader, StorageClass>::LoadProgressive(StorageC
         exit(1);                                            // Stop server at loading broken or non-compatible table.
     }
 
-    // get struct size
     uint32 offset = 0;
-    for (uint32 x = 0; x < store.GetDstFieldCount(); ++x)
-    {
-        switch (store.GetDstFormat(x))
-        {
-        case FT_LOGIC:
-            recordsize += sizeof(bool);   break;
-        case FT_BYTE:
-            recordsize += sizeof(char);   break;
-        case FT_INT:
-            recordsize += sizeof(uint32); break;
-        case FT_FLOAT:
-            recordsize += sizeof(float);  break;
-        case FT_STRING:
-            recordsize += sizeof(char*);  break;
-        case FT_NA:
-            recordsize += sizeof(uint32); break;
-        case FT_NA_BYTE:
-            recordsize += sizeof(char);   break;
-        case FT_NA_FLOAT:
-            recordsize += sizeof(float);  break;
-        case FT_NA_POINTER:
-            recordsize += sizeof(char*);  break;
-        case FT_64BITINT:
-            recordsize += sizeof(uint64);  break;
-        case FT_IND:
-        case FT_SORT:
-            assert(false && "SQL storage not have sort field types");
-            break;
-        default:
-            assert(false && "unknown format character");
-            break;
-        }
-    }
+    uint32 recordsize = GetRecordSize(store);
 
     // Prepare data storage and lookup storage
     store.prepareToLoad(maxRecordId, recordCount, recordsize);
@@ -425,7 +488,7 @@ void SQLStorageLoaderBase<DerivedLoader, StorageClass>::LoadProgressive(StorageC
         fields = result->Fetch();
         bar.step();
 
-        char* record = store.createRecord(fields[0].GetUInt32());
+        char* record = store.createRecord(snapshot.Record(fields[0].GetUInt32()));
         offset = 0;
         patchoffset = 0;
 
@@ -456,12 +519,12 @@ void SQLStorageLoaderBase<DerivedLoader, StorageClass>::LoadProgressive(StorageC
 
             switch (store.GetSrcFormat(y))
             {
-            case FT_LOGIC:  storeValue((bool)(fields[y + patchoffset].GetUInt32() > 0), store, record, x, offset);  ++x; break;
-            case FT_BYTE:   storeValue((char)fields[y + patchoffset].GetUInt8(), store, record, x, offset);         ++x; break;
-            case FT_INT:    storeValue((uint32)fields[y + patchoffset].GetUInt32(), store, record, x, offset);      ++x; break;
-            case FT_FLOAT:  storeValue((float)fields[y + patchoffset].GetFloat(), store, record, x, offset);        ++x; break;
-            case FT_STRING: storeValue((char const*)fields[y + patchoffset].GetString(), store, record, x, offset); ++x; break;
-            case FT_64BITINT: storeValue(fields[y + patchoffset].GetUInt64(), store, record, x, offset);            ++x; break;
+            case FT_LOGIC:  storeValue(snapshot.Record((bool)(fields[y + patchoffset].GetUInt32() > 0)), store, record, x, offset);  ++x; break;
+            case FT_BYTE:   storeValue(snapshot.Record((char)fields[y + patchoffset].GetUInt8()), store, record, x, offset);         ++x; break;
+            case FT_INT:    storeValue(snapshot.Record((uint32)fields[y + patchoffset].GetUInt32()), store, record, x, offset);      ++x; break;
+            case FT_FLOAT:  storeValue(snapshot.Record((float)fields[y + patchoffset].GetFloat()), store, record, x, offset);        ++x; break;
+            case FT_STRING: storeValue(snapshot.Record((char const*)fields[y + patchoffset].GetString()), store, record, x, offset); ++x; break;
+            case FT_64BITINT: storeValue(snapshot.Record(fields[y + patchoffset].GetUInt64()), store, record, x, offset);            ++x; break;
             case FT_NA:
             case FT_NA_BYTE:
             case FT_NA_FLOAT:
@@ -480,6 +543,9 @@ void SQLStorageLoaderBase<DerivedLoader, StorageClass>::LoadProgressive(StorageC
     } while (result->NextRow());
 
     delete result;
+
+    if (!snapshotKey.empty())
+        snapshot.Save(store.GetTableName(), snapshotKey, maxRecordId, store.GetRecordCount());
 }
 
 #endif
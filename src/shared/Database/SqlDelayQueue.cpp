@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "Database/SqlDelayQueue.h"
+#include "Database/SqlOperations.h"
+#include <algorithm>
+
+static uint32 HistogramBucket(uint64 value)
+{
+    uint32 bucket = 0;
+    while (value && bucket < SqlDelayQueue::HISTOGRAM_BUCKETS - 1)
+    {
+        value >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+void SqlDelayQueue::Histogram::Add(uint64 value)
+{
+    ++buckets[HistogramBucket(value)];
+    ++count;
+    if (value > max)
+        max = value;
+}
+
+void SqlDelayQueue::Histogram::Reset()
+{
+    for (uint32 i = 0; i < HISTOGRAM_BUCKETS; ++i)
+        buckets[i] = 0;
+    count = 0;
+    max = 0;
+}
+
+uint64 SqlDelayQueue::Histogram::Percentile(float fraction) const
+{
+    uint64 const target = uint64(count * fraction);
+    uint64 seen = 0;
+    for (uint32 i = 0; i < HISTOGRAM_BUCKETS - 1; ++i)
+    {
+        seen += buckets[i];
+        if (seen > target)
+            return i ? std::min((uint64(1) << i) - 1, max) : 0;
+    }
+    return max;
+}
+
+SqlDelayQueue::~SqlDelayQueue()
+{
+    for (std::deque<Entry>::iterator itr = m_unordered.begin(); itr != m_unordered.end(); ++itr)
+        delete itr->op;
+    for (std::unordered_map<uint32, SerialQueue>::iterator serial = m_serials.begin(); serial != m_serials.end(); ++serial)
+        for (std::deque<Entry>::iterator itr = serial->second.entries.begin(); itr != serial->second.entries.end(); ++itr)
+            delete itr->op;
+}
+
+void SqlDelayQueue::Add(SqlOperation* op, uint32 serialId)
+{
+    Entry entry;
+    entry.op = op;
+    entry.queuedAt = Clock::now();
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (serialId)
+        {
+            SerialQueue& serial = m_serials[serialId];
+            if (serial.entries.empty() && !serial.busy)
+                m_readySerials.push_back(serialId);
+            serial.entries.push_back(entry);
+        }
+        else
+            m_unordered.push_back(entry);
+
+        ++m_size;
+        m_stats.depth.Add(m_size);
+    }
+    m_available.notify_one();
+}
+
+bool SqlDelayQueue::ExecuteNext(SqlConnection* conn, uint32 waitMs)
+{
+    Entry entry;
+    uint32 serialId = 0;
+    {
+        std::unique_lock<std::mutex> guard(m_lock);
+        if (m_unordered.empty() && m_readySerials.empty())
+        {
+            if (!waitMs)
+                return false;
+            m_available.wait_for(guard, std::chrono::milliseconds(waitMs));
+            if (m_unordered.empty() && m_readySerials.empty())
+                return false;
+        }
+
+        // oldest operation first
+        bool fromSerial = !m_readySerials.empty();
+        if (fromSerial && !m_unordered.empty())
+            fromSerial = m_serials[m_readySerials.front()].entries.front().queuedAt < m_unordered.front().queuedAt;
+
+        if (fromSerial)
+        {
+            serialId = m_readySerials.front();
+            m_readySerials.pop_front();
+            SerialQueue& serial = m_serials[serialId];
+            entry = serial.entries.front();
+            serial.entries.pop_front();
+            serial.busy = true;
+        }
+        else
+        {
+            entry = m_unordered.front();
+            m_unordered.pop_front();
+        }
+        --m_size;
+    }
+
+    Clock::time_point start = Clock::now();
+    entry.op->Execute(conn);
+    Clock::time_point end = Clock::now();
+    delete entry.op;
+
+    bool wakeOther = false;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stats.waitUs.Add(std::chrono::duration_cast<std::chrono::microseconds>(start - entry.queuedAt).count());
+        m_stats.execUs.Add(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+
+        if (serialId)
+        {
+            std::unordered_map<uint32, SerialQueue>::iterator serial = m_serials.find(serialId);
+            serial->second.busy = false;
+            if (serial->second.entries.empty())
+                m_serials.erase(serial);
+            else
+            {
+                m_readySerials.push_back(serialId);
+                wakeOther = true;
+            }
+        }
+    }
+    if (wakeOther)
+        m_available.notify_one();
+
+    return true;
+}
+
+void SqlDelayQueue::ResetStats()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_stats.depth.Reset();
+    m_stats.waitUs.Reset();
+    m_stats.execUs.Reset();
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __SQLDELAYQUEUE_H
+#define __SQLDELAYQUEUE_H
+
+#include "Platform/Define.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+class SqlOperation;
+class SqlConnection;
+
+/**
+ * Operations waiting for the async workers of a database.
+ * Operations queued with the same serial id are executed one at a time, in the
+ * order they were queued. Operations of different serial ids, and those without
+ * serial id, are picked by whichever worker is idle, oldest first, so that a slow
+ * key never holds back the others.
+ */
+class SqlDelayQueue
+{
+    public:
+        // Bucket 0 counts the value 0, bucket i the values in [2^(i-1), 2^i), the last bucket everything above
+        static uint32 const HISTOGRAM_BUCKETS = 24;
+
+        struct Histogram
+        {
+            Histogram() { Reset(); }
+
+            void Add(uint64 value);
+            void Reset();
+            // Upper bound of the bucket containing the given fraction of the samples
+            uint64 Percentile(float fraction) const;
+
+            uint64 buckets[HISTOGRAM_BUCKETS];
+            uint64 count;
+            uint64 max;
+        };
+
+        struct Stats
+        {
+            Histogram depth;                                // queued operations, sampled at each Add()
+            Histogram waitUs;                               // time between Add() and execution start
+            Histogram execUs;                               // execution time
+        };
+
+        SqlDelayQueue() : m_size(0), m_softLimit(0) {}
+        ~SqlDelayQueue();
+
+        void Add(SqlOperation* op, uint32 serialId);
+
+        // Executes the next available operation, waiting at most 'waitMs' for one. Returns false if none was executed.
+        bool ExecuteNext(SqlConnection* conn, uint32 waitMs);
+
+        size_t GetSize() const { std::lock_guard<std::mutex> guard(m_lock); return m_size; }
+        bool Empty() const { return GetSize() == 0; }
+
+        // Above this amount of queued operations producers should hold back deferrable work. 0 disables.
+        void SetSoftLimit(size_t limit) { m_softLimit = limit; }
+        size_t GetSoftLimit() const { return m_softLimit; }
+        bool IsOverloaded() const { return m_softLimit && GetSize() > m_softLimit; }
+
+        void GetStats(Stats& stats) const { std::lock_guard<std::mutex> guard(m_lock); stats = m_stats; }
+        void ResetStats();
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Entry
+        {
+            SqlOperation* op;
+            Clock::time_point queuedAt;
+        };
+
+        struct SerialQueue
+        {
+            SerialQueue() : busy(false) {}
+            std::deque<Entry> entries;
+            bool busy;                                      // an operation of this serial id is being executed
+        };
+
+        mutable std::mutex m_lock;
+        std::condition_variable m_available;
+
+        std::deque<Entry> m_unordered;                      // operations without serial id
+        std::unordered_map<uint32, SerialQueue> m_serials;
+        std::deque<uint32> m_readySerials;                  // serial ids with queued operations and not busy
+        size_t m_size;
+        size_t m_softLimit;
+
+        Stats m_stats;
+};
+
+#endif
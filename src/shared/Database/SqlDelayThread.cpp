@@ -22,6 +22,7 @@
 #include "Database/SqlDelayThread.h"
 #include "Database/SqlOperations.h"
 #include "DatabaseEnv.h"
+#include "Timer.h"
 
 SqlDelayThread::SqlDelayThread(Database* db, SqlConnection* conn, int workerId)
     : m_dbEngine(db), m_dbConnection(conn), m_running(true), m_workerId(workerId)
@@ -41,22 +42,17 @@ void SqlDelayThread::run()
     mysql_thread_init();
     #endif
 
-    const uint32 loopSleepms = 10;
+    // operations wake the worker up, this is only the delay to notice Stop() and ping
+    const uint32 waitMs = 100;
 
-    const uint32 pingEveryLoop = m_dbEngine->GetPingIntervall() / loopSleepms;
-
-    uint32 loopCounter = 0;
+    uint32 lastPing = WorldTimer::getMSTime();
     while (m_running)
     {
-        // if the running state gets turned off while sleeping
-        // empty the queue before exiting
-        ACE_Based::Thread::Sleep(loopSleepms);
-
-        ProcessRequests();
+        m_dbEngine->ExecuteDelayedOperation(m_dbConnection, waitMs);
 
-        if((loopCounter++) >= pingEveryLoop)
+        if (WorldTimer::getMSTimeDiffToNow(lastPing) >= m_dbEngine->GetPingIntervall())
         {
-            loopCounter = 0;
+            lastPing = WorldTimer::getMSTime();
             m_dbEngine->Ping();
             if (QueryResult* res = m_dbConnection->Query("SELECT 1"))
                 delete res;
@@ -75,17 +71,6 @@ void SqlDelayThread::Stop()
 
 void SqlDelayThread::ProcessRequests()
 {
-    SqlOperation* s = NULL;
-    while (m_dbEngine->NextDelayedOperation(s))
-    {
-        s->Execute(m_dbConnection);
-        delete s;
-    }
-
-    // Process any serial operations for this worker
-    while (m_dbEngine->NextSerialDelayedOperation(m_workerId, s))
-    {
-        s->Execute(m_dbConnection);
-        delete s;
-    }
+    while (m_dbEngine->ExecuteDelayedOperation(m_dbConnection, 0))
+        ;
 }
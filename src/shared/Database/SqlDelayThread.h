@@ -33,10 +33,7 @@ class SqlConnection;
 
 class SqlDelayThread : public ACE_Based::Runnable
 {
-    typedef ACE_Based::LockedQueue<SqlOperation*, ACE_Thread_Mutex> SqlQueue;
-
     private:
-        SqlQueue m_sqlQueue;                                ///< Queue of SQL statements
         Database* m_dbEngine;                               ///< Pointer to used Database engine
         SqlConnection * m_dbConnection;                     ///< Pointer to DB connection
         volatile bool m_running;
@@ -50,9 +47,6 @@ class SqlDelayThread : public ACE_Based::Runnable
         SqlDelayThread(Database* db, SqlConnection* conn, int workerId);
         ~SqlDelayThread();
 
-        ///< Put sql statement to delay queue
-        bool Delay(SqlOperation* sql) { m_sqlQueue.add(sql); return true; }
-
         virtual void Stop();                                ///< Stop event
         virtual void run();                                 ///< Main Thread loop
 };
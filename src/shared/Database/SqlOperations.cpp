@@ -24,6 +24,10 @@
 #include "DatabaseEnv.h"
 #include "DatabaseImpl.h"
 #include "Timer.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 #define LOCK_DB_CONN(conn) SqlConnection::Lock guard(conn)
 
@@ -45,6 +49,18 @@ SqlTransaction::~SqlTransaction()
     }
 }
 
+void SqlTransaction::DelayExecuteBatched(int nIndex, SqlStmtParameters * arg, size_t bytes)
+{
+    if (!m_lastBatch || m_lastBatch->GetIndex() != nIndex)
+    {
+        DelayExecute(new SqlBatchedRequest(nIndex));
+        m_lastBatch = static_cast<SqlBatchedRequest*>(m_queue.back());
+    }
+
+    m_lastBatch->AddRow(arg);
+    m_bytes += bytes;
+}
+
 bool SqlTransaction::Execute(SqlConnection *conn)
 {
     if(m_queue.empty())
@@ -62,11 +78,17 @@ bool SqlTransaction::Execute(SqlConnection *conn)
         if(!pStmt->Execute(conn))
         {
             conn->RollbackTransaction();
+            conn->DB().OnTransactionFailed();
             return false;
         }
     }
 
-    return conn->CommitTransaction();
+    if(!conn->CommitTransaction())
+    {
+        conn->DB().OnTransactionFailed();
+        return false;
+    }
+    return true;
 }
 
 SqlPreparedRequest::SqlPreparedRequest(int nIndex, SqlStmtParameters * arg ) : m_nIndex(nIndex), m_param(arg)
@@ -84,6 +106,53 @@ bool SqlPreparedRequest::Execute( SqlConnection *conn )
     return conn->ExecuteStmt(m_nIndex, *m_param);
 }
 
+// Rows sent in a single statement at most. Statements are only built for powers of two
+// up to this value, so that a few prepared statements cover any amount of rows.
+#define MAX_BATCHED_ROWS 64
+
+SqlBatchedRequest::~SqlBatchedRequest()
+{
+    for (size_t i = 0; i < m_rows.size(); ++i)
+        delete m_rows[i];
+}
+
+bool SqlBatchedRequest::Execute( SqlConnection *conn )
+{
+    LOCK_DB_CONN(conn);
+
+    size_t done = 0;
+    while (done < m_rows.size())
+    {
+        uint32 count = 1;
+        while (count * 2 <= m_rows.size() - done && count * 2 <= MAX_BATCHED_ROWS)
+            count *= 2;
+
+        int nIndex = count > 1 ? conn->DB().GetBatchedStmtIndex(m_nIndex, count) : -1;
+        if (nIndex < 0)
+        {
+            // single row, or a statement that can not be merged
+            if (!conn->ExecuteStmt(m_nIndex, *m_rows[done]))
+                return false;
+            ++done;
+            continue;
+        }
+
+        SqlStmtParameters params(0);
+        for (uint32 i = 0; i < count; ++i)
+        {
+            SqlStmtParameters::ParameterContainer const& row = m_rows[done + i]->params();
+            for (SqlStmtParameters::ParameterContainer::const_iterator itr = row.begin(); itr != row.end(); ++itr)
+                params.addParam(*itr);
+        }
+
+        if (!conn->ExecuteStmt(nIndex, params))
+            return false;
+        done += count;
+    }
+
+    return true;
+}
+
 /// ---- ASYNC QUERIES ----
 
 bool SqlQuery::Execute(SqlConnection *conn)
@@ -191,7 +260,7 @@ bool SqlQueryHolder::Execute(MaNGOS::IQueryCallback * callback, Database *databa
 
     /// delay the execution of the queries, sync them with the delay thread
     /// which will in turn resync on execution (via the queue) and call back
-    SqlQueryHolderEx *holderEx = new SqlQueryHolderEx(this, callback, queue, serialId);
+    SqlQueryHolderEx *holderEx = new SqlQueryHolderEx(this, callback, queue, database, serialId);
 
     database->AddToSerialDelayQueue(holderEx);
     return true;
@@ -300,26 +369,94 @@ void SqlQueryHolder::SetSize(size_t size)
 {
     /// to optimize push_back, reserve the number of queries about to be executed
     m_queries.resize(size);
+    m_queryTimes.resize(size);
+}
+
+typedef std::chrono::steady_clock HolderClock;
+
+static inline uint32 ElapsedUs(HolderClock::time_point from, HolderClock::time_point to)
+{
+    return uint32(std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
 }
 
+/// Queries of a holder shared between the workers executing them
+struct SqlQueryHolderEx::Job
+{
+    Job(SqlQueryHolder* h) : holder(h), size(h->m_queries.size()), next(0), done(0) {}
+
+    /// executes queries not yet started until there is none left
+    void Run(SqlConnection* conn)
+    {
+        /// the holder may already be deleted when a late helper gets here, only the counter is safe to read
+        size_t index = next++;
+        if (index >= size)
+            return;
+
+        LOCK_DB_CONN(conn);
+        size_t executed = 0;
+        for (; index < size; index = next++)
+        {
+            /// we can do this, we are friends
+            char const* sql = holder->m_queries[index].first;
+            if (sql)
+            {
+                HolderClock::time_point start = HolderClock::now();
+                holder->SetResult(index, conn->Query(sql));
+                holder->m_queryTimes[index] = ElapsedUs(start, HolderClock::now());
+            }
+            ++executed;
+        }
+
+        std::lock_guard<std::mutex> lock(doneLock);
+        done += executed;
+        if (done == size)
+            finished.notify_all();
+    }
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(doneLock);
+        finished.wait(lock, [this] { return done == size; });
+    }
+
+    SqlQueryHolder* holder;
+    size_t const size;
+    std::atomic<size_t> next;
+    std::mutex doneLock;
+    std::condition_variable finished;
+    size_t done;
+};
+
 bool SqlQueryHolderEx::Execute(SqlConnection *conn)
 {
     if(!m_holder || !m_callback || !m_queue)
         return false;
 
-    LOCK_DB_CONN(conn);
-    /// we can do this, we are friends
-    std::vector<SqlQueryHolder::SqlResultPair> &queries = m_holder->m_queries;
-    for(size_t i = 0; i < queries.size(); i++)
-    {
-        /// execute all queries in the holder and pass the results
-        char const *sql = queries[i].first;
-        if (sql)
-            m_holder->SetResult(i, conn->Query(sql));
-    }
+    HolderClock::time_point start = HolderClock::now();
+    m_holder->m_waitTime = ElapsedUs(m_queuedAt, start);
+
+    std::shared_ptr<Job> job = std::make_shared<Job>(m_holder);
+
+    /// only worth it when other workers are idle, under load the other holders keep them busy anyway
+    size_t helpers = 0;
+    if (m_db && job->size > 1 && m_db->GetAsyncQueueSize() + 1 < m_db->GetAsyncWorkersCount())
+        helpers = std::min<size_t>(job->size - 1, m_db->GetAsyncWorkersCount() - 1 - m_db->GetAsyncQueueSize());
+    for (size_t i = 0; i < helpers; ++i)
+        m_db->AddToDelayQueue(new SqlQueryHolderHelper(job));
+
+    /// the holder keeps its serial id until all the queries are done
+    job->Run(conn);
+    job->Wait();
+    m_holder->m_execTime = ElapsedUs(start, HolderClock::now());
 
     /// sync with the caller thread
     m_queue->add(m_callback);
 
     return true;
 }
+
+bool SqlQueryHolderHelper::Execute(SqlConnection *conn)
+{
+    m_job->Run(conn);
+    return true;
+}
@@ -27,6 +27,8 @@
 #include "ace/Thread_Mutex.h"
 #include "LockedQueue.h"
 #include <queue>
+#include <chrono>
+#include <memory>
 #include "Utilities/Callback.h"
 
 /// ---- BASE ---
@@ -62,16 +64,26 @@ class SqlPlainRequest : public SqlOperation
         bool Execute(SqlConnection *conn);
 };
 
+class SqlBatchedRequest;
+
 class SqlTransaction : public SqlOperation
 {
     private:
         std::vector<SqlOperation * > m_queue;
+        size_t m_bytes;
+        SqlBatchedRequest * m_lastBatch;                    // last queued operation, while rows can be appended to it
 
     public:
-        SqlTransaction(uint32 serialId) : SqlOperation(serialId) {}
+        SqlTransaction(uint32 serialId) : SqlOperation(serialId), m_bytes(0), m_lastBatch(NULL) {}
         ~SqlTransaction();
 
-        void DelayExecute(SqlOperation * sql)   {   m_queue.push_back(sql); }
+        void DelayExecute(SqlOperation * sql, size_t bytes = 0)   {   m_queue.push_back(sql); m_bytes += bytes; m_lastBatch = NULL; }
+        //queue a row of an INSERT/REPLACE statement, merged with the rows of the same statement queued just before
+        void DelayExecuteBatched(int nIndex, SqlStmtParameters * arg, size_t bytes);
+
+        //amount of queued statements and size of their query text / parameters
+        size_t GetStatementsCount() const { return m_queue.size(); }
+        size_t GetBytes() const { return m_bytes; }
 
         bool Execute(SqlConnection *conn);
 };
@@ -89,6 +101,23 @@ class SqlPreparedRequest : public SqlOperation
         SqlStmtParameters * m_param;
 };
 
+//rows of the same INSERT/REPLACE statement, executed as multi-row statements
+class SqlBatchedRequest : public SqlOperation
+{
+    public:
+        SqlBatchedRequest(int nIndex) : m_nIndex(nIndex) {}
+        ~SqlBatchedRequest();
+
+        int GetIndex() const { return m_nIndex; }
+        void AddRow(SqlStmtParameters * arg) { m_rows.push_back(arg); }
+
+        bool Execute(SqlConnection *conn);
+
+    private:
+        const int m_nIndex;
+        std::vector<SqlStmtParameters * > m_rows;
+};
+
 /// ---- ASYNC QUERIES ----
 
 class SqlQuery;                                             /// contains a single async query
@@ -127,11 +156,14 @@ class SqlQueryHolder
     private:
         typedef std::pair<const char*, QueryResult*> SqlResultPair;
         std::vector<SqlResultPair> m_queries;
+        std::vector<uint32> m_queryTimes;                   // microseconds, per query
+        uint32 m_waitTime;                                  // microseconds between Execute() and the first query
+        uint32 m_execTime;                                  // microseconds to run all the queries
 
         uint32 serialId;
     public:
-        SqlQueryHolder(uint32 id) : serialId(id) {}
-        SqlQueryHolder() : serialId(0) {}
+        SqlQueryHolder(uint32 id) : m_waitTime(0), m_execTime(0), serialId(id) {}
+        SqlQueryHolder() : m_waitTime(0), m_execTime(0), serialId(0) {}
         virtual ~SqlQueryHolder();
         bool SetQuery(size_t index, const char *sql);
         bool SetPQuery(size_t index, const char *format, ...) ATTR_PRINTF(3,4);
@@ -142,17 +174,36 @@ class SqlQueryHolder
         bool Execute(MaNGOS::IQueryCallback * callback, Database *db, SqlResultQueue *queue);
         void DeleteAllResults();
         uint32 GetSerialId() const { return serialId; }
+        /// timings of the last execution, valid in the callback
+        uint32 GetQueryTime(size_t index) const { return index < m_queryTimes.size() ? m_queryTimes[index] : 0; }
+        uint32 GetWaitTime() const { return m_waitTime; }
+        uint32 GetExecutionTime() const { return m_execTime; }
 };
 
+/// The queries of a holder are independent: the worker executing the holder
+/// asks idle workers for help, each of them taking the next query not yet started
 class SqlQueryHolderEx : public SqlOperation
 {
+    public:
+        struct Job;
     private:
         SqlQueryHolder * m_holder;
         MaNGOS::IQueryCallback * m_callback;
         SqlResultQueue * m_queue;
+        Database * m_db;
+        std::chrono::steady_clock::time_point m_queuedAt;
+    public:
+        SqlQueryHolderEx(SqlQueryHolder *holder, MaNGOS::IQueryCallback * callback, SqlResultQueue * queue, Database *db, uint32 id)
+            : SqlOperation(id), m_holder(holder), m_callback(callback), m_queue(queue), m_db(db), m_queuedAt(std::chrono::steady_clock::now()) {}
+        bool Execute(SqlConnection *conn);
+};
+
+class SqlQueryHolderHelper : public SqlOperation
+{
+    private:
+        std::shared_ptr<SqlQueryHolderEx::Job> m_job;
     public:
-        SqlQueryHolderEx(SqlQueryHolder *holder, MaNGOS::IQueryCallback * callback, SqlResultQueue * queue, uint32 id)
-            : SqlOperation(id), m_holder(holder), m_callback(callback), m_queue(queue) {}
+        SqlQueryHolderHelper(std::shared_ptr<SqlQueryHolderEx::Job> const& job) : m_job(job) {}
         bool Execute(SqlConnection *conn);
 };
 #endif                                                      //__SQLOPERATIONS_H
@@ -69,6 +69,21 @@ bool SqlStatement::Execute()
     return m_pDB->ExecuteStmt(m_index, args);
 }
 
+bool SqlStatement::ExecuteBatched()
+{
+    SqlStmtParameters * args = detach();
+    //verify amount of bound parameters
+    if(args->boundParams() != arguments())
+    {
+        sLog.outError("SQL ERROR: wrong amount of parameters (%i instead of %i)", args->boundParams(), arguments());
+        sLog.outError("SQL ERROR: statement: %s", m_pDB->GetStmtString(ID()).c_str());
+        MANGOS_ASSERT(false);
+        return false;
+    }
+
+    return m_pDB->ExecuteStmtBatched(m_index, args);
+}
+
 bool SqlStatement::DirectExecute()
 {
     SqlStmtParameters * args = detach();
@@ -160,6 +160,14 @@ class MANGOS_DLL_SPEC SqlStmtParameters
         void swap(SqlStmtParameters& obj);
         //get bound parameters
         const ParameterContainer& params() const { return m_params; }
+        //get total size of bound parameters data
+        size_t dataSize() const
+        {
+            size_t size = 0;
+            for (ParameterContainer::const_iterator itr = m_params.begin(); itr != m_params.end(); ++itr)
+                size += itr->size();
+            return size;
+        }
 
     private:
         SqlStmtParameters& operator=(const SqlStmtParameters& obj);
@@ -205,6 +213,9 @@ class MANGOS_DLL_SPEC SqlStatement
         int arguments() const { return m_index.arguments(); }
 
         bool Execute();
+        //inside of a transaction, the row is merged with the rows queued just before by the same
+        //INSERT/REPLACE statement and they are all sent as a single multi-row statement at commit
+        bool ExecuteBatched();
         bool DirectExecute();
 
         //templates to simplify 1-4 parameter bindings
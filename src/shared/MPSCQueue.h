@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace ACE_Based
+{
+    /**
+     * Lock-free queue with multiple producers, meant to be drained by a single consumer.
+     * Producers reserve a slot of the ring with a CAS on the enqueue position,
+     * then publish it through the slot sequence number. The consumer takes it
+     * with a CAS on the dequeue position, so that an occasional second consumer
+     * (a queue cleared from elsewhere) is safe. When the ring is full, items spill
+     * to a locked overflow list, which is used until drained so that the items of
+     * a producer stay in order. The lock is only taken while that list is not
+     * empty. The consumer can look at the front item before removing it, which
+     * keeps the filtering semantics of LockedQueue::next(T&, Checker&).
+     * Capacity must be a power of two.
+     */
+    template <class T, size_t Capacity>
+        class MPSCQueue
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "MPSCQueue capacity must be a power of two");
+
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T data;
+        };
+
+        struct AcceptAll
+        {
+            bool Process(T const&) { return true; }
+        };
+
+        // Positions are written by different threads, keep them on different cache lines
+        Cell _buffer[Capacity];
+        char _pad0[64];
+        std::atomic<size_t> _enqueuePos;
+        char _pad1[64 - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> _dequeuePos;
+
+        std::mutex _overflowLock;
+        std::deque<T> _overflow;
+        std::atomic<size_t> _overflowSize;
+
+        MPSCQueue(MPSCQueue const&);
+        MPSCQueue& operator=(MPSCQueue const&);
+
+        public:
+
+            MPSCQueue() : _enqueuePos(0), _dequeuePos(0), _overflowSize(0)
+            {
+                for (size_t i = 0; i < Capacity; ++i)
+                    _buffer[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+            //! Adds an item to the queue.
+            void add(const T& item)
+            {
+                if (_overflowSize.load(std::memory_order_acquire) || !addToRing(item))
+                {
+                    std::lock_guard<std::mutex> guard(_overflowLock);
+                    _overflow.push_back(item);
+                    _overflowSize.store(_overflow.size(), std::memory_order_release);
+                }
+            }
+
+            //! Gets the next item in the queue, if any.
+            bool next(T& result)
+            {
+                AcceptAll check;
+                return next(result, check);
+            }
+
+            //! Gets the next item in the queue, only if the checker accepts it.
+            template<class Checker>
+            bool next(T& result, Checker& check)
+            {
+                size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+                while (true)
+                {
+                    Cell& cell = _buffer[pos & (Capacity - 1)];
+                    size_t const seq = cell.sequence.load(std::memory_order_acquire);
+                    ptrdiff_t const diff = ptrdiff_t(seq) - ptrdiff_t(pos + 1);
+                    if (diff == 0)
+                    {
+                        // The slot is only given back by the consumer winning the CAS, the copy stays valid until then
+                        T item = cell.data;
+                        if (!check.Process(item))
+                            return false;
+                        if (_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            result = item;
+                            cell.sequence.store(pos + Capacity, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (diff < 0)
+                        return nextFromOverflow(pos, result, check);
+                    else
+                        pos = _dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+
+            //! Approximate, other threads may be adding items.
+            bool empty() const
+            {
+                size_t const pos = _dequeuePos.load(std::memory_order_relaxed);
+                return _buffer[pos & (Capacity - 1)].sequence.load(std::memory_order_acquire) != pos + 1 &&
+                       !_overflowSize.load(std::memory_order_acquire);
+            }
+
+            static size_t capacity() { return Capacity; }
+
+        private:
+            // Fails if the ring is full
+            bool addToRing(const T& item)
+            {
+                size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+                while (true)
+                {
+                    Cell& cell = _buffer[pos & (Capacity - 1)];
+                    size_t const seq = cell.sequence.load(std::memory_order_acquire);
+                    ptrdiff_t const diff = ptrdiff_t(seq) - ptrdiff_t(pos);
+                    if (diff == 0)
+                    {
+                        if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            cell.data = item;
+                            cell.sequence.store(pos + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (diff < 0)
+                        return false;
+                    else
+                        pos = _enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+
+            // Called when nothing is published at the dequeue position
+            template<class Checker>
+            bool nextFromOverflow(size_t pos, T& result, Checker& check)
+            {
+                if (!_overflowSize.load(std::memory_order_acquire))
+                    return false;
+
+                std::lock_guard<std::mutex> guard(_overflowLock);
+                // A producer is still writing a reserved slot: later slots may hold items
+                // queued before the overflow ones, wait for the ring to be drained.
+                if (_enqueuePos.load(std::memory_order_relaxed) != pos)
+                    return false;
+                if (_overflow.empty() || !check.Process(_overflow.front()))
+                    return false;
+
+                result = _overflow.front();
+                _overflow.pop_front();
+                // Producers go back to the ring once the overflow is empty
+                _overflowSize.store(_overflow.size(), std::memory_order_release);
+                return true;
+            }
+    };
+}
+#endif
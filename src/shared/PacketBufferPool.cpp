@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "PacketBufferPool.h"
+
+namespace
+{
+    size_t const SIZE_CLASSES_COUNT = 5;
+    size_t const SIZE_CLASSES[SIZE_CLASSES_COUNT] = { 64, 256, 1024, 4096, 16384 };
+
+    // Each thread keeps at most this many bytes per size class
+    size_t const MAX_BYTES_PER_CLASS = 256 * 1024;
+
+    struct LocalPool
+    {
+        LocalPool();
+        ~LocalPool();
+
+        std::vector<std::vector<uint8> > freeBuffers[SIZE_CLASSES_COUNT];
+    };
+
+    // Set once the pool of the thread is destroyed, packets freed afterwards
+    // (static objects, thread exit) release their memory normally.
+    thread_local bool s_poolDestroyed = false;
+
+    LocalPool::LocalPool()
+    {
+        for (size_t i = 0; i < SIZE_CLASSES_COUNT; ++i)
+            freeBuffers[i].reserve(MAX_BYTES_PER_CLASS / SIZE_CLASSES[i]);
+    }
+
+    LocalPool::~LocalPool()
+    {
+        s_poolDestroyed = true;
+    }
+
+    LocalPool* GetLocalPool()
+    {
+        if (s_poolDestroyed)
+            return nullptr;
+        thread_local LocalPool pool;
+        return &pool;
+    }
+}
+
+void PacketBufferPool::Acquire(std::vector<uint8>& storage, size_t reserve)
+{
+    size_t sizeClass = 0;
+    while (sizeClass < SIZE_CLASSES_COUNT && SIZE_CLASSES[sizeClass] < reserve)
+        ++sizeClass;
+
+    if (sizeClass == SIZE_CLASSES_COUNT)
+    {
+        storage.reserve(reserve);
+        return;
+    }
+
+    LocalPool* pool = GetLocalPool();
+    if (pool && !pool->freeBuffers[sizeClass].empty())
+    {
+        storage.swap(pool->freeBuffers[sizeClass].back());
+        pool->freeBuffers[sizeClass].pop_back();
+        return;
+    }
+
+    storage.reserve(SIZE_CLASSES[sizeClass]);
+}
+
+void PacketBufferPool::Release(std::vector<uint8>& storage)
+{
+    size_t const capacity = storage.capacity();
+    if (capacity < SIZE_CLASSES[0])
+    {
+        std::vector<uint8>().swap(storage);
+        return;
+    }
+
+    // Largest class the buffer can serve. Buffers that grew too much are not kept.
+    size_t sizeClass = SIZE_CLASSES_COUNT - 1;
+    while (SIZE_CLASSES[sizeClass] > capacity)
+        --sizeClass;
+
+    LocalPool* pool = GetLocalPool();
+    if (!pool || capacity > 4 * SIZE_CLASSES[SIZE_CLASSES_COUNT - 1] ||
+        pool->freeBuffers[sizeClass].size() >= MAX_BYTES_PER_CLASS / SIZE_CLASSES[sizeClass])
+    {
+        std::vector<uint8>().swap(storage);
+        return;
+    }
+
+    storage.clear();
+    pool->freeBuffers[sizeClass].emplace_back();
+    pool->freeBuffers[sizeClass].back().swap(storage);
+}
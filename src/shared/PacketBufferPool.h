@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_PACKETBUFFERPOOL_H
+#define MANGOS_PACKETBUFFERPOOL_H
+
+#include "Platform/Define.h"
+#include <vector>
+
+/**
+ * Recycles the storage of WorldPacket objects.
+ * Buffers are sorted in a few size classes and kept in per-thread free lists,
+ * so building a packet normally does not touch the heap nor take any lock.
+ * A buffer released by another thread than the one which acquired it simply
+ * joins the free list of the releasing thread.
+ */
+class PacketBufferPool
+{
+    public:
+        // Gives 'storage' a capacity of at least 'reserve' bytes. 'storage' must be empty.
+        static void Acquire(std::vector<uint8>& storage, size_t reserve);
+        // Takes the buffer back for later reuse. 'storage' is left empty.
+        static void Release(std::vector<uint8>& storage);
+};
+
+#endif
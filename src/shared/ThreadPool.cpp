@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ThreadPool.h"
+
+typedef std::chrono::steady_clock TaskClock;
+
+// Pool and queue index of the current thread, if it is a pool worker
+static thread_local ThreadPool* s_currentPool = nullptr;
+static thread_local size_t s_currentIndex = 0;
+
+static inline uint64 ElapsedUs(TaskClock::time_point from, TaskClock::time_point to)
+{
+    return uint64(std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+static inline void AtomicMax(std::atomic<uint64>& value, uint64 candidate)
+{
+    uint64 current = value.load(std::memory_order_relaxed);
+    while (current < candidate && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed))
+        ;
+}
+
+void TaskPhaseStats::Record(uint64 queueUs, uint64 execUs)
+{
+    tasks.fetch_add(1, std::memory_order_relaxed);
+    queueTimeUs.fetch_add(queueUs, std::memory_order_relaxed);
+    execTimeUs.fetch_add(execUs, std::memory_order_relaxed);
+    AtomicMax(maxQueueTimeUs, queueUs);
+    AtomicMax(maxExecTimeUs, execUs);
+}
+
+void TaskPhaseStats::Reset()
+{
+    tasks = 0;
+    queueTimeUs = 0;
+    execTimeUs = 0;
+    maxQueueTimeUs = 0;
+    maxExecTimeUs = 0;
+}
+
+struct TaskGroup::State
+{
+    struct Entry
+    {
+        Task task;
+        TaskClock::time_point queuedAt;
+    };
+
+    explicit State(TaskPhaseStats* s) : remaining(0), stats(s) {}
+
+    // Executes one task of this group, if any is still queued
+    bool RunOne()
+    {
+        Entry entry;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (queue.empty())
+                return false;
+            entry = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        TaskClock::time_point start = TaskClock::now();
+        entry.task();
+        if (stats)
+            stats->Record(ElapsedUs(entry.queuedAt, start), ElapsedUs(start, TaskClock::now()));
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (--remaining == 0)
+            finished.notify_all();
+        return true;
+    }
+
+    std::mutex lock;
+    std::condition_variable finished;
+    std::deque<Entry> queue;
+    size_t remaining;
+    TaskPhaseStats* stats;
+};
+
+TaskGroup::TaskGroup(ThreadPool* pool, TaskPhaseStats* stats) : m_pool(pool), m_state(std::make_shared<State>(stats))
+{
+}
+
+void TaskGroup::run(Task task)
+{
+    if (!m_pool)
+    {
+        TaskClock::time_point start = TaskClock::now();
+        task();
+        if (m_state->stats)
+            m_state->stats->Record(0, ElapsedUs(start, TaskClock::now()));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_state->lock);
+        State::Entry entry;
+        entry.task = std::move(task);
+        entry.queuedAt = TaskClock::now();
+        m_state->queue.push_back(std::move(entry));
+        ++m_state->remaining;
+    }
+    m_pool->Post(m_state);
+}
+
+void TaskGroup::wait()
+{
+    // Help the workers with our own tasks first
+    while (m_state->RunOne())
+        ;
+
+    std::unique_lock<std::mutex> lock(m_state->lock);
+    m_state->finished.wait(lock, [this] { return m_state->remaining == 0; });
+}
+
+ThreadPool::ThreadPool(size_t threads, ThreadHook onThreadStart, ThreadHook onThreadExit) :
+    m_onThreadStart(onThreadStart), m_onThreadExit(onThreadExit), m_queued(0), m_threadsCount(0), m_stop(false)
+{
+    Grow(threads);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_sleepLock);
+        m_stop = true;
+    }
+    m_wakeUp.notify_all();
+
+    std::lock_guard<std::mutex> guard(m_threadsLock);
+    for (std::thread& thread : m_threads)
+        thread.join();
+}
+
+void ThreadPool::Grow(size_t threads)
+{
+    if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+
+    std::lock_guard<std::mutex> guard(m_threadsLock);
+    for (size_t i = m_threads.size(); i < threads; ++i)
+    {
+        m_threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+        m_threadsCount = m_threads.size();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t chunks, std::function<void(size_t, size_t)> const& body, TaskPhaseStats* stats)
+{
+    if (!count)
+        return;
+    if (chunks > count)
+        chunks = count;
+    if (!chunks)
+        chunks = 1;
+
+    TaskGroup group(this, stats);
+    size_t const step = count / chunks;
+    size_t begin = 0;
+    for (size_t i = 0; i < chunks; ++i)
+    {
+        size_t const end = (i == chunks - 1) ? count : begin + step;
+        group.run([&body, begin, end]() { body(begin, end); });
+        begin = end;
+    }
+    group.wait();
+}
+
+void ThreadPool::Post(Ticket const& ticket)
+{
+    WorkQueue& queue = s_currentPool == this ? m_queues[s_currentIndex] : m_queues[MAX_THREADS];
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.tickets.push_back(ticket);
+    }
+    ++m_queued;
+
+    // Taking the lock ensures a worker about to sleep sees the new ticket
+    {
+        std::lock_guard<std::mutex> guard(m_sleepLock);
+    }
+    m_wakeUp.notify_one();
+}
+
+bool ThreadPool::PopTicket(size_t index, Ticket& ticket)
+{
+    // Most recent work of our own first, it is the hottest in cache
+    {
+        WorkQueue& own = m_queues[index];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tickets.empty())
+        {
+            ticket = std::move(own.tickets.back());
+            own.tickets.pop_back();
+            --m_queued;
+            return true;
+        }
+    }
+
+    {
+        WorkQueue& shared = m_queues[MAX_THREADS];
+        std::lock_guard<std::mutex> guard(shared.lock);
+        if (!shared.tickets.empty())
+        {
+            ticket = std::move(shared.tickets.front());
+            shared.tickets.pop_front();
+            --m_queued;
+            return true;
+        }
+    }
+
+    return StealTicket(index, ticket);
+}
+
+bool ThreadPool::StealTicket(size_t index, Ticket& ticket)
+{
+    size_t const count = m_threadsCount;
+    for (size_t i = 1; i < count; ++i)
+    {
+        WorkQueue& victim = m_queues[(index + i) % count];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tickets.empty())
+        {
+            ticket = std::move(victim.tickets.front());
+            victim.tickets.pop_front();
+            --m_queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop(size_t index)
+{
+    s_currentPool = this;
+    s_currentIndex = index;
+
+    if (m_onThreadStart)
+        m_onThreadStart();
+
+    Ticket ticket;
+    while (!m_stop)
+    {
+        if (PopTicket(index, ticket))
+        {
+            // The group may already have been completed by its waiter
+            ticket->RunOne();
+            ticket.reset();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepLock);
+        m_wakeUp.wait(lock, [this] { return m_stop || m_queued > 0; });
+    }
+
+    if (m_onThreadExit)
+        m_onThreadExit();
+
+    s_currentPool = nullptr;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2005-2011 MaNGOS <http://getmangos.com/>
+ * Copyright (C) 2009-2011 MaNGOSZero <https://github.com/mangos/zero>
+ * Copyright (C) 2011-2016 Nostalrius <https://nostalrius.org>
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_THREADPOOL_H
+#define MANGOS_THREADPOOL_H
+
+#include "Platform/Define.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * Accumulated timings of one kind of work submitted to the pool.
+ * Queue time is measured from submission until a thread picks the task,
+ * execution time from there until the task returns.
+ */
+struct TaskPhaseStats
+{
+    TaskPhaseStats() { Reset(); }
+
+    void Record(uint64 queueUs, uint64 execUs);
+    void Reset();
+
+    std::atomic<uint64> tasks;
+    std::atomic<uint64> queueTimeUs;
+    std::atomic<uint64> execTimeUs;
+    std::atomic<uint64> maxQueueTimeUs;
+    std::atomic<uint64> maxExecTimeUs;
+};
+
+/**
+ * Fork/join helper. Tasks given to run() are executed by the pool workers,
+ * wait() blocks until all of them are done. The waiting thread executes
+ * the tasks of this group that no worker has picked yet, and only those:
+ * a long blocking task submitted elsewhere is never run from inside wait().
+ * Without pool, tasks are executed directly by run().
+ */
+class TaskGroup
+{
+    public:
+        typedef std::function<void()> Task;
+
+        explicit TaskGroup(ThreadPool* pool, TaskPhaseStats* stats = nullptr);
+        ~TaskGroup() { wait(); }
+
+        void run(Task task);
+        void wait();
+
+        struct State;
+
+    private:
+        TaskGroup(TaskGroup const&);
+        TaskGroup& operator=(TaskGroup const&);
+
+        ThreadPool* m_pool;
+        std::shared_ptr<State> m_state;
+};
+
+/**
+ * Long-lived pool of worker threads.
+ * Each worker owns a queue: tasks submitted from a worker go to its own queue
+ * and are picked back in LIFO order, idle workers steal from the front of the
+ * other queues. Tasks submitted from outside of the pool go to a shared queue.
+ */
+class ThreadPool
+{
+    friend class TaskGroup;
+
+    public:
+        typedef std::function<void()> ThreadHook;
+
+        static size_t const MAX_THREADS = 128;
+
+        ThreadPool(size_t threads, ThreadHook onThreadStart = nullptr, ThreadHook onThreadExit = nullptr);
+        ~ThreadPool();
+
+        // Starts more workers if the pool has less than 'threads'. Never shrinks.
+        void Grow(size_t threads);
+        size_t GetThreadsCount() const { return m_threadsCount; }
+        size_t GetQueuedCount() const { return m_queued; }
+
+        // Splits [0, count) in 'chunks' ranges and calls body(begin, end) for each of them in parallel
+        void ParallelFor(size_t count, size_t chunks, std::function<void(size_t, size_t)> const& body, TaskPhaseStats* stats = nullptr);
+
+    private:
+        typedef std::shared_ptr<TaskGroup::State> Ticket;
+
+        struct WorkQueue
+        {
+            std::mutex lock;
+            std::deque<Ticket> tickets;
+        };
+
+        void Post(Ticket const& ticket);
+        bool PopTicket(size_t index, Ticket& ticket);
+        bool StealTicket(size_t index, Ticket& ticket);
+        void WorkerLoop(size_t index);
+
+        ThreadHook m_onThreadStart;
+        ThreadHook m_onThreadExit;
+
+        // One queue per possible worker, the last one receives tasks posted from outside of the pool
+        WorkQueue m_queues[MAX_THREADS + 1];
+        std::atomic<size_t> m_queued;
+        std::atomic<size_t> m_threadsCount;
+        std::atomic<bool> m_stop;
+
+        std::mutex m_sleepLock;
+        std::condition_variable m_wakeUp;
+
+        std::mutex m_threadsLock;
+        std::vector<std::thread> m_threads;
+};
+
+#endif
@@ -24,9 +24,12 @@
 
 #include "Common.h"
 #include "ByteBuffer.h"
+#include "PacketBufferPool.h"
+#include <memory>
 
 // Note: m_opcode and size stored in platfom dependent format
 // ignore endianess until send, and converted at receive
+// Storage comes from and goes back to PacketBufferPool.
 class WorldPacket : public ByteBuffer
 {
     public:
@@ -34,18 +37,36 @@ class WorldPacket : public ByteBuffer
         WorldPacket()                                       : ByteBuffer(0), m_opcode(0), m_recvdTime(0)
         {
         }
-        explicit WorldPacket(uint16 opcode, size_t res=200) : ByteBuffer(res), m_opcode(opcode), m_recvdTime(0) { }
+        explicit WorldPacket(uint16 opcode, size_t res=200) : ByteBuffer(0), m_opcode(opcode), m_recvdTime(0)
+        {
+            PacketBufferPool::Acquire(_storage, res);
+        }
                                                             // copy constructor
-        WorldPacket(const WorldPacket &packet)              : ByteBuffer(packet), m_opcode(packet.m_opcode), m_recvdTime(0)
+        WorldPacket(const WorldPacket &packet)              : ByteBuffer(0), m_opcode(packet.m_opcode), m_recvdTime(0)
         {
+            if (!packet._storage.empty())
+            {
+                PacketBufferPool::Acquire(_storage, packet._storage.size());
+                _storage.assign(packet._storage.begin(), packet._storage.end());
+            }
+            _rpos = packet._rpos;
+            _wpos = packet._wpos;
         }
 
         WorldPacket(WorldPacket &&packet) : ByteBuffer(std::move(packet)), m_opcode(packet.m_opcode), m_recvdTime(packet.m_recvdTime)
         {
         }
 
+        ~WorldPacket()
+        {
+            PacketBufferPool::Release(_storage);
+        }
+
         WorldPacket& operator=(WorldPacket &&rhs)
         {
+            if (this == &rhs)
+                return *this;
+            PacketBufferPool::Release(_storage);
             m_opcode = rhs.m_opcode;
             m_recvdTime = rhs.m_recvdTime;
             ByteBuffer::operator=(std::move(rhs));
@@ -55,7 +76,10 @@ class WorldPacket : public ByteBuffer
         void Initialize(uint16 opcode, size_t newres=200)
         {
             clear();
-            _storage.reserve(newres);
+            if (!_storage.capacity())
+                PacketBufferPool::Acquire(_storage, newres);
+            else
+                _storage.reserve(newres);
             m_opcode = opcode;
         }
 
@@ -69,4 +93,7 @@ class WorldPacket : public ByteBuffer
         uint16 m_opcode;
         uint32 m_recvdTime;
 };
+
+// Immutable packet shared by all the sockets it is sent to
+typedef std::shared_ptr<WorldPacket const> SharedWorldPacket;
 #endif